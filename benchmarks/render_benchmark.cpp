@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "helpers/helpers.h"
+
+#include "tpp-lib/null_pty.h"
+#include "tpp-lib/pty_capture.h"
+#include "ui-terminal/ansi_terminal.h"
+
+#include "terminalpp/config.h"
+#include "terminalpp/headless/headless_application.h"
+#include "terminalpp/headless/headless_window.h"
+
+/** Rendering benchmark.
+
+    Replays recorded PTY captures to a terminal attached to the headless renderer, which draws the cells into an in-memory framebuffer, and reports the time spent rendering each frame and the number of glyph runs drawn and cells visited per frame. See README.md for details.
+ */
+
+using namespace ui;
+using namespace tpp;
+
+namespace {
+
+    /** Terminal that exposes its input processing.
+     */
+    class BenchmarkTerminal : public AnsiTerminal {
+    public:
+        BenchmarkTerminal():
+            AnsiTerminal{new tpp::NullPTYMaster{}, Palette::XTerm256()} {
+        }
+
+        void feed(std::string & input) {
+            char * x = & input[0];
+            char * end = x + input.size();
+            while (x != end) {
+                size_t processed = received(x, end);
+                if (processed == 0)
+                    break;
+                x += processed;
+            }
+        }
+    }; // BenchmarkTerminal
+
+    /** Recorded capture split into frames.
+
+        Chunks recorded within the same frame interval are fed to the terminal together before the frame is rendered, similar to what the frame scheduler would do when rendering at given fps.
+     */
+    class Capture {
+    public:
+        Capture(std::string const & filename, unsigned fps):
+            name{filename} {
+            std::vector<PTYCapture::Chunk> chunks = PTYCapture::Load(filename);
+            std::chrono::microseconds frameTime{fps == 0 ? 0 : 1000000 / fps};
+            std::chrono::microseconds frameEnd{-1};
+            for (PTYCapture::Chunk & chunk : chunks) {
+                if (frameTime.count() == 0 || chunk.time > frameEnd) {
+                    frames.push_back(std::string{});
+                    frameEnd = chunk.time + frameTime;
+                }
+                frames.back().append(chunk.data);
+            }
+        }
+
+        std::string name;
+        std::vector<std::string> frames;
+    }; // Capture
+
+    /** Times of the rendered frames and the work done by the renderer.
+     */
+    class Result {
+    public:
+        std::vector<double> frameTimes;
+        size_t glyphRuns = 0;
+        size_t cells = 0;
+
+        double percentile(double p) const {
+            if (frameTimes.empty())
+                return 0;
+            size_t i = static_cast<size_t>(p * (frameTimes.size() - 1) + 0.5);
+            return frameTimes[i];
+        }
+
+        double average() const {
+            if (frameTimes.empty())
+                return 0;
+            double sum = 0;
+            for (double t : frameTimes)
+                sum += t;
+            return sum / frameTimes.size();
+        }
+    }; // Result
+
+    /** Replays the capture to a new terminal in a new headless window and measures each rendered frame.
+     */
+    Result Replay(Capture & capture, int cols, int rows, std::string const & dump) {
+        HeadlessApplication * app = HeadlessApplication::Instance();
+        HeadlessWindow * window = dynamic_cast<HeadlessWindow *>(app->createWindow("render-benchmark", cols, rows));
+        BenchmarkTerminal * terminal = new BenchmarkTerminal{};
+        window->setRoot(terminal);
+        window->setKeyboardFocus(terminal);
+        window->show();
+        app->mainLoop();
+        FrameStats const & stats = window->frameStats();
+        FrameStats::Frame start = stats.total();
+        Result result;
+        for (std::string & frame : capture.frames) {
+            size_t frames = stats.frames();
+            std::chrono::steady_clock::duration renderTime = stats.total().renderTime;
+            terminal->feed(frame);
+            app->mainLoop();
+            if (stats.frames() == frames)
+                continue;
+            std::chrono::duration<double, std::milli> elapsed = stats.total().renderTime - renderTime;
+            result.frameTimes.push_back(elapsed.count());
+        }
+        result.glyphRuns = stats.total().glyphRuns - start.glyphRuns;
+        result.cells = stats.total().cells - start.cells;
+        if (! dump.empty()) {
+            // the premultiplied pixels are the colors composed over black
+            std::ofstream f{dump, std::ios::binary};
+            f << "P6\n" << window->sizePx().width() << " " << window->sizePx().height() << "\n255\n";
+            for (uint32_t p : window->pixels()) {
+                f.put(static_cast<char>((p >> 16) & 0xff));
+                f.put(static_cast<char>((p >> 8) & 0xff));
+                f.put(static_cast<char>(p & 0xff));
+            }
+        }
+        window->setRoot(nullptr);
+        delete terminal;
+        delete window;
+        return result;
+    }
+
+    void PrintUsage() {
+        std::cout << "Usage: render-benchmark [options] capture..." << std::endl << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "    --iterations N    number of replays of each capture (default 3)" << std::endl;
+        std::cout << "    --cols N          terminal width (default 120)" << std::endl;
+        std::cout << "    --rows N          terminal height (default 40)" << std::endl;
+        std::cout << "    --fps N           frame rate at which the capture is split into frames, 0 renders every chunk (default 60)" << std::endl;
+        std::cout << "    --font FAMILY     font family (default Monospace)" << std::endl;
+        std::cout << "    --font-size PX    font size in pixels (default 18)" << std::endl;
+        std::cout << "    --dump FILE       writes the last frame of the last capture as a PPM image" << std::endl << std::endl;
+        std::cout << "Captures are files recorded with --capture-pty, or raw terminal output." << std::endl;
+    }
+
+    std::string StringArgument(int & i, int argc, char * argv[]) {
+        if (++i == argc) {
+            PrintUsage();
+            exit(EXIT_FAILURE);
+        }
+        return argv[i];
+    }
+
+    int Argument(int & i, int argc, char * argv[], int min = 1) {
+        int result = std::atoi(StringArgument(i, argc, argv).c_str());
+        if (result < min) {
+            PrintUsage();
+            exit(EXIT_FAILURE);
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char * argv[]) {
+    int iterations = 3;
+    int cols = 120;
+    int rows = 40;
+    unsigned fps = 60;
+    std::string font{"Monospace"};
+    int fontSize = 18;
+    std::string dump;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        if (arg == "--iterations") {
+            iterations = Argument(i, argc, argv);
+        } else if (arg == "--cols") {
+            cols = Argument(i, argc, argv);
+        } else if (arg == "--rows") {
+            rows = Argument(i, argc, argv);
+        } else if (arg == "--fps") {
+            fps = static_cast<unsigned>(Argument(i, argc, argv, 0));
+        } else if (arg == "--font") {
+            font = StringArgument(i, argc, argv);
+        } else if (arg == "--font-size") {
+            fontSize = Argument(i, argc, argv);
+        } else if (arg == "--dump") {
+            dump = StringArgument(i, argc, argv);
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return EXIT_SUCCESS;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+    try {
+        // the font families are set explicitly so that the defaults do not have to be detected
+        JSON fontConfig = JSON::Object();
+        fontConfig.add("family", JSON{font});
+        fontConfig.add("doubleWidthFamily", JSON{font});
+        fontConfig.add("size", JSON{fontSize});
+        JSON rendererConfig = JSON::Object();
+        rendererConfig.add("font", std::move(fontConfig));
+        JSON config = JSON::Object();
+        config.add("renderer", std::move(rendererConfig));
+        Config::Instance().set(config);
+        HeadlessApplication::Initialize();
+        std::vector<Capture> captures;
+        for (std::string const & filename : files)
+            captures.push_back(Capture{filename, fps});
+        std::cout << "terminal " << cols << "x" << rows << ", " << font << " " << fontSize << "px, " << iterations << " iterations, " << fps << " fps" << std::endl << std::endl;
+        std::cout << std::left << std::setw(24) << "capture" << std::right << std::setw(8) << "frames" << std::setw(10) << "avg ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms" << std::setw(10) << "max ms" << std::setw(12) << "runs/frame" << std::setw(14) << "cells/frame" << std::endl;
+        for (Capture & c : captures) {
+            Result total;
+            for (int i = 0; i < iterations; ++i) {
+                bool last = (i == iterations - 1) && (& c == & captures.back());
+                Result r = Replay(c, cols, rows, last ? dump : std::string{});
+                total.frameTimes.insert(total.frameTimes.end(), r.frameTimes.begin(), r.frameTimes.end());
+                total.glyphRuns += r.glyphRuns;
+                total.cells += r.cells;
+            }
+            std::sort(total.frameTimes.begin(), total.frameTimes.end());
+            double frames = static_cast<double>(std::max(total.frameTimes.size(), static_cast<size_t>(1)));
+            std::cout << std::left << std::setw(24) << c.name << std::right << std::fixed
+                << std::setw(8) << (total.frameTimes.size() / iterations)
+                << std::setw(10) << std::setprecision(3) << total.average()
+                << std::setw(10) << std::setprecision(3) << total.percentile(0.5)
+                << std::setw(10) << std::setprecision(3) << total.percentile(0.95)
+                << std::setw(10) << std::setprecision(3) << (total.frameTimes.empty() ? 0 : total.frameTimes.back())
+                << std::setw(12) << std::setprecision(1) << (total.glyphRuns / frames)
+                << std::setw(14) << std::setprecision(1) << (total.cells / frames) << std::endl;
+        }
+    } catch (std::exception const & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "helpers/helpers.h"
+#include "helpers/char.h"
+
+#include "tpp-lib/null_pty.h"
+#include "ui-terminal/ansi_terminal.h"
+
+/** VT parser throughput benchmark.
+
+    Feeds synthetic, but deterministic corpora directly to AnsiTerminal::received() without any renderer or window attached and reports the throughput in MB/s and control functions (escape sequences and control characters) per second. See README.md for details.
+ */
+
+using namespace ui;
+
+namespace {
+
+    /** Terminal with no renderer that exposes its input processing.
+     */
+    class BenchmarkTerminal : public AnsiTerminal {
+    public:
+        BenchmarkTerminal(int cols, int rows):
+            AnsiTerminal{new tpp::NullPTYMaster{}, Palette::XTerm256()} {
+            setHistoryLimit(16 * 1024 * 1024);
+            resize(Size{cols, rows});
+        }
+
+        /** Feeds the input to the terminal in chunks of given size, similar to what the PTY reader would do.
+         */
+        void feed(std::string & input, size_t chunkSize) {
+            char * x = & input[0];
+            char * end = x + input.size();
+            while (x != end) {
+                char * chunkEnd = x + std::min(chunkSize, static_cast<size_t>(end - x));
+                size_t processed = received(x, chunkEnd);
+                if (processed == 0)
+                    break;
+                x += processed;
+            }
+        }
+    }; // BenchmarkTerminal
+
+    /** Benchmark corpus.
+     */
+    class Corpus {
+    public:
+        std::string name;
+        std::string description;
+        std::string data;
+        size_t controlFunctions = 0;
+    }; // Corpus
+
+    class Generator {
+    public:
+        Generator(int cols, int rows, size_t size):
+            cols_{cols},
+            rows_{rows},
+            size_{size},
+            rng_{42} {
+        }
+
+        Corpus cat() {
+            while (needMore()) {
+                for (int i = 0, e = number(0, cols_ + cols_ / 2); i < e; ++i)
+                    s_ << letter();
+                s_ << "\r\n";
+            }
+            return corpus("cat", "plain ASCII text lines");
+        }
+
+        Corpus sgr() {
+            while (needMore()) {
+                for (int i = 0, e = number(1, 12); i < e; ++i) {
+                    switch (number(0, 4)) {
+                        case 0:
+                            s_ << "\033[38;5;" << number(0, 255) << "m";
+                            break;
+                        case 1:
+                            s_ << "\033[48;2;" << number(0, 255) << ";" << number(0, 255) << ";" << number(0, 255) << "m";
+                            break;
+                        case 2:
+                            s_ << "\033[" << number(1, 9) << "m";
+                            break;
+                        case 3:
+                            s_ << "\033[" << number(30, 37) << ";" << number(40, 47) << "m";
+                            break;
+                        default:
+                            s_ << "\033[0m";
+                            break;
+                    }
+                    word();
+                    s_ << ' ';
+                }
+                s_ << "\033[0m\r\n";
+            }
+            return corpus("sgr", "words with dense SGR color and attribute changes");
+        }
+
+        Corpus tui() {
+            s_ << "\033[?1049h\033[?25l";
+            while (needMore()) {
+                if (number(0, 9) == 0)
+                    s_ << "\033[2J";
+                for (int row = 1; row <= rows_; ++row) {
+                    s_ << "\033[" << row << ";1H\033[38;5;" << number(0, 255) << ";48;5;" << number(0, 255) << "m";
+                    for (int col = 0, e = number(cols_ / 2, cols_); col < e; ++col)
+                        s_ << letter();
+                    s_ << "\033[0m\033[K";
+                }
+                s_ << "\033[H";
+            }
+            s_ << "\033[?25h\033[?1049l";
+            return corpus("tui", "full-screen redraws in alternate mode");
+        }
+
+        Corpus unicode() {
+            while (needMore()) {
+                for (int i = 0, e = number(0, cols_ / 2); i < e; ++i) {
+                    switch (number(0, 3)) {
+                        case 0:
+                            s_ << letter();
+                            break;
+                        case 1:
+                        case 2:
+                            s_ << Char{static_cast<char32_t>(number(0x4e00, 0x9fff))};
+                            break;
+                        default:
+                            s_ << Char{static_cast<char32_t>(number(0x1f600, 0x1f64f))};
+                            break;
+                    }
+                }
+                s_ << "\r\n";
+            }
+            return corpus("unicode", "CJK and emoji text");
+        }
+
+        Corpus scroll() {
+            int top = std::min(5, rows_ / 4) + 1;
+            int bottom = rows_ - top + 1;
+            while (needMore()) {
+                s_ << "\033[" << top << ";" << bottom << "r\033[" << bottom << ";1H";
+                for (int i = 0, e = number(1, rows_); i < e; ++i) {
+                    word();
+                    s_ << "\r\n";
+                }
+                switch (number(0, 2)) {
+                    case 0:
+                        s_ << "\033[" << number(top, bottom) << ";1H\033[" << number(1, 3) << "L";
+                        break;
+                    case 1:
+                        s_ << "\033[" << number(top, bottom) << ";1H\033[" << number(1, 3) << "M";
+                        break;
+                    default:
+                        s_ << "\033[" << top << ";1H";
+                        for (int i = 0, e = number(1, 5); i < e; ++i)
+                            s_ << "\033M";
+                        break;
+                }
+                s_ << "\033[r";
+            }
+            return corpus("scroll", "scroll region changes, line insertions and deletions");
+        }
+
+        Corpus longLines() {
+            while (needMore()) {
+                for (int i = 0, e = number(cols_ * 50, cols_ * 200); i < e; ++i)
+                    s_ << letter();
+                s_ << "\r\n";
+            }
+            return corpus("long-lines", "lines much longer than the terminal width");
+        }
+
+    private:
+
+        /** Returns true while the generated corpus is smaller than the requested size. 
+         */
+        bool needMore() {
+            return static_cast<size_t>(s_.tellp()) < size_;
+        }
+
+        int number(int from, int to) {
+            return std::uniform_int_distribution<int>{from, to}(rng_);
+        }
+
+        char letter() {
+            int x = number(0, 31);
+            return x < 26 ? static_cast<char>('a' + x) : ' ';
+        }
+
+        void word() {
+            for (int i = 0, e = number(1, 10); i < e; ++i)
+                s_ << static_cast<char>('a' + number(0, 25));
+        }
+
+        Corpus corpus(char const * name, char const * description) {
+            Corpus result;
+            result.name = name;
+            result.description = description;
+            result.data = s_.str();
+            for (char c : result.data)
+                if (c >= 0 && c < 0x20)
+                    ++result.controlFunctions;
+            s_.str("");
+            s_.clear();
+            return result;
+        }
+
+        int cols_;
+        int rows_;
+        size_t size_;
+        std::mt19937 rng_;
+        std::stringstream s_;
+    }; // Generator
+
+    void PrintUsage() {
+        std::cout << "Usage: vt-benchmark [options] [corpus...]" << std::endl << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "    --size MB         size of each corpus (default 16)" << std::endl;
+        std::cout << "    --iterations N    number of runs of each corpus, best is reported (default 3)" << std::endl;
+        std::cout << "    --cols N          terminal width (default 120)" << std::endl;
+        std::cout << "    --rows N          terminal height (default 40)" << std::endl;
+        std::cout << "    --chunk KB        size of the input chunks fed to the terminal (default 64)" << std::endl << std::endl;
+        std::cout << "Corpora: cat, sgr, tui, unicode, scroll, long-lines (default all)" << std::endl;
+    }
+
+    int Argument(int & i, int argc, char * argv[]) {
+        if (++i == argc) {
+            PrintUsage();
+            exit(EXIT_FAILURE);
+        }
+        int result = std::atoi(argv[i]);
+        if (result <= 0) {
+            PrintUsage();
+            exit(EXIT_FAILURE);
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char * argv[]) {
+    size_t size = 16;
+    int iterations = 3;
+    int cols = 120;
+    int rows = 40;
+    size_t chunk = 64;
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        if (arg == "--size") {
+            size = Argument(i, argc, argv);
+        } else if (arg == "--iterations") {
+            iterations = Argument(i, argc, argv);
+        } else if (arg == "--cols") {
+            cols = Argument(i, argc, argv);
+        } else if (arg == "--rows") {
+            rows = Argument(i, argc, argv);
+        } else if (arg == "--chunk") {
+            chunk = Argument(i, argc, argv);
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return EXIT_SUCCESS;
+        } else {
+            selected.push_back(arg);
+        }
+    }
+    Generator g{cols, rows, size * 1024 * 1024};
+    std::vector<Corpus> corpora;
+    corpora.push_back(g.cat());
+    corpora.push_back(g.sgr());
+    corpora.push_back(g.tui());
+    corpora.push_back(g.unicode());
+    corpora.push_back(g.scroll());
+    corpora.push_back(g.longLines());
+    for (std::string const & name : selected) {
+        if (std::find_if(corpora.begin(), corpora.end(), [& name](Corpus const & c) { return c.name == name; }) == corpora.end()) {
+            std::cerr << "Unknown corpus " << name << std::endl;
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << "terminal " << cols << "x" << rows << ", " << iterations << " iterations, " << chunk << "KB chunks" << std::endl << std::endl;
+    std::cout << std::left << std::setw(12) << "corpus" << std::right << std::setw(10) << "MB" << std::setw(12) << "seconds" << std::setw(12) << "MB/s" << std::setw(22) << "control functions/s" << std::endl;
+    for (Corpus & c : corpora) {
+        if (! selected.empty() && std::find(selected.begin(), selected.end(), c.name) == selected.end())
+            continue;
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < iterations; ++i) {
+            BenchmarkTerminal t{cols, rows};
+            auto start = std::chrono::steady_clock::now();
+            t.feed(c.data, chunk * 1024);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        double mb = static_cast<double>(c.data.size()) / (1024 * 1024);
+        std::cout << std::left << std::setw(12) << c.name << std::right << std::fixed
+            << std::setw(10) << std::setprecision(1) << mb
+            << std::setw(12) << std::setprecision(3) << best
+            << std::setw(12) << std::setprecision(1) << (mb / best)
+            << std::setw(22) << std::setprecision(0) << (c.controlFunctions / best) << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
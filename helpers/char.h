@@ -219,6 +219,8 @@ HELPERS_NAMESPACE_BEGIN
 		static constexpr char TAB = 9;
 		static constexpr char LF = 10;
 		static constexpr char CR = 13;
+		static constexpr char CAN = 24;
+		static constexpr char SUB = 26;
 		static constexpr char ESC = 27;
 
 		Char(char c = ' ') :
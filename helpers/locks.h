@@ -51,6 +51,18 @@ HELPERS_NAMESPACE_BEGIN
             m_.unlock();
         }
 
+        /** Temporarily releases the lock if there are any priority lock requests waiting and grabs it again in non-priority mode after they have been serviced. 
+         
+            Can be used by long running non-priority holders of the lock to bound the time the priority requests have to wait. Returns true if the lock has been released. 
+         */
+        bool yieldToPriority() {
+            if (priorityRequests_ == 0)
+                return false;
+            unlock();
+            lock();
+            return true;
+        }
+
 #ifndef NDEBUG
         bool locked() const {
             return locked_ == std::this_thread::get_id();
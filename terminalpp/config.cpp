@@ -21,6 +21,7 @@ namespace tpp {
 					try {
 						JSON settings{JSON::Parse(f)};
 						VerifyConfigurationVersion(settings);
+						saveSettings = MigrateSettings(settings);
 						// specify, check errors, make copy if wrong
 						saveSettings = config.update(settings, [& saveSettings, & filename](JSONError && e){
 							Application::Instance()->alert(STR(e.what() << " while parsing terminalpp settings at " << filename));
@@ -97,6 +98,28 @@ namespace tpp {
         userConfig.erase("version");
 	}
 
+    /** The history limit used to be given in lines (renderer.window.historyLimit), it is now given in megabytes (renderer.window.historyMemoryLimit). The old default of 10000 lines is dropped so that the new default is used, other line counts are converted to an estimate of the memory they would occupy, rounded up to whole megabytes, i.e. 0 keeps the history disabled. If both settings are present, the new one wins. 
+     */
+    bool Config::MigrateSettings(JSON & userConfig) {
+        if (userConfig.kind() != JSON::Kind::Object || ! userConfig.hasKey("renderer"))
+            return false;
+        JSON & renderer = userConfig["renderer"];
+        if (renderer.kind() != JSON::Kind::Object || ! renderer.hasKey("window"))
+            return false;
+        JSON & window = renderer["window"];
+        if (window.kind() != JSON::Kind::Object || ! window.hasKey("historyLimit"))
+            return false;
+        JSON const & lines = window["historyLimit"];
+        if (! window.hasKey("historyMemoryLimit") && lines.kind() == JSON::Kind::Integer && lines.toInt() >= 0 && lines.toInt() != 10000) {
+            // a history row of a terminal of usual width with a few style changes takes a bit over 100 bytes, twice as much is assumed so that wider rows fit as well
+            size_t bytes = static_cast<size_t>(lines.toInt()) * 256;
+            size_t megabytes = (bytes + 1024 * 1024 - 1) / (1024 * 1024);
+            window.add("historyMemoryLimit", JSON{static_cast<int>(megabytes)});
+        }
+        window.erase("historyLimit");
+        return true;
+    }
+
     /** First determine if session list should be checked at all times (application.detectSessionsAtStartup), or sessions not present in the JSON (in which case we add them as an empty list). 
      
         If above true, then update the list with autodetected sessions. 
@@ -46,6 +46,7 @@ constexpr size_t DEFAULT_BLINK_SPEED = 500;
 #define SHORTCUT_FULLSCREEN (Key::Enter + Key::Alt)
 #define SHORTCUT_ABOUT (Key::F1 + Key::Alt)
 #define SHORTCUT_SETTINGS (Key::F10 + Key::Alt)
+#define SHORTCUT_FRAME_STATS (Key::F12 + Key::Alt)
 #define SHORTCUT_ZOOM_IN (Key::Equals + Key::Ctrl)
 #define SHORTCUT_ZOOM_OUT (Key::Minus + Key::Ctrl)
 // alternate zoom shortcuts like in browsers
@@ -263,6 +264,12 @@ namespace tpp {
                 JSON::Array(),
                 std::vector<std::reference_wrapper<Log>>
             );
+            CONFIG_PROPERTY(
+                capturePty,
+                "If true, data received from the pseudoterminal of each session are recorded with their timing to a capture file in the telemetry directory. The capture can be played back by a session with the replay pty",
+                JSON{false},
+                bool
+            );
         );
         CONFIG_OBJECT(
             renderer,
@@ -406,10 +413,10 @@ namespace tpp {
                     bool
                 );
                 CONFIG_PROPERTY(
-                    historyLimit,
-                    "Determines the maximum number of lines the terminal will remember in the history of the buffer. If set to 0, terminal history is disabled.",
-                    JSON{10000},
-                    int
+                    historyMemoryLimit,
+                    "Determines the maximum memory in megabytes the terminal history may occupy. When exceeded, the oldest lines are forgotten. If set to 0, terminal history is disabled.",
+                    JSON{16},
+                    unsigned
                 );
             );
         );
@@ -474,7 +481,7 @@ namespace tpp {
             "Default values for session properties. These will be used when a session does not override the values",
 			CONFIG_PROPERTY(
 				pty,
-				"Determines whether local, or bypass PTY should be used. Useful only for Windows, ignored on other systems.",
+				"Determines whether local, or bypass PTY should be used (bypass is useful only for Windows, ignored on other systems). The replay and replay-fast values play back the PTY capture file given as command with original timing, or as fast as possible respectively.",
 				JSON{"local"},
 			    std::string
 			);
@@ -574,7 +581,7 @@ namespace tpp {
             );
 			CONFIG_PROPERTY(
 				pty,
-				"Determines whether local, or bypass PTY should be used. Useful only for Windows, ignored on other systems.",
+				"Determines whether local, or bypass PTY should be used (bypass is useful only for Windows, ignored on other systems). The replay and replay-fast values play back the PTY capture file given as command with original timing, or as fast as possible respectively.",
 				JSON{"local"},
 			    std::string
 			);
@@ -725,6 +732,7 @@ namespace tpp {
             addArgument(renderer.font.size, {"--font-size"});
             addArgument(renderer.window.cols, {"--cols", "-c"});
             addArgument(renderer.window.rows, {"--rows", "-r"});
+            addArgument(telemetry.capturePty, {"--capture-pty"}, "true");
             //addArgument(application.useCwdForSessions, {"-cwd"}, "true");
             addArgument(defaultSession, {"--session"});
             // create new empty session that we use to store the pty and command arguments so that they are matched the same way
@@ -769,6 +777,12 @@ namespace tpp {
          */
         static void VerifyConfigurationVersion(JSON & userConfig);
 
+        /** Converts settings of older versions that have been renamed or replaced to their current form. 
+
+            Returns true if the settings were changed and should therefore be saved. 
+         */
+        static bool MigrateSettings(JSON & userConfig);
+
         /** Patches the sessions list with autodetected sessions.
          */
         bool patchSessions();
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "helpers/helpers.h"
+
+namespace tpp {
+
+    /** Glyph runs whose background, text and decorations are drawn together.
+
+        Instead of drawing each glyph run immediately, the renderer adds the run's background and decoration rectangles to per-color batches and its glyphs to the list of text runs. When flushed, all backgrounds are filled first, one batch per color, then the text runs are drawn in the order they were added and finally the decorations are filled, again one batch per color. This is only equivalent to drawing the runs one by one as long as no run covers pixels drawn by the runs before it. The runs of a frame are drawn row by row from left to right, so this holds unless a run starts before the end of the previous one, such as the cursor or the runs next to fonts taller than a single row, or a run overlaps decorations which extend past the cells of their run, such as an underline below the row. The batch detects both, see overlaps(), and the renderer must flush it before such runs. The glyphs are assumed to stay within their cells, glyphs overhanging into the cells of the next run are not erased by its background as they were when drawing the runs one by one.
+
+        The RECT must have x, y, width and height members and the renderer provides the COLOR, its unique id and the GLYPH specification it uses for drawing.
+     */
+    template<typename FONT, typename COLOR, typename GLYPH, typename RECT>
+    class DrawBatch {
+    public:
+
+        /** Rectangles of the same color filled at once.
+         */
+        class Fills {
+        public:
+            COLOR color;
+            std::vector<RECT> rects;
+        }; // tpp::DrawBatch::Fills
+
+        /** Glyph run whose text is drawn when the batch is flushed.
+
+            The glyphs of the run are stored in the batch starting at given index.
+         */
+        class TextRun {
+        public:
+            FONT * font;
+            COLOR color;
+            size_t start;
+            size_t size;
+        }; // tpp::DrawBatch::TextRun
+
+        bool empty() const {
+            return empty_;
+        }
+
+        /** Returns true if a glyph run covering the given rectangle cannot be added to the batch because it may cover the pixels of runs that were already added.
+         */
+        bool overlaps(int x, int y, int width, int height) const {
+            if (empty_)
+                return false;
+            // the run must be right of the last run in the same row, or below it
+            if (! ((y == run_.y && height == run_.height && x >= run_.x + run_.width) || y >= run_.y + run_.height))
+                return true;
+            for (RECT const & r : overhangs_)
+                if (Intersects(r, x, y, width, height))
+                    return true;
+            return false;
+        }
+
+        /** Starts a new glyph run covering given rectangle.
+
+            The run must not overlap the batch, see overlaps().
+         */
+        void addRun(int x, int y, int width, int height) {
+            ASSERT(! overlaps(x, y, width, height));
+            run_ = MakeRect(x, y, width, height);
+            empty_ = false;
+        }
+
+        /** Adds the background rectangle of the current run.
+         */
+        void addBackground(uint64_t colorId, COLOR const & color, int x, int y, int width, int height) {
+            AddFill(backgrounds_, colorId, color, MakeRect(x, y, width, height));
+        }
+
+        /** Adds the glyphs of the current run.
+         */
+        void addText(FONT * font, COLOR const & color, GLYPH const * glyphs, size_t size) {
+            textRuns_.push_back(TextRun{font, color, glyphs_.size(), size});
+            glyphs_.insert(glyphs_.end(), glyphs, glyphs + size);
+        }
+
+        /** Adds the decoration rectangle of the current run.
+
+            Decorations that extend past the cells of the run are remembered so that the runs they overlap are not batched with them.
+         */
+        void addDecoration(uint64_t colorId, COLOR const & color, int x, int y, int width, int height) {
+            RECT r = MakeRect(x, y, width, height);
+            AddFill(decorations_, colorId, color, r);
+            if (x < run_.x || y < run_.y || x + width > run_.x + run_.width || y + height > run_.y + run_.height)
+                overhangs_.push_back(r);
+        }
+
+        /** Draws the batched glyph runs and clears the batch.
+
+            Calls fill(color, rects, size) for each batch of the background and decoration rectangles and text(font, color, glyphs, size) for each text run. The fill batches are kept so that their memory can be reused unless there is more than MAX_FILL_BATCHES of them.
+         */
+        template<typename FILL, typename TEXT>
+        void flush(FILL fill, TEXT text) {
+            if (empty_)
+                return;
+            FlushFills(backgrounds_, fill);
+            for (TextRun const & run : textRuns_)
+                text(run.font, run.color, glyphs_.data() + run.start, run.size);
+            FlushFills(decorations_, fill);
+            textRuns_.clear();
+            glyphs_.clear();
+            overhangs_.clear();
+            empty_ = true;
+        }
+
+    private:
+
+        static constexpr size_t MAX_FILL_BATCHES = 256;
+
+        static RECT MakeRect(int x, int y, int width, int height) {
+            RECT result;
+            result.x = static_cast<decltype(result.x)>(x);
+            result.y = static_cast<decltype(result.y)>(y);
+            result.width = static_cast<decltype(result.width)>(width);
+            result.height = static_cast<decltype(result.height)>(height);
+            return result;
+        }
+
+        static bool Intersects(RECT const & r, int x, int y, int width, int height) {
+            return r.x < x + width && x < r.x + static_cast<int>(r.width) && r.y < y + height && y < r.y + static_cast<int>(r.height);
+        }
+
+        static void AddFill(std::unordered_map<uint64_t, Fills> & fills, uint64_t colorId, COLOR const & color, RECT const & rect) {
+            Fills & batch = fills[colorId];
+            batch.color = color;
+            batch.rects.push_back(rect);
+        }
+
+        template<typename FILL>
+        static void FlushFills(std::unordered_map<uint64_t, Fills> & fills, FILL & fill) {
+            for (auto & i : fills) {
+                Fills & batch = i.second;
+                if (batch.rects.empty())
+                    continue;
+                fill(batch.color, batch.rects.data(), batch.rects.size());
+                batch.rects.clear();
+            }
+            if (fills.size() > MAX_FILL_BATCHES)
+                fills.clear();
+        }
+
+        bool empty_ = true;
+        RECT run_;
+        std::unordered_map<uint64_t, Fills> backgrounds_;
+        std::unordered_map<uint64_t, Fills> decorations_;
+        std::vector<TextRun> textRuns_;
+        std::vector<GLYPH> glyphs_;
+        std::vector<RECT> overhangs_;
+
+    }; // tpp::DrawBatch
+
+} // namespace tpp
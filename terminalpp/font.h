@@ -88,6 +88,55 @@ namespace tpp {
 
     }; // tpp::FontMetrics
 
+    /** Cache of the glyphs of a font's codepoints. 
+
+        The glyphs of codepoints below LATIN1 are kept in a direct-mapped table, the glyphs of the other codepoints in a hash map. As the hash map is filled with whatever codepoints the terminal receives, it holds at most the given number of glyphs and is emptied when full so that its size is bounded. The glyphs in the table are never evicted. 
+
+        The GLYPH must have a `font` pointer member, which is nullptr for glyphs not cached yet. 
+     */
+    template<typename GLYPH>
+    class GlyphCache {
+    public:
+
+        static constexpr char32_t LATIN1 = 256;
+
+        static constexpr size_t DEFAULT_CAPACITY = 16384;
+
+        explicit GlyphCache(size_t capacity = DEFAULT_CAPACITY):
+            capacity_{capacity} {
+        }
+
+        /** Returns the glyph of given codepoint, calling the lookup function to determine it if it has not been cached yet. 
+         */
+        template<typename LOOKUP>
+        GLYPH get(char32_t codepoint, LOOKUP lookup) {
+            if (codepoint < LATIN1) {
+                GLYPH & result = latin1_[codepoint];
+                if (result.font == nullptr)
+                    result = lookup(codepoint);
+                return result;
+            }
+            auto i = glyphs_.find(codepoint);
+            if (i == glyphs_.end()) {
+                if (glyphs_.size() >= capacity_)
+                    glyphs_.clear();
+                i = glyphs_.insert(std::make_pair(codepoint, lookup(codepoint))).first;
+            }
+            return i->second;
+        }
+
+        /** Returns the number of glyphs cached in the hash map. 
+         */
+        size_t mapSize() const {
+            return glyphs_.size();
+        }
+
+    private:
+        size_t capacity_;
+        GLYPH latin1_[LATIN1];
+        std::unordered_map<char32_t, GLYPH> glyphs_;
+    }; // tpp::GlyphCache
+
     /** Base template for fonts used in the terminal window renderers. 
      
         Handles the mechanism for caching the already configured fonts in different sizes and their fallback alternatives for various characters
@@ -131,20 +180,16 @@ namespace tpp {
 
         /** Returns a font that provides fallback for given character codepoint.
 
-            Always returns a font, but if a suitable callback cannot be found, the returned font will not render the character properly.  
+            Always returns a font, but if a suitable fallback cannot be found, the font itself is returned and it will not render the character properly.  
+
+            The fallback font found for a codepoint is remembered, so that each codepoint is searched for only once. This includes codepoints not supported by any font, which would otherwise be searched for every time. 
          */
         T * fallbackFor(char32_t codepoint) {
-			std::vector<T*> & fallbackCache = FallbackFonts_[CreateIdFrom(font_, fontSize_.height())];
-            for (auto i : fallbackCache) {
-				if (i != this && i->supportsCodepoint(codepoint))
-                    return i;
-			}
-			// if the character we search the fallback for is double width increase the cell width now
-			//cellWidth *= Char::ColumnWidth(codepoint);
-            T * f = new T(*static_cast<T const *>(this), codepoint);
-            f->adjustCellSize();
-            fallbackCache.push_back(f);
-            return f;
+			FallbackCache & fallbackCache = FallbackFonts_[CreateIdFrom(font_, fontSize_.height())];
+            auto i = fallbackCache.codepoints.find(codepoint);
+            if (i == fallbackCache.codepoints.end())
+                i = fallbackCache.codepoints.insert(std::make_pair(codepoint, findFallbackFor(fallbackCache, codepoint))).first;
+            return i->second;
         }
 
     protected:
@@ -192,10 +237,36 @@ namespace tpp {
         }
 
     private:
+
+        /** Fallback fonts created for a font and the fallback fonts found for the codepoints. 
+         */
+        class FallbackCache {
+        public:
+            std::vector<T*> fonts;
+            std::unordered_map<char32_t, T*> codepoints;
+        }; // tpp::Font::FallbackCache
+
+        T * findFallbackFor(FallbackCache & fallbackCache, char32_t codepoint) {
+            for (auto i : fallbackCache.fonts) {
+				if (i != this && i->supportsCodepoint(codepoint))
+                    return i;
+			}
+			// if the character we search the fallback for is double width increase the cell width now
+			//cellWidth *= Char::ColumnWidth(codepoint);
+            T * f = new T(*static_cast<T const *>(this), codepoint);
+            // the font does not have to support the codepoint if there is none that does, in which case it is not kept so that it is not searched for other codepoints
+            if (! f->supportsCodepoint(codepoint)) {
+                delete f;
+                return static_cast<T *>(this);
+            }
+            f->adjustCellSize();
+            fallbackCache.fonts.push_back(f);
+            return f;
+        }
         
         static std::unordered_map<size_t, T *> Fonts_;
 
-		static std::unordered_map<size_t, std::vector<T*>> FallbackFonts_;
+		static std::unordered_map<size_t, FallbackCache> FallbackFonts_;
 
     }; 
 
@@ -203,6 +274,6 @@ namespace tpp {
     std::unordered_map<size_t, T *> Font<T>::Fonts_;
 
 	template<typename T>
-	std::unordered_map<size_t, std::vector<T*>> Font<T>::FallbackFonts_;
+	std::unordered_map<size_t, typename Font<T>::FallbackCache> Font<T>::FallbackFonts_;
 
 } // namespace tpp
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <iomanip>
+
+#include "ui-terminal/ansi_terminal.h"
+
+#include "../window.h"
+
+namespace tpp {
+
+    /** Overlay displaying the frame statistics of the window and the input processing statistics of the active terminal.
+
+        The overlay paints a box in the top right corner of the window so that the terminal beneath remains visible. For each of the frame metrics the value of the last frame and the average, 95th percentile and maximum of the last frames are displayed, followed by the histogram of the render times. The input processing is displayed as the throughput and the share of the time the terminal's reader spent processing the input since the last refresh, so that the time spent parsing, painting and rendering can be compared at a glance.
+
+        The overlay does not refresh itself, its owner should call refresh() periodically while the overlay is shown.
+     */
+    class FrameStatsOverlay : public tpp::Window::Overlay {
+    public:
+
+        /** Interval between refreshes of the overlay in milliseconds.
+         */
+        static constexpr size_t REFRESH_INTERVAL = 500;
+
+        static constexpr int WIDTH = 54;
+        static constexpr int HEIGHT = 12;
+
+        explicit FrameStatsOverlay(tpp::Window * window):
+            window_{window} {
+        }
+
+        AnsiTerminal * terminal() const {
+            return terminal_;
+        }
+
+        /** Sets the terminal whose input processing statistics are displayed, or nullptr if none.
+         */
+        void setTerminal(AnsiTerminal * terminal) {
+            terminal_ = terminal;
+            if (terminal_ != nullptr) {
+                lastReceivedBytes_ = terminal_->receivedBytes();
+                lastReceivedTime_ = terminal_->receivedTime();
+            }
+            parseRate_ = 0;
+            parseLoad_ = 0;
+            lastRefresh_ = std::chrono::steady_clock::now();
+        }
+
+        /** Samples the input processing statistics of the terminal and renders the overlay again.
+         */
+        void refresh() {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (terminal_ != nullptr) {
+                size_t bytes = terminal_->receivedBytes();
+                std::chrono::microseconds time = terminal_->receivedTime();
+                double elapsed = std::chrono::duration<double>(now - lastRefresh_).count();
+                if (elapsed > 0) {
+                    parseRate_ = (bytes - lastReceivedBytes_) / elapsed / (1024 * 1024);
+                    parseLoad_ = std::chrono::duration<double>(time - lastReceivedTime_).count() * 100 / elapsed;
+                }
+                lastReceivedBytes_ = bytes;
+                lastReceivedTime_ = time;
+            }
+            lastRefresh_ = now;
+            window_->renderOverlay();
+        }
+
+        Rect paint(Canvas & canvas) override {
+            FrameStats const & stats = window_->frameStats();
+            Rect box{Point{std::max(0, canvas.width() - WIDTH), 0}, Size{WIDTH, HEIGHT}};
+            Point x = box.topLeft() + Point{1, 0};
+            canvas.setBg(Color{32, 32, 32});
+            canvas.fill(box);
+            canvas.setFg(Color::White);
+            canvas.textOut(x, STR(std::left << std::setw(16) << STR("frames " << stats.frames()) << std::right << std::setw(9) << "last" << std::setw(9) << "avg" << std::setw(9) << "p95" << std::setw(9) << "max"));
+            x += Point{0, 1};
+            canvas.setFg(Color::Gray);
+            paintRow(canvas, x, "paint ms", stats.paintTime, 2);
+            paintRow(canvas, x, "render ms", stats.renderTime, 2);
+            paintRow(canvas, x, "cells", stats.cells, 0);
+            paintRow(canvas, x, "glyph runs", stats.glyphRuns, 0);
+            paintRow(canvas, x, "font changes", stats.fontChanges, 0);
+            paintRow(canvas, x, "color changes", stats.colorChanges, 0);
+            paintRow(canvas, x, "X requests", stats.requests, 0);
+            paintRow(canvas, x, "X bytes", stats.bytes, 0);
+            // the histogram of the render times, each bucket twice as wide as the previous one
+            std::array<size_t, RollingHistogram::BUCKETS> histogram = stats.renderTime.histogram(HISTOGRAM_BASE);
+            size_t highest = std::max(static_cast<size_t>(1), *std::max_element(histogram.begin(), histogram.end()));
+            std::stringstream bars;
+            for (size_t count : histogram)
+                bars << (count == 0 ? " " : BARS[(count * 8 + highest - 1) / highest]);
+            canvas.textOut(x, STR(std::left << std::setw(16) << "render histogram" << " <" << HISTOGRAM_BASE << " ms " << bars.str() << " >=" << HISTOGRAM_BASE * (1 << (RollingHistogram::BUCKETS - 2)) << " ms"));
+            x += Point{0, 1};
+            if (terminal_ != nullptr)
+                canvas.textOut(x, STR(std::left << std::setw(16) << "parse" << std::right << std::fixed << std::setprecision(2) << std::setw(9) << parseRate_ << " MB/s" << std::setprecision(0) << std::setw(9) << parseLoad_ << "% busy"));
+            x += Point{0, 1};
+            canvas.setFg(Color::White);
+            canvas.textOut(x, STR("toggle with Alt+F12"));
+            return box & canvas.rect();
+        }
+
+    private:
+
+        static constexpr double HISTOGRAM_BASE = 0.25;
+
+        /** Bars of increasing height to display the histogram with.
+         */
+        static constexpr char const * BARS[] = { " ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+
+        void paintRow(Canvas & canvas, Point & x, char const * name, RollingHistogram const & h, int precision) {
+            canvas.textOut(x, STR(std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(precision)
+                << std::setw(9) << h.last()
+                << std::setw(9) << h.average()
+                << std::setw(9) << h.percentile(0.95)
+                << std::setw(9) << h.max()));
+            x += Point{0, 1};
+        }
+
+        tpp::Window * window_;
+        AnsiTerminal * terminal_ = nullptr;
+
+        std::chrono::steady_clock::time_point lastRefresh_;
+        size_t lastReceivedBytes_ = 0;
+        std::chrono::microseconds lastReceivedTime_{0};
+        double parseRate_ = 0;
+        double parseLoad_ = 0;
+
+    }; // tpp::FrameStatsOverlay
+
+} // namespace tpp
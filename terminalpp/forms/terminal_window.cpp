@@ -13,17 +13,33 @@ namespace tpp {
         // sets the working directory of the command to the specified working directory of the session,
         Command cmd = session.command();
         cmd.setWorkingDirectory(session.workingDirectory());
+        // replay sessions play back the PTY capture given as the command instead of executing it
+        if (session.pty() == "replay" || session.pty() == "replay-fast")
+            pty = new ReplayPTYMaster{PTYCapture::Load(cmd.command()), session.pty() == "replay"};
 #if (ARCH_WINDOWS)
-        if (session.pty() != "bypass") 
+        else if (session.pty() != "bypass") 
             pty = new LocalPTYMaster(cmd);
         else
             pty = new BypassPTYMaster(cmd);
 #else
-        pty = new LocalPTYMaster{cmd};
+        else
+            pty = new LocalPTYMaster{cmd};
 #endif
+        // the capture is created before the terminal so that it records the output the command produces before the terminal's reader starts
+        PTYCapture::Writer * capture = nullptr;
+        if (config.telemetry.capturePty()) {
+            // sessions are created in the UI thread only, the counter distinguishes sessions created within the same second
+            static unsigned captures = 0;
+            std::string filename{STR(config.telemetry.dir() << "/" << TimeInDashed() << "-" << (++captures) << ".tppcap")};
+            try {
+                capture = new PTYCapture::Writer{filename};
+            } catch (IOError const & e) {
+                LOG() << "Unable to capture the session's PTY: " << e.what();
+            }
+        }
         // and the terminal
-        si->terminal = new AnsiTerminal{pty, session.palette()};
-        si->terminal->setMaxHistoryRows(config.renderer.window.historyLimit());
+        si->terminal = new AnsiTerminal{pty, session.palette(), capture};
+        si->terminal->setHistoryLimit(static_cast<size_t>(config.renderer.window.historyMemoryLimit()) * 1024 * 1024);
         si->terminal->setBoldIsBright(config.sequences.boldIsBright());
         si->terminal->setDisplayBold(config.sequences.displayBold());
         si->terminal->setCursor(session.cursor());
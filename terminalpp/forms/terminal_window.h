@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "ui/widgets/window.h"
 #include "ui/widgets/pager.h"
 #include "ui/widgets/panel.h"
@@ -8,12 +10,14 @@
 #include "ui-terminal/ansi_terminal.h"
 #include "tpp-lib/local_pty.h"
 #include "tpp-lib/bypass_pty.h"
+#include "tpp-lib/replay_pty.h"
 #include "tpp-lib/remote_files.h"
 
 #include "../config.h"
 #include "../window.h"
 
 #include "about_box.h"
+#include "frame_stats_overlay.h"
 
 namespace tpp {
 
@@ -98,7 +102,9 @@ namespace tpp {
         explicit TerminalWindow(tpp::Window * window):
             window_{window}, 
             main_{new Panel{}},
-            pager_{new Pager{}} {
+            pager_{new Pager{}},
+            frameStatsOverlay_{new FrameStatsOverlay{window}},
+            frameStatsTimerGuard_{std::make_shared<TimerGuard>()} {
 
             window_->onClose.setHandler(&TerminalWindow::windowCloseRequest, this);
             window_->onKeyDown.setHandler(&TerminalWindow::windowKeyDown, this);
@@ -107,6 +113,18 @@ namespace tpp {
             main_->setBackground(Color::Red);
             main_->attach(pager_);
             setContents(main_);
+            frameStatsTimer_.setInterval(FrameStatsOverlay::REFRESH_INTERVAL);
+            // the timer thread may be running the handler while the timer is stopped, so the handler checks the guard before touching the window
+            std::shared_ptr<TimerGuard> guard = frameStatsTimerGuard_;
+            frameStatsTimer_.setHandler([this, guard]() {
+                std::lock_guard<std::mutex> g{guard->m};
+                if (! guard->active)
+                    return false;
+                schedule([this](){
+                    frameStatsOverlay_->refresh();
+                });
+                return true;
+            });
 
             Config const & config = Config::Instance();
             remoteFiles_ = new RemoteFiles(config.remoteFiles.dir());
@@ -133,7 +151,15 @@ namespace tpp {
         }
 
         ~TerminalWindow() override {
+            {
+                std::lock_guard<std::mutex> g{frameStatsTimerGuard_->m};
+                frameStatsTimerGuard_->active = false;
+            }
+            frameStatsTimer_.stop();
             versionChecker_.join();
+            if (window_->overlay() == frameStatsOverlay_)
+                window_->setOverlay(nullptr);
+            delete frameStatsOverlay_;
             delete remoteFiles_;
         }
 
@@ -194,12 +220,29 @@ namespace tpp {
                     window_->setZoom(std::max(1.0, window_->zoom() / 1.25));
             } else if (*e == SHORTCUT_ABOUT && ! window_->isModal()) {
                 showModal(new AboutBox{});
+            } else if (*e == SHORTCUT_FRAME_STATS) {
+                toggleFrameStats();
             } else {
                 return;
             }
             e.stop();
         }
 
+        /** Shows or hides the frame statistics overlay.
+
+            The input processing statistics are sampled from the moment the overlay is shown.
+         */
+        void toggleFrameStats() {
+            if (window_->overlay() == frameStatsOverlay_) {
+                frameStatsTimer_.stop();
+                window_->setOverlay(nullptr);
+            } else {
+                frameStatsOverlay_->setTerminal(activeSession_ == nullptr ? nullptr : activeSession_->terminal);
+                window_->setOverlay(frameStatsOverlay_);
+                frameStatsTimer_.start();
+            }
+        }
+
         SessionInfo * sessionInfo(Widget * terminal) {
             AnsiTerminal * t = dynamic_cast<AnsiTerminal*>(terminal);
             ASSERT(t != nullptr);
@@ -214,6 +257,8 @@ namespace tpp {
                 session->pendingPaste->dismiss(session->pendingPaste->btnCancel());
             sessions_.erase(session->terminal);
             pager_->removePage(session->terminal);
+            if (frameStatsOverlay_->terminal() == session->terminal)
+                frameStatsOverlay_->setTerminal(nullptr);
             delete session;
             // if this was the last session, close the window
             if (sessions_.empty())
@@ -262,6 +307,7 @@ namespace tpp {
 
         void activeSessionChanged(ui::Event<Widget*>::Payload & e) {
             activeSession_ = *e == nullptr ? nullptr : sessionInfo(*e);
+            frameStatsOverlay_->setTerminal(activeSession_ == nullptr ? nullptr : activeSession_->terminal);
             // set own background to the session's terminal background so that it propagates to the window's background
             if (activeSession_ != nullptr) {
                 setBackground(activeSession_->terminal->palette().defaultBackground());
@@ -390,6 +436,20 @@ namespace tpp {
 
         ui::Panel * main_;
         ui::Pager * pager_;
+        /** The frame statistics are displayed as the window's overlay so that the terminal beneath does not have to be repainted with them.
+         */
+        FrameStatsOverlay * frameStatsOverlay_;
+        Timer frameStatsTimer_;
+
+        /** Tells the handler of a timer whether the window it refers to still exists. 
+         */
+        class TimerGuard {
+        public:
+            std::mutex m;
+            bool active = true;
+        }; 
+
+        std::shared_ptr<TimerGuard> frameStatsTimerGuard_;
 
         std::unordered_map<AnsiTerminal *, SessionInfo *> sessions_; 
 
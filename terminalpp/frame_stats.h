@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
+
+namespace tpp {
+
+    /** Rolling window of the last CAPACITY samples of a single frame metric.
+
+        Keeps the samples in a ring buffer so that adding a sample never allocates, and calculates the aggregates and the histogram of the window on demand, which is only done when they are displayed.
+     */
+    class RollingHistogram {
+    public:
+
+        static constexpr size_t CAPACITY = 128;
+
+        /** Number of buckets of the histogram.
+         */
+        static constexpr size_t BUCKETS = 8;
+
+        void add(double value) {
+            samples_[next_] = value;
+            next_ = (next_ + 1) % CAPACITY;
+            if (size_ < CAPACITY)
+                ++size_;
+        }
+
+        void clear() {
+            size_ = 0;
+            next_ = 0;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        /** Returns the most recent sample, or 0 if there are none.
+         */
+        double last() const {
+            return size_ == 0 ? 0 : samples_[(next_ + CAPACITY - 1) % CAPACITY];
+        }
+
+        double average() const {
+            if (size_ == 0)
+                return 0;
+            double sum = 0;
+            for (size_t i = 0; i < size_; ++i)
+                sum += samples_[i];
+            return sum / size_;
+        }
+
+        double max() const {
+            double result = 0;
+            for (size_t i = 0; i < size_; ++i)
+                result = std::max(result, samples_[i]);
+            return result;
+        }
+
+        /** Returns the value below which given fraction (0 - 1) of the samples lie.
+         */
+        double percentile(double p) const {
+            if (size_ == 0)
+                return 0;
+            std::vector<double> sorted{samples_.begin(), samples_.begin() + size_};
+            size_t i = static_cast<size_t>(p * (size_ - 1) + 0.5);
+            std::nth_element(sorted.begin(), sorted.begin() + i, sorted.end());
+            return sorted[i];
+        }
+
+        /** Returns the number of samples in exponentially growing buckets.
+
+            The first bucket holds the samples smaller than the base, each following bucket samples up to twice its lower bound and the last bucket all samples larger than that.
+         */
+        std::array<size_t, BUCKETS> histogram(double base) const {
+            std::array<size_t, BUCKETS> result{};
+            for (size_t i = 0; i < size_; ++i) {
+                size_t bucket = 0;
+                for (double limit = base; bucket < BUCKETS - 1 && samples_[i] >= limit; limit *= 2)
+                    ++bucket;
+                ++result[bucket];
+            }
+            return result;
+        }
+
+    private:
+        std::array<double, CAPACITY> samples_;
+        size_t size_ = 0;
+        size_t next_ = 0;
+    }; // tpp::RollingHistogram
+
+    /** Statistics of the frames rendered by a window.
+
+        For each frame the time spent painting the widgets on the renderer's buffer and rendering the buffer is recorded together with the amount of work the rendering did, i.e. the number of cells visited, glyph runs drawn and font and color changes. Where the renderer knows it, the number of requests and bytes sent to the display server is recorded as well. The statistics of the last frames are kept in rolling histograms, the totals since the window was created are kept as well.
+
+        The statistics are updated and read by the UI thread only.
+     */
+    class FrameStats {
+    public:
+
+        /** Statistics of a single frame.
+         */
+        class Frame {
+        public:
+            /** Time spent painting the widgets, 0 if the frame was rendered without painting (such as blink changes). */
+            std::chrono::steady_clock::duration paintTime{0};
+            /** Time spent rendering the buffer, including the flush to the display server, if any. */
+            std::chrono::steady_clock::duration renderTime{0};
+            size_t cells = 0;
+            size_t glyphRuns = 0;
+            size_t fontChanges = 0;
+            size_t colorChanges = 0;
+            /** Requests sent to the display server. */
+            size_t requests = 0;
+            /** Bytes sent to the display server. */
+            size_t bytes = 0;
+
+            Frame & operator += (Frame const & other) {
+                paintTime += other.paintTime;
+                renderTime += other.renderTime;
+                cells += other.cells;
+                glyphRuns += other.glyphRuns;
+                fontChanges += other.fontChanges;
+                colorChanges += other.colorChanges;
+                requests += other.requests;
+                bytes += other.bytes;
+                return *this;
+            }
+        }; // tpp::FrameStats::Frame
+
+        /** Records the frame.
+         */
+        void add(Frame const & frame) {
+            ++frames_;
+            total_ += frame;
+            paintTime.add(Milliseconds(frame.paintTime));
+            renderTime.add(Milliseconds(frame.renderTime));
+            cells.add(static_cast<double>(frame.cells));
+            glyphRuns.add(static_cast<double>(frame.glyphRuns));
+            fontChanges.add(static_cast<double>(frame.fontChanges));
+            colorChanges.add(static_cast<double>(frame.colorChanges));
+            requests.add(static_cast<double>(frame.requests));
+            bytes.add(static_cast<double>(frame.bytes));
+        }
+
+        /** Number of frames recorded since the window was created.
+         */
+        size_t frames() const {
+            return frames_;
+        }
+
+        /** Sum of all frames recorded since the window was created.
+         */
+        Frame const & total() const {
+            return total_;
+        }
+
+        /** \name Rolling histograms of the last frames.
+
+            The times are in milliseconds.
+         */
+        //@{
+        RollingHistogram paintTime;
+        RollingHistogram renderTime;
+        RollingHistogram cells;
+        RollingHistogram glyphRuns;
+        RollingHistogram fontChanges;
+        RollingHistogram colorChanges;
+        RollingHistogram requests;
+        RollingHistogram bytes;
+        //@}
+
+    private:
+
+        static double Milliseconds(std::chrono::steady_clock::duration d) {
+            return std::chrono::duration<double, std::milli>(d).count();
+        }
+
+        size_t frames_ = 0;
+        Frame total_;
+
+    }; // tpp::FrameStats
+
+} // namespace tpp
@@ -0,0 +1,52 @@
+#if (defined RENDERER_HEADLESS)
+#include <iostream>
+
+#include "headless_application.h"
+#include "headless_window.h"
+
+namespace tpp {
+
+    HeadlessApplication::HeadlessApplication() {
+        OSCHECK(FT_Init_FreeType(& freeType_) == 0) << "Unable to initialize FreeType";
+        fcConfig_ = FcInitLoadConfigAndFonts();
+        HeadlessWindow::InitializeBlink();
+    }
+
+    HeadlessApplication::~HeadlessApplication() {
+        FT_Done_FreeType(freeType_);
+    }
+
+    void HeadlessApplication::alert(std::string const & message) {
+        std::cerr << message << std::endl;
+    }
+
+    bool HeadlessApplication::query(std::string const & title, std::string const & message) {
+        std::cerr << title << ": " << message << std::endl;
+        return false;
+    }
+
+    void HeadlessApplication::openLocalFile(std::string const & filename, bool edit) {
+        MARK_AS_UNUSED(filename);
+        MARK_AS_UNUSED(edit);
+    }
+
+    void HeadlessApplication::openUrl(std::string const & url) {
+        MARK_AS_UNUSED(url);
+    }
+
+    void HeadlessApplication::setClipboard(std::string const & contents) {
+        MARK_AS_UNUSED(contents);
+    }
+
+    Window * HeadlessApplication::createWindow(std::string const & title, int cols, int rows) {
+        return new HeadlessWindow{title, cols, rows, eventQueue_};
+    }
+
+    void HeadlessApplication::mainLoop() {
+        while (eventQueue_.processEvent()) {
+        }
+    }
+
+} // namespace tpp
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#if (defined RENDERER_HEADLESS)
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <fontconfig/fontconfig.h>
+
+#include "../application.h"
+
+namespace tpp {
+
+    class HeadlessWindow;
+
+    /** Application of the headless renderer.
+
+        The headless renderer draws the windows into in-memory framebuffers using FreeType and fontconfig directly so that the rendering can be exercised and measured on machines without any display. There is no user to interact with, alerts and queries are written to the standard error and the main loop only processes the events pending in the UI event queue.
+     */
+    class HeadlessApplication : public Application {
+    public:
+
+        static void Initialize() {
+            new HeadlessApplication();
+        }
+
+        static HeadlessApplication * Instance() {
+            return dynamic_cast<HeadlessApplication*>(Application::Instance());
+        }
+
+        ~HeadlessApplication() override;
+
+        void alert(std::string const & message) override;
+
+        /** There is nobody to answer the query, so the answer is always no.
+         */
+        bool query(std::string const & title, std::string const & message) override;
+
+        void openLocalFile(std::string const & filename, bool edit) override;
+
+        void openUrl(std::string const & url) override;
+
+        void setClipboard(std::string const & contents) override;
+
+        Window * createWindow(std::string const & title, int cols, int rows) override;
+
+        /** Processes all events pending in the UI event queue and returns when there are none.
+         */
+        void mainLoop() override;
+
+        ui::EventQueue & eventQueue() {
+            return eventQueue_;
+        }
+
+    private:
+        friend class HeadlessFont;
+
+        HeadlessApplication();
+
+        FT_Library freeType_;
+
+        FcConfig * fcConfig_;
+
+    }; // tpp::HeadlessApplication
+
+} // namespace tpp
+
+#endif
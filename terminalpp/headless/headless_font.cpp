@@ -0,0 +1,111 @@
+#if (defined RENDERER_HEADLESS)
+#include <cmath>
+
+#include "headless_font.h"
+
+namespace tpp {
+
+    HeadlessFont::HeadlessFont(ui::Font font, int cellHeight, int cellWidth):
+        Font<HeadlessFont>{font, ui::Size{cellWidth, cellHeight}} {
+        pattern_ = FcPatternCreate();
+        FcPatternAddBool(pattern_, FC_SCALABLE, FcTrue);
+        FcPatternAddString(pattern_, FC_FAMILY, pointer_cast<FcChar8 const *>(tpp::Config::Instance().familyForFont(font).c_str()));
+        FcPatternAddInteger(pattern_, FC_WEIGHT, font.bold() ? FC_WEIGHT_BOLD : FC_WEIGHT_NORMAL);
+        FcPatternAddInteger(pattern_, FC_SLANT, font.italic() ? FC_SLANT_ITALIC : FC_SLANT_ROMAN);
+        initializeFromPattern();
+    }
+
+    HeadlessFont::HeadlessFont(HeadlessFont const & base, char32_t codepoint):
+        Font<HeadlessFont>{base.font_, base.fontSize_} {
+        pattern_ = FcPatternDuplicate(base.pattern_);
+        FcPatternRemove(pattern_, FC_FAMILY, 0);
+        FcCharSet * charSet = FcCharSetCreate();
+        FcCharSetAddChar(charSet, codepoint);
+        FcPatternAddCharSet(pattern_, FC_CHARSET, charSet);
+        FcCharSetDestroy(charSet);
+        initializeFromPattern();
+    }
+
+    void HeadlessFont::initializeFromPattern() {
+        // mirrors the X11 font initialization so that both renderers produce the same cell sizes for the same fonts
+        double fontHeight = fontSize_.height();
+        face_ = openFace(fontHeight);
+        if (face_ == nullptr) {
+            FcValue fontName;
+            FcPatternGet(pattern_, FC_FAMILY, 0, &fontName);
+            HeadlessApplication::Instance()->alert(STR("Unable to load font family " << fontName.u.s << ", trying fallback"));
+            FcPatternDel(pattern_, FC_FAMILY);
+            face_ = openFace(fontHeight);
+            OSCHECK(face_ != nullptr) << "Unable to initialize fallback font.";
+        }
+        // if the font height is not the cellHeight, update the pixel size accordingly and get the font again
+        int ascent = static_cast<int>((face_->size->metrics.ascender + 63) >> 6);
+        int descent = static_cast<int>((- face_->size->metrics.descender + 63) >> 6);
+        if (ascent + descent != fontSize_.height()) {
+            fontHeight = std::floor(fontHeight * fontHeight / (ascent + descent));
+            FT_Done_Face(face_);
+            face_ = openFace(fontHeight);
+        }
+        // now calculate the width of the font
+        int w = 0;
+        if (FT_Load_Char(face_, 'M', loadFlags_) == 0)
+            w = static_cast<int>((face_->glyph->advance.x + 32) >> 6);
+        int h = fontSize_.height();
+        // if cellWidth is 0, then the font is constructed to later determine the width of the cell and therefore no width adjustments are needed
+        if (fontSize_.width() == 0) {
+            fontSize_.setWidth(w);
+            offset_ = ui::Point{0,0};
+        // if the width is smaller, center the glyph horizontally
+        } else if (w < fontSize_.width()) {
+            offset_.setX((fontSize_.width() - w) / 2);
+        // if the width is greater than the cell width, we need smaller font
+        } else {
+            double x = static_cast<double>(fontSize_.width()) / w;
+            fontHeight *=  x;
+            h = static_cast<unsigned>(h * x);
+            FT_Done_Face(face_);
+            face_ = openFace(fontHeight);
+            offset_.setY((fontSize_.height() - h) / 2);
+        }
+        // now that we have correct font, initialize the rest of the properties
+        ascent_ = static_cast<float>((face_->size->metrics.ascender + 63) >> 6);
+        underlineOffset_ = ascent_ + 1;
+        underlineThickness_ = font_.size();
+        strikethroughOffset_ = ascent_ * 2 / 3;
+        strikethroughThickness_ = font_.size();
+    }
+
+    FT_Face HeadlessFont::openFace(double pixelSize) {
+        HeadlessApplication * app = HeadlessApplication::Instance();
+        FcPattern * configured = FcPatternDuplicate(pattern_);
+        if (configured == nullptr)
+            return nullptr;
+        FcPatternAddDouble(configured, FC_PIXEL_SIZE, pixelSize);
+        FcConfigSubstitute(app->fcConfig_, configured, FcMatchPattern);
+        FcDefaultSubstitute(configured);
+        FcResult fcr;
+        FcPattern * matched = FcFontMatch(app->fcConfig_, configured, & fcr);
+        FcPatternDestroy(configured);
+        if (matched == nullptr)
+            return nullptr;
+        FcChar8 * file = nullptr;
+        int index = 0;
+        FT_Face face = nullptr;
+        if (FcPatternGetString(matched, FC_FILE, 0, & file) == FcResultMatch) {
+            FcPatternGetInteger(matched, FC_INDEX, 0, & index);
+            if (FT_New_Face(app->freeType_, pointer_cast<char const *>(file), index, & face) != 0) {
+                face = nullptr;
+            } else if (FT_Set_Char_Size(face, 0, static_cast<FT_F26Dot6>(pixelSize * 64), 72, 72) != 0) {
+                FT_Done_Face(face);
+                face = nullptr;
+            }
+        }
+        if (face != nullptr)
+            loadFlags_ = FreeTypeLoadFlags(matched, embolden_);
+        FcPatternDestroy(matched);
+        return face;
+    }
+
+} // namespace tpp
+
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#if (defined RENDERER_HEADLESS)
+
+#include <unordered_map>
+#include <vector>
+
+#include "helpers/helpers.h"
+
+#include "headless_application.h"
+
+#include "../font.h"
+#include "../config.h"
+#include "../rasterization.h"
+
+namespace tpp {
+
+    /** Font of the headless renderer.
+
+        The font is matched by fontconfig the same way the X11 renderer matches its fonts and loaded and rasterized by FreeType directly.
+     */
+    class HeadlessFont : public Font<HeadlessFont> {
+    public:
+
+        /** Glyph of a codepoint, i.e. the font that renders the codepoint and the index of the codepoint's glyph in it.
+         */
+        class Glyph {
+        public:
+            HeadlessFont * font = nullptr;
+            FT_UInt index = 0;
+        }; // tpp::HeadlessFont::Glyph
+
+        ~HeadlessFont() override {
+            FT_Done_Face(face_);
+            FcPatternDestroy(pattern_);
+        }
+
+        bool supportsCodepoint(char32_t codepoint) {
+            return FT_Get_Char_Index(face_, codepoint) != 0;
+        }
+
+        /** Returns the glyph for given codepoint.
+
+            If the font does not support the codepoint, the glyph from a fallback font is returned. The glyphs are cached on first use, see GlyphCache.
+         */
+        Glyph glyphFor(char32_t codepoint) {
+            return glyphs_.get(codepoint, [this](char32_t c) { return lookupGlyph(c); });
+        }
+
+        /** Returns the rasterized glyph with given index.
+
+            The glyphs are rasterized on first use and cached.
+         */
+        GlyphBitmap const & glyphBitmap(FT_UInt index) {
+            auto i = glyphBitmaps_.find(index);
+            if (i == glyphBitmaps_.end()) {
+                i = glyphBitmaps_.insert(std::make_pair(index, GlyphBitmap{})).first;
+                RasterizeGlyph(face_, index, loadFlags_, embolden_, i->second);
+            }
+            return i->second;
+        }
+
+    private:
+        friend class Font<HeadlessFont>;
+
+        HeadlessFont(ui::Font font, int cellHeight, int cellWidth = 0);
+
+        HeadlessFont(HeadlessFont const & base, char32_t codepoint);
+
+        void initializeFromPattern();
+
+        /** Opens the FreeType face of the font matching the pattern at given pixel size. Returns nullptr if no font matches.
+         */
+        FT_Face openFace(double pixelSize);
+
+        Glyph lookupGlyph(char32_t codepoint) {
+            Glyph result{this, FT_Get_Char_Index(face_, codepoint)};
+            if (result.index == 0) {
+                result.font = fallbackFor(codepoint);
+                result.index = FT_Get_Char_Index(result.font->face_, codepoint);
+            }
+            return result;
+        }
+
+        FT_Face face_ = nullptr;
+        FcPattern * pattern_;
+        FT_Int32 loadFlags_ = FT_LOAD_DEFAULT;
+        bool embolden_ = false;
+
+        GlyphCache<Glyph> glyphs_;
+        std::unordered_map<FT_UInt, GlyphBitmap> glyphBitmaps_;
+
+    }; // tpp::HeadlessFont
+
+} // namespace tpp
+
+#endif
@@ -0,0 +1,153 @@
+#if (defined RENDERER_HEADLESS)
+#include <algorithm>
+
+#include "headless_window.h"
+
+namespace tpp {
+
+    HeadlessWindow::HeadlessWindow(std::string const & title, int cols, int rows, EventQueue & eventQueue):
+        RendererWindow{cols, rows, eventQueue},
+        pixels_(static_cast<size_t>(sizePx_.width()) * sizePx_.height(), 0),
+        font_{nullptr} {
+        title_ = title;
+        // the framebuffer keeps the last frame so that only the damaged cells have to be redrawn
+        retainsFrame_ = true;
+        // render every repaint immediately so that each frame can be measured
+        setFps(0);
+        RegisterWindowHandle(this, this);
+    }
+
+    HeadlessWindow::~HeadlessWindow() {
+        UnregisterWindowHandle(this);
+    }
+
+    void HeadlessWindow::show(bool value) {
+        // there is no window manager to focus the window, so it gets focused when shown
+        if (value && ! rendererFocused())
+            focusIn();
+        else if (! value && rendererFocused())
+            focusOut();
+    }
+
+    void HeadlessWindow::drawGlyphRun() {
+        if (text_.empty())
+            return;
+        int fontWidth = state_.font().width();
+        int fontHeight = state_.font().height();
+        int textSize = static_cast<int>(text_.size());
+        int x = textCol_ * cellSize_.width();
+        int y = (textRow_ + 1 - fontHeight) * cellSize_.height();
+        int width = textSize * cellSize_.width() * fontWidth;
+        int height = cellSize_.height() * fontHeight;
+        if (batch_.overlaps(x, y, width, height))
+            flushBatch();
+        batch_.addRun(x, y, width, height);
+        // fill the background unless it is fully transparent
+        if ((bg_ >> 24) != 0)
+            batch_.addBackground(bg_, bg_, x, y, width, height);
+        if (! state_.font().blink() || BlinkVisible()) {
+            // draw the text
+            batch_.addText(font_, fg_, text_.data(), text_.size());
+            // deal with the attributes
+            if (state_.font().underline()) {
+                int top = textRow_ * cellSize_.height() + static_cast<int>(font_->underlineOffset());
+                int thickness = static_cast<int>(font_->underlineThickness());
+                if (state_.font().dashed()) {
+                    for (int i = 0; i < textSize; ++i)
+                        batch_.addDecoration(decor_, decor_, (textCol_ + i) * cellSize_.width(), top, cellSize_.width() / 2, thickness);
+                } else {
+                    batch_.addDecoration(decor_, decor_, textCol_ * cellSize_.width(), top, cellSize_.width() * textSize, thickness);
+                }
+            }
+            if (state_.font().strikethrough()) {
+                int top = textRow_ * cellSize_.height() + static_cast<int>(font_->strikethroughOffset());
+                int thickness = static_cast<int>(font_->strikethroughThickness());
+                if (state_.font().dashed()) {
+                    for (int i = 0; i < textSize; ++i)
+                        batch_.addDecoration(decor_, decor_, (textCol_ + i) * cellSize_.width(), top, cellSize_.width() / 2, thickness);
+                } else {
+                    batch_.addDecoration(decor_, decor_, textCol_ * cellSize_.width(), top, cellSize_.width() * textSize, thickness);
+                }
+            }
+        }
+        if (! batchRuns_)
+            flushBatch();
+    }
+
+    void HeadlessWindow::flushBatch() {
+        batch_.flush(
+            [this](uint32_t color, Rectangle const * rects, size_t size) {
+                for (size_t i = 0; i < size; ++i)
+                    fillRect(color, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+            },
+            [this](HeadlessFont * font, uint32_t color, GlyphSpec const * glyphs, size_t size) {
+                MARK_AS_UNUSED(font);
+                for (size_t i = 0; i < size; ++i)
+                    drawGlyph(* glyphs[i].bitmap, glyphs[i].x, glyphs[i].y, color);
+            }
+        );
+    }
+
+    void HeadlessWindow::drawBorder(int col, int row, Border const & border, int widthThin, int widthThick) {
+        // the border is drawn over the cells
+        flushBatch();
+        int left = col * cellSize_.width();
+        int top = row * cellSize_.height();
+        int widthTop = border.top() == Border::Kind::None ? 0 : (border.top() == Border::Kind::Thick ? widthThick : widthThin);
+        int widthLeft = border.left() == Border::Kind::None ? 0 : (border.left() == Border::Kind::Thick ? widthThick : widthThin);
+        int widthBottom = border.bottom() == Border::Kind::None ? 0 : (border.bottom() == Border::Kind::Thick ? widthThick : widthThin);
+        int widthRight = border.right() == Border::Kind::None ? 0 : (border.right() == Border::Kind::Thick ? widthThick : widthThin);
+        if (widthTop != 0)
+            blendRect(bg_, left, top, cellSize_.width(), widthTop);
+        if (widthBottom != 0)
+            blendRect(bg_, left, top + cellSize_.height() - widthBottom, cellSize_.width(), widthBottom);
+        if (widthLeft != 0)
+            blendRect(bg_, left, top + widthTop, widthLeft, cellSize_.height() - widthTop - widthBottom);
+        if (widthRight != 0)
+            blendRect(bg_, left + cellSize_.width() - widthRight, top + widthTop, widthRight, cellSize_.height() - widthTop - widthBottom);
+    }
+
+    void HeadlessWindow::fillRect(uint32_t color, int x, int y, int width, int height) {
+        int left = std::max(x, 0);
+        int right = std::min(x + width, sizePx_.width());
+        int bottom = std::min(y + height, sizePx_.height());
+        for (int row = std::max(y, 0); row < bottom; ++row) {
+            uint32_t * p = pixels_.data() + static_cast<size_t>(row) * sizePx_.width();
+            for (int col = left; col < right; ++col)
+                p[col] = color;
+        }
+    }
+
+    void HeadlessWindow::blendRect(uint32_t color, int x, int y, int width, int height) {
+        int left = std::max(x, 0);
+        int right = std::min(x + width, sizePx_.width());
+        int bottom = std::min(y + height, sizePx_.height());
+        for (int row = std::max(y, 0); row < bottom; ++row) {
+            uint32_t * p = pixels_.data() + static_cast<size_t>(row) * sizePx_.width();
+            for (int col = left; col < right; ++col)
+                p[col] = PremultipliedOver(color, p[col]);
+        }
+    }
+
+    void HeadlessWindow::drawGlyph(GlyphBitmap const & glyph, int x, int y, uint32_t color) {
+        x += glyph.left;
+        y -= glyph.top;
+        int left = std::max(x, 0);
+        int right = std::min(x + static_cast<int>(glyph.width), sizePx_.width());
+        int bottom = std::min(y + static_cast<int>(glyph.height), sizePx_.height());
+        bool opaque = (color >> 24) == 0xff;
+        for (int row = std::max(y, 0); row < bottom; ++row) {
+            uint32_t * p = pixels_.data() + static_cast<size_t>(row) * sizePx_.width();
+            unsigned char const * coverage = glyph.alpha.data() + static_cast<size_t>(row - y) * glyph.stride;
+            for (int col = left; col < right; ++col) {
+                uint32_t c = coverage[col - x];
+                if (c == 0)
+                    continue;
+                p[col] = (c == 0xff && opaque) ? color : PremultipliedOver(PremultipliedScale(color, c), p[col]);
+            }
+        }
+    }
+
+} // namespace tpp
+
+#endif
@@ -0,0 +1,218 @@
+#pragma once
+#if (defined RENDERER_HEADLESS)
+
+#include <cstdint>
+#include <vector>
+
+#include "headless_font.h"
+#include "../window.h"
+#include "../draw_batch.h"
+
+namespace tpp {
+
+    using namespace ui;
+
+    /** Window of the headless renderer.
+
+        Renders the cells into an in-memory framebuffer of premultiplied 0xAARRGGBB pixels using the same rendering hooks as the native renderers, so that the rendering cost can be measured and its output inspected without a display. The window renders synchronously, i.e. every repaint is rendered immediately.
+     */
+    class HeadlessWindow : public RendererWindow<HeadlessWindow, HeadlessWindow *> {
+    public:
+        /** Bring the font to the class' namespace so that the RendererWindow can find it.
+         */
+        using Font = HeadlessFont;
+
+        HeadlessWindow(std::string const & title, int cols, int rows, EventQueue & eventQueue);
+
+        ~HeadlessWindow() override;
+
+        void show(bool value = true) override;
+
+        /** Resizes the window to given size in pixels as if resized by the user.
+         */
+        void resizePx(int width, int height) {
+            windowResized(width, height);
+        }
+
+        /** Returns the framebuffer, rows of sizePx().width() premultiplied 0xAARRGGBB pixels.
+         */
+        std::vector<uint32_t> const & pixels() const {
+            return pixels_;
+        }
+
+        /** Creates the global rendering state without the blinker thread so that the rendering is deterministic. Blinking text and cursor are visible unless the blink is toggled by calling BlinkTick() explicitly.
+         */
+        static void InitializeBlink() {
+            GlobalState_ = new GlobalState{};
+            GlobalState_->blinkVisible = true;
+        }
+
+    protected:
+
+        /** Determines whether the glyph runs are batched like the X11 renderer does, or drawn one by one.
+         */
+        bool batchRuns_ = true;
+
+        void windowResized(int width, int height) override {
+            pixels_.assign(static_cast<size_t>(width) * height, 0);
+            RendererWindow::windowResized(width, height);
+        }
+
+        void setMouseCursor(MouseCursor cursor) override {
+            MARK_AS_UNUSED(cursor);
+        }
+
+        void setClipboard(std::string const & contents) override {
+            MARK_AS_UNUSED(contents);
+        }
+
+        void setSelection(std::string const & contents, Widget * owner) override {
+            MARK_AS_UNUSED(contents);
+            MARK_AS_UNUSED(owner);
+        }
+
+    private:
+        friend class RendererWindow<HeadlessWindow, HeadlessWindow *>;
+
+        class GlyphSpec {
+        public:
+            GlyphBitmap const * bitmap;
+            int x;
+            int y;
+        }; // tpp::HeadlessWindow::GlyphSpec
+
+        class Rectangle {
+        public:
+            int x;
+            int y;
+            int width;
+            int height;
+        }; // tpp::HeadlessWindow::Rectangle
+
+        /** Batch of glyph runs drawn the same way as by the X11 renderer. 
+         */
+        using Batch = DrawBatch<HeadlessFont, uint32_t, GlyphSpec, Rectangle>;
+
+        /** \name Rendering Functions
+         */
+        //@{
+        void initializeDraw() {
+        }
+
+        /** Fills the parts of the window not covered by cells when the whole window has been redrawn.
+         */
+        void finalizeDraw() {
+            flushBatch();
+            if (damageAll_) {
+                changeBackgroundColor(backgroundColor());
+                if (sizePx_.width() % cellSize_.width() != 0)
+                    fillRect(bg_, width() * cellSize_.width(), 0, sizePx_.width() % cellSize_.width(), sizePx_.height());
+                if (sizePx_.height() % cellSize_.height() != 0)
+                    fillRect(bg_, 0, height() * cellSize_.height(), sizePx_.width(), sizePx_.height() % cellSize_.height());
+            }
+        }
+
+        void initializeGlyphRun(int col, int row) {
+            text_.clear();
+            textCol_ = col;
+            textRow_ = row;
+        }
+
+        void addGlyph(int col, int row, Cell const & cell) {
+            HeadlessFont::Glyph glyph = font_->glyphFor(cell.codepoint());
+            if (glyph.font != font_) {
+                // draw glyph run so far and draw the glyph from the fallback font as a glyph run of its own
+                drawGlyphRun();
+                initializeGlyphRun(col, row);
+                HeadlessFont * oldFont = font_;
+                font_ = glyph.font;
+                text_.push_back(GlyphSpec{
+                    & font_->glyphBitmap(glyph.index),
+                    textCol_ * cellSize_.width() + font_->offset().x(),
+                    (textRow_ + 1 - font_->font().height()) * cellSize_.height() + static_cast<int>(font_->ascent()) + font_->offset().y()
+                });
+                drawGlyphRun();
+                initializeGlyphRun(col + font_->font().width(), row);
+                font_ = oldFont;
+            } else if (text_.empty()) {
+                text_.push_back(GlyphSpec{
+                    & font_->glyphBitmap(glyph.index),
+                    textCol_ * cellSize_.width() + font_->offset().x(),
+                    (textRow_ + 1 - state_.font().height()) * cellSize_.height() + static_cast<int>(font_->ascent()) + font_->offset().y()
+                });
+            } else {
+                text_.push_back(GlyphSpec{
+                    & font_->glyphBitmap(glyph.index),
+                    text_.back().x + cellSize_.width() * state_.font().width(),
+                    text_.back().y
+                });
+            }
+        }
+
+        void changeFont(ui::Font font) {
+            font_ = HeadlessFont::Get(font, cellSize_);
+        }
+
+        void changeForegroundColor(Color color) {
+            fg_ = ToPixel(color);
+        }
+
+        void changeBackgroundColor(Color color) {
+            bg_ = ToPixel(color);
+        }
+
+        void changeDecorationColor(Color color) {
+            decor_ = ToPixel(color);
+        }
+
+        /** Draws the glyph run.
+
+            The background, text and decorations of the run are added to the batch, which is flushed when the run would cover pixels of the runs already in it, before the borders and at the end of the frame. Unless batching is enabled, the batch is flushed after each run, i.e. the background of the run is cleared first, then its text is drawn and finally any decorations are applied.
+         */
+        void drawGlyphRun();
+
+        /** Draws the batched glyph runs.
+         */
+        void flushBatch();
+
+        /** Draws the border over the cell.
+         */
+        void drawBorder(int col, int row, Border const & border, int widthThin, int widthThick);
+        //@}
+
+        /** Replaces the pixels of the rectangle with given color.
+         */
+        void fillRect(uint32_t color, int x, int y, int width, int height);
+
+        /** Blends given color over the pixels of the rectangle.
+         */
+        void blendRect(uint32_t color, int x, int y, int width, int height);
+
+        /** Blends the color over the pixels covered by the glyph whose origin is at given coordinates.
+         */
+        void drawGlyph(GlyphBitmap const & glyph, int x, int y, uint32_t color);
+
+        /** Converts the color to premultiplied pixel value.
+         */
+        static uint32_t ToPixel(Color const & c) {
+            uint32_t a = c.a;
+            return (a << 24) + ((c.r * a / 255) << 16) + ((c.g * a / 255) << 8) + (c.b * a / 255);
+        }
+
+        std::vector<uint32_t> pixels_;
+
+        HeadlessFont * font_;
+        uint32_t fg_ = 0;
+        uint32_t bg_ = 0;
+        uint32_t decor_ = 0;
+
+        std::vector<GlyphSpec> text_;
+        Batch batch_;
+        int textCol_ = 0;
+        int textRow_ = 0;
+
+    }; // tpp::HeadlessWindow
+
+} // namespace tpp
+
+#endif
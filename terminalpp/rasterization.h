@@ -0,0 +1,111 @@
+#pragma once
+#if (defined ARCH_UNIX)
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SYNTHESIS_H
+#include <fontconfig/fontconfig.h>
+
+namespace tpp {
+
+    /** Rasterized glyph, i.e. its coverage and position relative to the glyph origin.
+
+        The coverage is stored as 8bit alpha values with rows padded to 4 bytes, which is also the format of A8 XRender glyphs.
+     */
+    class GlyphBitmap {
+    public:
+        int left = 0;
+        int top = 0;
+        unsigned width = 0;
+        unsigned height = 0;
+        unsigned stride = 0;
+        std::vector<unsigned char> alpha;
+    }; // tpp::GlyphBitmap
+
+    /** Returns the FreeType load flags for the font matched by fontconfig, determined the same way Xft does, and whether the glyphs should be emboldened.
+     */
+    inline FT_Int32 FreeTypeLoadFlags(FcPattern * matched, bool & embolden) {
+        FcBool antialias = FcTrue;
+        FcPatternGetBool(matched, FC_ANTIALIAS, 0, & antialias);
+        FcBool hinting = FcTrue;
+        FcPatternGetBool(matched, FC_HINTING, 0, & hinting);
+        int hintStyle = FC_HINT_FULL;
+        FcPatternGetInteger(matched, FC_HINT_STYLE, 0, & hintStyle);
+        FcBool autohint = FcFalse;
+        FcPatternGetBool(matched, FC_AUTOHINT, 0, & autohint);
+        FcBool embeddedBitmap = FcFalse;
+        FcPatternGetBool(matched, FC_EMBEDDED_BITMAP, 0, & embeddedBitmap);
+        FcBool emboldenValue = FcFalse;
+        FcPatternGetBool(matched, FC_EMBOLDEN, 0, & emboldenValue);
+        FT_Int32 result = FT_LOAD_DEFAULT;
+        if (! antialias)
+            result |= FT_LOAD_TARGET_MONO;
+        else if (hintStyle == FC_HINT_SLIGHT)
+            result |= FT_LOAD_TARGET_LIGHT;
+        if (antialias && ! embeddedBitmap)
+            result |= FT_LOAD_NO_BITMAP;
+        if (! hinting || hintStyle == FC_HINT_NONE)
+            result |= FT_LOAD_NO_HINTING;
+        if (autohint)
+            result |= FT_LOAD_FORCE_AUTOHINT;
+        embolden = emboldenValue;
+        return result;
+    }
+
+    /** Rasterizes the glyph of given face into the bitmap.
+
+        Monochrome and gray glyphs are converted to the 8bit coverage, color glyphs are drawn by their alpha channel only. If the glyph cannot be loaded or rendered, the bitmap is left empty.
+     */
+    inline void RasterizeGlyph(FT_Face face, FT_UInt index, FT_Int32 loadFlags, bool embolden, GlyphBitmap & bitmap) {
+        if (FT_Load_Glyph(face, index, loadFlags) != 0)
+            return;
+        FT_GlyphSlot slot = face->glyph;
+        if (embolden)
+            FT_GlyphSlot_Embolden(slot);
+        if (slot->format != FT_GLYPH_FORMAT_BITMAP && FT_Render_Glyph(slot, FT_LOAD_TARGET_MODE(loadFlags)) != 0)
+            return;
+        FT_Bitmap const & b = slot->bitmap;
+        bitmap.left = slot->bitmap_left;
+        bitmap.top = slot->bitmap_top;
+        bitmap.width = b.width;
+        bitmap.height = b.rows;
+        bitmap.stride = (b.width + 3) & ~3u;
+        bitmap.alpha.assign(bitmap.stride * b.rows, 0);
+        for (unsigned row = 0; row < b.rows; ++row) {
+            unsigned char const * src = b.buffer + static_cast<int>(row) * b.pitch;
+            unsigned char * dst = bitmap.alpha.data() + row * bitmap.stride;
+            if (b.pixel_mode == FT_PIXEL_MODE_GRAY) {
+                memcpy(dst, src, b.width);
+            } else if (b.pixel_mode == FT_PIXEL_MODE_MONO) {
+                for (unsigned col = 0; col < b.width; ++col)
+                    dst[col] = (src[col / 8] & (0x80 >> (col % 8))) ? 0xff : 0;
+            } else if (b.pixel_mode == FT_PIXEL_MODE_BGRA) {
+                for (unsigned col = 0; col < b.width; ++col)
+                    dst[col] = src[col * 4 + 3];
+            }
+        }
+    }
+
+    /** Multiplies all channels of the premultiplied 0xAARRGGBB color by given alpha.
+     */
+    inline uint32_t PremultipliedScale(uint32_t color, uint32_t alpha) {
+        uint32_t rb = (color & 0xff00ff) * alpha;
+        uint32_t ag = ((color >> 8) & 0xff00ff) * alpha;
+        rb = ((rb + 0x800080 + ((rb >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+        ag = ((ag + 0x800080 + ((ag >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+        return rb | (ag << 8);
+    }
+
+    /** Composes the premultiplied source color over the destination.
+     */
+    inline uint32_t PremultipliedOver(uint32_t src, uint32_t dst) {
+        return src + PremultipliedScale(dst, 255 - (src >> 24));
+    }
+
+} // namespace tpp
+
+#endif
@@ -0,0 +1,68 @@
+#if (defined RENDERER_HEADLESS)
+#include "helpers/tests.h"
+
+#include "test_window.h"
+
+using namespace tpp;
+
+// the blink visibility is shared by all windows, so the tests always toggle it an even number of times
+
+TEST(renderer_blink, damagesBlinkingRows) {
+    TestWindow w{20, 5};
+    Canvas::Buffer & cells = w.widget()->cells();
+    cells.at(Point{3, 1}).setCodepoint('b').font().setBlink();
+    cells.at(Point{7, 3}).setCodepoint('c').font().setBlink();
+    cells.at(Point{5, 2}).setCodepoint('x');
+    w.repaintWidget();
+    size_t frames = w.frames();
+    TestWindow::BlinkTick();
+    w.processEvents();
+    EXPECT_EQ(w.frames(), frames + 1);
+    EXPECT(! w.damageAll());
+    EXPECT_EQ(w.damage().size(), 2);
+    EXPECT(w.damage()[0] == Rect(Point{2, 1}, Size{3, 1}));
+    EXPECT(w.damage()[1] == Rect(Point{6, 3}, Size{3, 1}));
+    TestWindow::BlinkTick();
+    w.processEvents();
+    EXPECT_EQ(w.frames(), frames + 2);
+    EXPECT_EQ(w.damage().size(), 2);
+}
+
+TEST(renderer_blink, skipsWindowsWithoutBlink) {
+    TestWindow blinking{20, 5};
+    TestWindow still{20, 5};
+    blinking.widget()->cells().at(Point{3, 1}).setCodepoint('b').font().setBlink();
+    blinking.repaintWidget();
+    // a cursor that does not blink does not make the window blink either
+    Canvas::Cursor cursor;
+    cursor.setBlink(false);
+    still.widget()->cells().at(Point{3, 1}).setCodepoint('b');
+    still.widget()->setCursor(cursor, Point{4, 1});
+    still.repaintWidget();
+    size_t blinkingFrames = blinking.frames();
+    size_t stillFrames = still.frames();
+    TestWindow::BlinkTick();
+    TestWindow::BlinkTick();
+    still.processEvents();
+    EXPECT_EQ(blinking.frames(), blinkingFrames + 2);
+    EXPECT_EQ(still.frames(), stillFrames);
+    // the window stops blinking when its blinking cells are gone
+    blinking.widget()->cells().at(Point{3, 1}).font().setBlink(false);
+    blinking.repaintWidget();
+    blinkingFrames = blinking.frames();
+    TestWindow::BlinkTick();
+    TestWindow::BlinkTick();
+    blinking.processEvents();
+    EXPECT_EQ(blinking.frames(), blinkingFrames);
+    // and starts blinking when its cursor does
+    cursor.setBlink(true);
+    still.widget()->setCursor(cursor, Point{4, 1});
+    still.repaintWidget();
+    stillFrames = still.frames();
+    TestWindow::BlinkTick();
+    TestWindow::BlinkTick();
+    still.processEvents();
+    EXPECT_EQ(still.frames(), stillFrames + 2);
+}
+
+#endif
@@ -0,0 +1,153 @@
+#if (defined RENDERER_HEADLESS)
+#include "helpers/tests.h"
+
+#include "test_window.h"
+
+using namespace tpp;
+
+namespace {
+
+    /** Returns the rectangles damaged by the last frame of the window as a string, or "all" if the whole window has been redrawn.
+     */
+    std::string Damage(TestWindow & window) {
+        if (window.damageAll())
+            return "all";
+        std::stringstream result;
+        for (Rect const & r : window.damage())
+            result << "[" << r.left() << "," << r.top() << " " << r.width() << "x" << r.height() << "]";
+        return result.str();
+    }
+
+    /** Overlay that fills a fixed rectangle with given codepoint.
+     */
+    class TestOverlay : public tpp::Window::Overlay {
+    public:
+        Rect paint(Canvas & canvas) override {
+            Canvas::Cell cell;
+            cell.setCodepoint(codepoint);
+            canvas.fill(rect, cell);
+            return rect;
+        }
+
+        Rect rect{Point{2, 1}, Size{3, 1}};
+        char32_t codepoint = 'o';
+    }; // TestOverlay
+
+}
+
+TEST(renderer_damage, singleCell) {
+    TestWindow w{20, 5};
+    EXPECT_EQ(Damage(w), "all");
+    // the span of the changed cell is widened by one cell on each side
+    size_t frames = w.frames();
+    w.widget()->cells().at(Point{5, 2}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(w.frames(), frames + 1);
+    EXPECT_EQ(Damage(w), "[4,2 3x1]");
+    // the widening is clipped at the window's edges
+    w.widget()->cells().at(Point{0, 0}).setCodepoint('x');
+    w.widget()->cells().at(Point{19, 4}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[0,0 2x1][18,4 2x1]");
+    // rows with identical spans are merged
+    w.widget()->cells().at(Point{10, 1}).setFg(Color::Red);
+    w.widget()->cells().at(Point{10, 2}).setBg(Color::Blue);
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[9,1 3x2]");
+    // unchanged contents damage nothing
+    w.repaintWidget();
+    EXPECT_EQ(w.frames(), frames + 4);
+    EXPECT_EQ(Damage(w), "");
+}
+
+TEST(renderer_damage, wideCells) {
+    TestWindow w{20, 5};
+    Canvas::Buffer & cells = w.widget()->cells();
+    // the wide cell and the cell it now covers are damaged
+    cells.at(Point{4, 2}).setCodepoint(0x4e00).setFont(ui::Font{}.setDoubleWidth());
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[3,2 4x1]");
+    // the damaged span starts at the wide cell that covers its left
+    cells.at(Point{6, 2}).setCodepoint('y');
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[4,2 4x1]");
+    cells.at(Point{3, 2}).setCodepoint('y');
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[2,2 4x1]");
+    // the cell uncovered by the wide cell is damaged as well
+    cells.at(Point{4, 2}).setCodepoint('a').setFont(ui::Font{});
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[3,2 4x1]");
+}
+
+TEST(renderer_damage, cursorMove) {
+    TestWindow w{20, 5};
+    Canvas::Cursor cursor;
+    cursor.setBlink(false);
+    w.widget()->setCursor(cursor, Point{3, 1});
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[2,1 3x1]");
+    // both the cell the cursor was drawn at and its new position are damaged
+    w.widget()->setCursor(cursor, Point{10, 3});
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[2,1 3x1][9,3 3x1]");
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[9,3 3x1]");
+    // hiding the cursor only damages the cell it was drawn at
+    cursor.setVisible(false);
+    w.widget()->setCursor(cursor, Point{10, 3});
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[9,3 3x1]");
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "");
+}
+
+TEST(renderer_damage, overlay) {
+    TestWindow w{20, 5};
+    TestOverlay overlay;
+    w.setOverlay(& overlay);
+    w.processEvents();
+    EXPECT_EQ(Damage(w), "[1,1 5x1]");
+    // changes beneath the overlay do not redraw it
+    w.widget()->cells().at(Point{10, 3}).setCodepoint('x');
+    w.widget()->cells().at(Point{3, 1}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "[9,3 3x1]");
+    // the overlay is rendered without repainting the widgets and the frame is not recorded in the statistics
+    size_t frames = w.frames();
+    overlay.codepoint = 'p';
+    w.renderOverlay();
+    EXPECT_EQ(w.frames(), frames);
+    EXPECT_EQ(Damage(w), "[1,1 5x1]");
+    EXPECT(w.buffer().at(Point{2, 1}).codepoint() == 'p');
+    // removing the overlay restores the widgets beneath
+    w.setOverlay(nullptr);
+    w.processEvents();
+    EXPECT_EQ(Damage(w), "[1,1 5x1]");
+    EXPECT(w.buffer().at(Point{3, 1}).codepoint() == 'x');
+}
+
+TEST(renderer_damage, resize) {
+    TestWindow w{20, 5};
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "");
+    // change of the buffer size redraws the whole window
+    size_t frames = w.frames();
+    Size cell{w.sizePx().width() / 20, w.sizePx().height() / 5};
+    w.resizePx(cell.width() * 22, cell.height() * 6);
+    w.processEvents();
+    EXPECT_EQ(w.width(), 22);
+    EXPECT(w.frames() > frames);
+    EXPECT_EQ(Damage(w), "all");
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "");
+    // and so does the change of the window size that keeps the buffer size
+    w.resizePx(cell.width() * 22 + 1, cell.height() * 6);
+    w.repaintWidget();
+    EXPECT_EQ(w.width(), 22);
+    EXPECT_EQ(Damage(w), "all");
+    w.repaintWidget();
+    EXPECT_EQ(Damage(w), "");
+}
+
+#endif
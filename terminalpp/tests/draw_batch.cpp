@@ -0,0 +1,140 @@
+#if (defined RENDERER_HEADLESS)
+#include "helpers/tests.h"
+
+#include "../draw_batch.h"
+
+#include "test_window.h"
+
+using namespace tpp;
+
+namespace {
+
+    class TestRect {
+    public:
+        int x;
+        int y;
+        int width;
+        int height;
+    }; // TestRect
+
+    using TestBatch = DrawBatch<void, char, char, TestRect>;
+
+    /** Returns the operations of the flushed batch as a string, "f" followed by the color for each fill and "t" followed by the text for each text run.
+     */
+    std::string Flush(TestBatch & batch) {
+        std::string result;
+        batch.flush(
+            [& result](char color, TestRect const * rects, size_t size) {
+                MARK_AS_UNUSED(rects);
+                for (size_t i = 0; i < size; ++i)
+                    result = result + "f" + color;
+            },
+            [& result](void * font, char color, char const * glyphs, size_t size) {
+                MARK_AS_UNUSED(font);
+                MARK_AS_UNUSED(color);
+                result = result + "t" + std::string{glyphs, size};
+            }
+        );
+        return result;
+    }
+
+    /** Renders the cells set by the given function to a window that batches the glyph runs and to a window that draws them one by one and returns true if the framebuffers are identical.
+     */
+    template<typename SETUP>
+    bool SameAsUnbatched(SETUP setup) {
+        TestWindow batched{12, 4};
+        TestWindow unbatched{12, 4};
+        unbatched.setBatchRuns(false);
+        setup(batched.widget());
+        setup(unbatched.widget());
+        batched.repaintWidget();
+        unbatched.repaintWidget();
+        return batched.pixels() == unbatched.pixels();
+    }
+
+}
+
+TEST(renderer_draw_batch, fillsBeforeText) {
+    TestBatch batch;
+    batch.addRun(0, 0, 20, 10);
+    batch.addBackground('a', 'a', 0, 0, 20, 10);
+    batch.addText(nullptr, 'x', "ab", 2);
+    batch.addDecoration('u', 'u', 0, 8, 20, 1);
+    EXPECT(! batch.overlaps(20, 0, 10, 10));
+    batch.addRun(20, 0, 10, 10);
+    batch.addBackground('a', 'a', 20, 0, 10, 10);
+    batch.addText(nullptr, 'x', "c", 1);
+    EXPECT_EQ(Flush(batch), "fafatabtcfu");
+    EXPECT(batch.empty());
+    EXPECT_EQ(Flush(batch), "");
+}
+
+TEST(renderer_draw_batch, overlappingRuns) {
+    TestBatch batch;
+    batch.addRun(10, 10, 20, 10);
+    // runs right of the last one in the same row and runs below it can be batched
+    EXPECT(! batch.overlaps(30, 10, 10, 10));
+    EXPECT(! batch.overlaps(0, 20, 10, 10));
+    // runs over the cells already drawn, such as the cursor, or runs of different height cannot
+    EXPECT(batch.overlaps(20, 10, 10, 10));
+    EXPECT(batch.overlaps(0, 10, 10, 10));
+    EXPECT(batch.overlaps(30, 0, 10, 20));
+    EXPECT(batch.overlaps(40, 5, 10, 10));
+    Flush(batch);
+    EXPECT(! batch.overlaps(20, 10, 10, 10));
+}
+
+TEST(renderer_draw_batch, overhangingDecorations) {
+    TestBatch batch;
+    batch.addRun(0, 0, 20, 10);
+    // the underline is below the row
+    batch.addDecoration('u', 'u', 0, 10, 20, 2);
+    EXPECT(batch.overlaps(0, 10, 10, 10));
+    EXPECT(batch.overlaps(15, 10, 10, 10));
+    EXPECT(! batch.overlaps(20, 10, 10, 10));
+    EXPECT(! batch.overlaps(0, 20, 10, 10));
+    // decorations within the run do not prevent the next row from being batched
+    Flush(batch);
+    batch.addRun(0, 0, 20, 10);
+    batch.addDecoration('u', 'u', 0, 8, 20, 2);
+    EXPECT(! batch.overlaps(0, 10, 10, 10));
+}
+
+TEST(renderer_draw_batch, decorationsAndBackgrounds) {
+    EXPECT(SameAsUnbatched([](TestWidget * w) {
+        Canvas::Buffer & cells = w->cells();
+        for (int col = 0; col < 12; ++col) {
+            for (int row = 0; row < 4; ++row) {
+                Canvas::Cell & c = cells.at(Point{col, row});
+                c.setCodepoint(static_cast<char32_t>('a' + col)).setBg(col % 3 == 0 ? Color::Blue : Color::Red).setDecor(row % 2 == 0 ? Color::Green : Color::Yellow);
+                c.font().setUnderline(row != 1).setStrikethrough(col % 2 == 0).setDashed(row == 2);
+            }
+        }
+    }));
+}
+
+TEST(renderer_draw_batch, cursorOverDecorations) {
+    EXPECT(SameAsUnbatched([](TestWidget * w) {
+        Canvas::Buffer & cells = w->cells();
+        for (int col = 0; col < 12; ++col) {
+            Canvas::Cell & c = cells.at(Point{col, 1});
+            c.setCodepoint('_').setBg(col < 6 ? Color::Blue : Color::Red).setDecor(Color::Green);
+            c.font().setUnderline().setStrikethrough();
+        }
+        Canvas::Cursor cursor;
+        cursor.setCodepoint(0x2588).setColor(Color::White).setBlink(false);
+        w->setCursor(cursor, Point{4, 1});
+    }));
+}
+
+TEST(renderer_draw_batch, largeFontsAndBorders) {
+    EXPECT(SameAsUnbatched([](TestWidget * w) {
+        Canvas::Buffer & cells = w->cells();
+        for (int col = 0; col < 12; ++col)
+            cells.at(Point{col, 1}).setCodepoint('x').setBg(Color::Blue).font().setUnderline();
+        cells.at(Point{3, 2}).setCodepoint('W').setBg(Color::Red).font().setSize(2).setUnderline();
+        cells.at(Point{8, 3}).setCodepoint('y').setBorder(Border::All(Color::Green, Border::Kind::Thin));
+    }));
+}
+
+#endif
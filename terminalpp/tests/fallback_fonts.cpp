@@ -0,0 +1,114 @@
+#if (defined RENDERER_HEADLESS)
+#include "helpers/tests.h"
+
+#include "../font.h"
+
+#include "test_window.h"
+
+using namespace tpp;
+
+namespace {
+
+    /** Font that counts the fallback fonts created and deleted and the fonts searched for codepoints.
+
+        The base fonts support ASCII only, a fallback font supports the CJK block if created for a codepoint from it, and nothing otherwise.
+     */
+    class TestFont : public tpp::Font<TestFont> {
+    public:
+        bool supportsCodepoint(char32_t codepoint) {
+            ++Searched;
+            return cjk_ ? (codepoint >= 0x4e00 && codepoint < 0xa000) : (codepoint < 0x80 && ! fallback_);
+        }
+
+        ~TestFont() override {
+            if (fallback_)
+                ++Deleted;
+        }
+
+        static size_t Created;
+        static size_t Deleted;
+        static size_t Searched;
+
+    private:
+        friend class tpp::Font<TestFont>;
+
+        TestFont(ui::Font font, int cellHeight, int cellWidth = 0):
+            tpp::Font<TestFont>{font, ui::Size{cellWidth, cellHeight}} {
+            // the cell size is adjusted by the spacing settings, so the configuration must be initialized
+            TestApplication();
+            fontSize_.setWidth(cellHeight / 2);
+        }
+
+        TestFont(TestFont const & base, char32_t codepoint):
+            tpp::Font<TestFont>{base.font_, base.fontSize_},
+            fallback_{true},
+            cjk_{codepoint >= 0x4e00 && codepoint < 0xa000} {
+            ++Created;
+        }
+
+        bool fallback_ = false;
+        bool cjk_ = false;
+    }; // TestFont
+
+    size_t TestFont::Created = 0;
+    size_t TestFont::Deleted = 0;
+    size_t TestFont::Searched = 0;
+
+}
+
+// each test uses a different font size so that it starts with no fallback fonts
+
+TEST(fallback_fonts, resolvedCodepointNotSearched) {
+    TestFont * font = TestFont::Get(ui::Font{}, 10);
+    size_t created = TestFont::Created;
+    TestFont * cjk = font->fallbackFor(0x4e00);
+    EXPECT_EQ(TestFont::Created, created + 1);
+    // the fallback fonts created so far are searched first
+    size_t searched = TestFont::Searched;
+    EXPECT(font->fallbackFor(0x4e01) == cjk);
+    EXPECT_EQ(TestFont::Created, created + 1);
+    EXPECT_EQ(TestFont::Searched, searched + 1);
+    // resolved codepoints are not searched at all
+    for (int i = 0; i < 10; ++i) {
+        EXPECT(font->fallbackFor(0x4e00) == cjk);
+        EXPECT(font->fallbackFor(0x4e01) == cjk);
+    }
+    EXPECT_EQ(TestFont::Created, created + 1);
+    EXPECT_EQ(TestFont::Searched, searched + 1);
+}
+
+TEST(fallback_fonts, missNotSearched) {
+    TestFont * font = TestFont::Get(ui::Font{}, 12);
+    size_t created = TestFont::Created;
+    size_t deleted = TestFont::Deleted;
+    // no font supports the codepoint, so the new fallback font does not support it either and the font itself is used instead
+    TestFont * miss = font->fallbackFor(0x10fffd);
+    EXPECT(miss == font);
+    EXPECT_EQ(TestFont::Created, created + 1);
+    EXPECT_EQ(TestFont::Deleted, deleted + 1);
+    size_t searched = TestFont::Searched;
+    for (int i = 0; i < 10; ++i)
+        EXPECT(font->fallbackFor(0x10fffd) == miss);
+    EXPECT_EQ(TestFont::Created, created + 1);
+    EXPECT_EQ(TestFont::Searched, searched);
+    // other unsupported codepoints only search the font created for them, so no fonts are kept for the misses
+    EXPECT(font->fallbackFor(0x10fffc) == font);
+    EXPECT(font->fallbackFor(0x10fffb) == font);
+    EXPECT_EQ(TestFont::Searched, searched + 2);
+    EXPECT_EQ(TestFont::Created - TestFont::Deleted, created - deleted);
+}
+
+TEST(fallback_fonts, keyedByFontAndSize) {
+    TestFont * regular = TestFont::Get(ui::Font{}, 14);
+    TestFont * bold = TestFont::Get(ui::Font{}.setBold(), 14);
+    TestFont * large = TestFont::Get(ui::Font{}, 16);
+    size_t created = TestFont::Created;
+    TestFont * cjk = regular->fallbackFor(0x4e00);
+    EXPECT(bold->fallbackFor(0x4e00) != cjk);
+    EXPECT(large->fallbackFor(0x4e00) != cjk);
+    EXPECT_EQ(TestFont::Created, created + 3);
+    EXPECT(TestFont::Get(ui::Font{}, 14)->fallbackFor(0x4e00) == cjk);
+    EXPECT_EQ(TestFont::Created, created + 3);
+}
+
+#endif
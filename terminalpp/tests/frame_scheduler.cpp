@@ -0,0 +1,103 @@
+#if (defined RENDERER_HEADLESS)
+#include "helpers/tests.h"
+
+#include "test_window.h"
+
+using namespace tpp;
+
+// the frame interval at 4 fps is long enough for the repaints requested by a test to fit into it
+TEST(renderer_frame_scheduler, burstRendersSingleFrame) {
+    TestWindow w{20, 5};
+    w.setFps(4);
+    size_t frames = w.frames();
+    for (int i = 0; i < 10; ++i) {
+        w.widget()->cells().at(Point{i, 0}).setCodepoint('x');
+        w.repaintWidget();
+    }
+    EXPECT_EQ(w.waitForFrame(frames), frames + 1);
+    EXPECT(! w.damageAll());
+    EXPECT_EQ(w.damage().size(), 1);
+    EXPECT(w.damage()[0] == Rect(Point{0, 0}, Size{11, 1}));
+    // repaints requested right after the frame are delayed until the interval since the frame passes
+    for (int i = 0; i < 10; ++i) {
+        w.widget()->cells().at(Point{i, 1}).setCodepoint('y');
+        w.repaintWidget();
+    }
+    EXPECT_EQ(w.frames(), frames + 1);
+    EXPECT_EQ(w.waitForFrame(frames + 1), frames + 2);
+    // and no other frame follows
+    std::this_thread::sleep_for(std::chrono::milliseconds{400});
+    w.processEvents();
+    EXPECT_EQ(w.frames(), frames + 2);
+    w.setFps(0);
+}
+
+TEST(renderer_frame_scheduler, inputRendersImmediately) {
+    TestWindow w{20, 5};
+    w.setFps(4);
+    size_t frames = w.frames();
+    w.widget()->cells().at(Point{0, 0}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(w.waitForFrame(frames), frames + 1);
+    // the first repaint after the input is rendered without waiting for the frame interval
+    w.keyChar(Char{'a'});
+    w.widget()->cells().at(Point{1, 0}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(w.frames(), frames + 2);
+    // but the repaints after it are not
+    w.widget()->cells().at(Point{2, 0}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(w.frames(), frames + 2);
+    EXPECT_EQ(w.waitForFrame(frames + 2), frames + 3);
+    w.setFps(0);
+}
+
+TEST(renderer_frame_scheduler, immediateFrameKeepsScheduledFrame) {
+    TestWindow w{20, 5};
+    TestWidget * a = new TestWidget{Size{10, 5}};
+    TestWidget * b = new TestWidget{Size{10, 5}};
+    a->setBackground(Color::Black);
+    b->setBackground(Color::Black);
+    w.widget()->attachChild(a);
+    w.widget()->attachChild(b);
+    b->move(Point{10, 0});
+    w.setFps(4);
+    w.repaintWidget();
+    size_t frames = w.waitForFrame(w.frames());
+    // the scheduler posts a frame for the repaint, which is not processed yet
+    a->repaint();
+    std::this_thread::sleep_for(std::chrono::milliseconds{400});
+    // an immediate frame is painted before the scheduled one
+    w.keyChar(Char{'a'});
+    b->repaint();
+    EXPECT_EQ(w.frames(), frames + 1);
+    // the next repaint is painted by the scheduled frame, no other frame is posted for it
+    a->repaint();
+    std::this_thread::sleep_for(std::chrono::milliseconds{400});
+    size_t events = 0;
+    while (TestApplication()->eventQueue().processEvent())
+        ++events;
+    EXPECT_EQ(events, 1);
+    EXPECT_EQ(w.frames(), frames + 2);
+    w.setFps(0);
+}
+
+TEST(renderer_frame_scheduler, slowFrameDelaysNext) {
+    TestWindow w{20, 5};
+    w.setFps(100);
+    size_t frames = w.frames();
+    w.widget()->cells().at(Point{0, 0}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(w.waitForFrame(frames), frames + 1);
+    // the duration of the drawn frame, not the frame rate, determines the interval when the frame is slower
+    w.frameRendered(std::chrono::milliseconds{400});
+    w.widget()->cells().at(Point{1, 0}).setCodepoint('x');
+    w.repaintWidget();
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    w.processEvents();
+    EXPECT_EQ(w.frames(), frames + 1);
+    EXPECT_EQ(w.waitForFrame(frames + 1), frames + 2);
+    w.setFps(0);
+}
+
+#endif
@@ -0,0 +1,59 @@
+#if (defined RENDERER_HEADLESS)
+#include "helpers/tests.h"
+
+#include "test_window.h"
+
+using namespace tpp;
+
+namespace {
+
+    /** Window that draws the frames later than they are requested, like X11Window which draws them when it processes the expose event posted by render().
+     */
+    class DeferredWindow : public TestWindow {
+    public:
+        DeferredWindow(int cols, int rows):
+            TestWindow{cols, rows} {
+        }
+
+    protected:
+        void render(Rect const & rect) override {
+            renderRect_ = renderRect_.empty() ? rect : (renderRect_ | rect);
+            Renderer::schedule([this](){
+                Rect rect = renderRect_;
+                renderRect_ = Rect{};
+                TestWindow::render(rect);
+            });
+        }
+
+    private:
+        Rect renderRect_;
+    }; // DeferredWindow
+
+}
+
+TEST(frame_stats, paintTime) {
+    TestWindow w{20, 5};
+    w.widget()->cells().at(Point{0, 0}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT(w.frameStats().paintTime.last() > 0);
+}
+
+TEST(frame_stats, paintTimeOfDeferredFrames) {
+    DeferredWindow w{20, 5};
+    size_t frames = w.frames();
+    w.widget()->cells().at(Point{0, 0}).setCodepoint('x');
+    w.repaintWidget();
+    EXPECT_EQ(w.frames(), frames + 1);
+    EXPECT(w.frameStats().paintTime.last() > 0);
+    // frames rendered without painting have no paint time
+    w.widget()->cells().at(Point{0, 0}).font().setBlink();
+    w.repaintWidget();
+    TestWindow::BlinkTick();
+    w.processEvents();
+    TestWindow::BlinkTick();
+    w.processEvents();
+    EXPECT_EQ(w.frames(), frames + 4);
+    EXPECT_EQ(w.frameStats().paintTime.last(), 0);
+}
+
+#endif
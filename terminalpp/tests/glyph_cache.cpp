@@ -0,0 +1,99 @@
+#if (defined RENDERER_HEADLESS)
+#include "helpers/tests.h"
+
+#include "../headless/headless_font.h"
+
+#include "test_window.h"
+
+using namespace tpp;
+
+namespace {
+
+    class TestGlyph {
+    public:
+        int const * font = nullptr;
+        unsigned index = 0;
+    }; // TestGlyph
+
+    /** Glyph cache that counts the lookups of the glyphs not found in it.
+     */
+    class CountingCache {
+    public:
+        explicit CountingCache(size_t capacity):
+            cache{capacity} {
+        }
+
+        TestGlyph get(char32_t codepoint) {
+            return cache.get(codepoint, [this](char32_t c) {
+                ++lookups;
+                return TestGlyph{& font, static_cast<unsigned>(c) + 1};
+            });
+        }
+
+        GlyphCache<TestGlyph> cache;
+        int font = 0;
+        size_t lookups = 0;
+    }; // CountingCache
+
+}
+
+TEST(glyph_cache, latin1) {
+    CountingCache c{4};
+    for (char32_t cp = 0; cp < GlyphCache<TestGlyph>::LATIN1; ++cp)
+        EXPECT_EQ(c.get(cp).index, static_cast<unsigned>(cp) + 1);
+    EXPECT_EQ(c.lookups, 256);
+    for (char32_t cp = 0; cp < GlyphCache<TestGlyph>::LATIN1; ++cp)
+        c.get(cp);
+    EXPECT_EQ(c.lookups, 256);
+    EXPECT_EQ(c.cache.mapSize(), 0);
+}
+
+TEST(glyph_cache, eviction) {
+    CountingCache c{4};
+    c.get('a');
+    for (char32_t cp = 0x400; cp < 0x404; ++cp)
+        c.get(cp);
+    EXPECT_EQ(c.lookups, 5);
+    EXPECT_EQ(c.cache.mapSize(), 4);
+    c.get(0x401);
+    EXPECT_EQ(c.lookups, 5);
+    // the map is emptied when full, the table keeps its glyphs
+    EXPECT_EQ(c.get(0x404).index, 0x405u);
+    EXPECT_EQ(c.lookups, 6);
+    EXPECT_EQ(c.cache.mapSize(), 1);
+    EXPECT_EQ(c.get(0x401).index, 0x402u);
+    EXPECT_EQ(c.lookups, 7);
+    c.get('a');
+    EXPECT_EQ(c.lookups, 7);
+}
+
+TEST(glyph_cache, keyedByFontAndSize) {
+    TestApplication();
+    HeadlessFont * regular = HeadlessFont::Get(ui::Font{}, 16);
+    HeadlessFont * bold = HeadlessFont::Get(ui::Font{}.setBold(), 16);
+    HeadlessFont * large = HeadlessFont::Get(ui::Font{}, 24);
+    EXPECT(HeadlessFont::Get(ui::Font{}, 16) == regular);
+    EXPECT(regular != bold);
+    EXPECT(regular != large);
+    // each font caches its own glyphs
+    for (HeadlessFont * f : { regular, bold, large }) {
+        HeadlessFont::Glyph g = f->glyphFor('a');
+        EXPECT(g.font == f);
+        EXPECT(g.index != 0);
+        EXPECT(f->glyphFor('a').font == f);
+        EXPECT(f->glyphFor(0x2500).font == f);
+    }
+    EXPECT_EQ(regular->glyphFor('a').index, large->glyphFor('a').index);
+    // codepoints the font does not support are cached with their fallback font, which is specific to the font's size (U+01C4 is in DejaVu Sans, but not in DejaVu Sans Mono)
+    HeadlessFont::Glyph g = regular->glyphFor(0x1c4);
+    EXPECT(g.font != regular);
+    EXPECT(g.index != 0);
+    EXPECT(g.font == regular->fallbackFor(0x1c4));
+    EXPECT(regular->glyphFor(0x1c4).font == g.font);
+    EXPECT(large->glyphFor(0x1c4).font != g.font);
+    // codepoints no installed font supports are cached with the font itself
+    EXPECT(regular->glyphFor(0x4e00).font == regular);
+    EXPECT_EQ(regular->glyphFor(0x4e00).index, 0);
+}
+
+#endif
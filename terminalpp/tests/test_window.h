@@ -0,0 +1,150 @@
+#pragma once
+#if (defined RENDERER_HEADLESS)
+
+#include "helpers/tests.h"
+
+#include "ui/widget.h"
+
+#include "../config.h"
+#include "../headless/headless_application.h"
+#include "../headless/headless_window.h"
+
+namespace tpp {
+
+    /** Returns the headless application, initializing it when first called.
+
+        The font is set explicitly so that the default does not have to be detected.
+     */
+    inline HeadlessApplication * TestApplication() {
+        if (HeadlessApplication::Instance() == nullptr) {
+            JSON fontConfig = JSON::Object();
+            fontConfig.add("family", JSON{"DejaVu Sans Mono"});
+            fontConfig.add("doubleWidthFamily", JSON{"DejaVu Sans Mono"});
+            fontConfig.add("size", JSON{16});
+            JSON rendererConfig = JSON::Object();
+            rendererConfig.add("font", std::move(fontConfig));
+            JSON config = JSON::Object();
+            config.add("renderer", std::move(rendererConfig));
+            Config::Instance().set(config);
+            HeadlessApplication::Initialize();
+        }
+        return HeadlessApplication::Instance();
+    }
+
+    /** Widget that paints the cells of its buffer, which are modified by the tests directly, the cursor, if set, and its children.
+     */
+    class TestWidget : public ui::Widget {
+    public:
+        explicit TestWidget(Size size):
+            cells_{size} {
+        }
+
+        Canvas::Buffer & cells() {
+            return cells_;
+        }
+
+        /** Attaches given widget as a child, which is then owned by the test widget.
+         */
+        void attachChild(Widget * child) {
+            attach(child);
+        }
+
+        void setCursor(Canvas::Cursor const & cursor, Point position) {
+            cursor_ = cursor;
+            cursorPosition_ = position;
+            hasCursor_ = true;
+        }
+
+    protected:
+
+        void paint(Canvas & canvas) override {
+            canvas.drawBuffer(cells_, Point{0, 0});
+            if (hasCursor_)
+                canvas.setCursor(cursor_, cursorPosition_);
+            Widget::paint(canvas);
+        }
+
+    private:
+        Canvas::Buffer cells_;
+        Canvas::Cursor cursor_;
+        Point cursorPosition_;
+        bool hasCursor_ = false;
+    }; // tpp::TestWidget
+
+    /** Headless window with a TestWidget root that exposes the renderer's state to the tests.
+
+        The window is shown and its first frame, which redraws the entire window, is rendered when created.
+     */
+    class TestWindow : public HeadlessWindow {
+    public:
+        TestWindow(int cols, int rows):
+            HeadlessWindow{"test", cols, rows, TestApplication()->eventQueue()},
+            widget_{new TestWidget{Size{cols, rows}}} {
+            setRoot(widget_);
+            show();
+            processEvents();
+        }
+
+        ~TestWindow() override {
+            setRoot(nullptr);
+            delete widget_;
+        }
+
+        TestWidget * widget() {
+            return widget_;
+        }
+
+        /** Processes all events pending in the UI event queue, including any repaints and renders.
+         */
+        void processEvents() {
+            TestApplication()->mainLoop();
+        }
+
+        /** Repaints the widget and processes the events so that the frame is rendered unless the frame scheduler delays it.
+         */
+        void repaintWidget() {
+            widget_->repaint();
+            processEvents();
+        }
+
+        size_t frames() const {
+            return frameStats().frames();
+        }
+
+        /** Processes the events until a frame after the given number of frames has been rendered, or the timeout expires. Returns the number of frames rendered.
+         */
+        size_t waitForFrame(size_t frames, std::chrono::milliseconds timeout = std::chrono::milliseconds{2000}) {
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + timeout;
+            processEvents();
+            while (this->frames() == frames && std::chrono::steady_clock::now() < end) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{5});
+                processEvents();
+            }
+            return this->frames();
+        }
+
+        std::vector<Rect> const & damage() const {
+            return damage_;
+        }
+
+        bool damageAll() const {
+            return damageAll_;
+        }
+
+        void setBatchRuns(bool value) {
+            batchRuns_ = value;
+        }
+
+        using HeadlessWindow::buffer;
+        using HeadlessWindow::setFps;
+        using HeadlessWindow::frameRendered;
+        using HeadlessWindow::keyChar;
+        using HeadlessWindow::BlinkTick;
+
+    private:
+        TestWidget * widget_;
+    }; // tpp::TestWindow
+
+} // namespace tpp
+
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <vector>
 #include <thread>
 #include <mutex>
 
@@ -15,6 +17,7 @@
 
 #include "application.h"
 #include "font.h"
+#include "frame_stats.h"
 
 namespace tpp {
 
@@ -87,6 +90,52 @@ namespace tpp {
                 return Color::Black;
         }
 
+        /** Returns the statistics of the frames rendered by the window. 
+         */
+        FrameStats const & frameStats() const {
+            return frameStats_;
+        }
+
+        /** Contents painted by the window itself over its widgets, such as the frame statistics.
+
+            The overlay is painted on the buffer by every render after the widgets have been painted. Unlike a widget in front of the others, the overlay covers only the rectangle it paints and the widgets beneath it do not have to be repainted together with it.
+         */
+        class Overlay {
+        public:
+            virtual ~Overlay() = default;
+
+            /** Paints the overlay on the canvas of the entire buffer and returns the rectangle it covered.
+             */
+            virtual Rect paint(Canvas & canvas) = 0;
+        }; // Window::Overlay
+
+        Overlay * overlay() const {
+            return overlay_;
+        }
+
+        /** Sets the overlay, or nullptr if none.
+
+            The whole window is repainted so that the cells covered by the previous overlay are restored. The window does not own the overlay.
+         */
+        void setOverlay(Overlay * value) {
+            if (overlay_ != value) {
+                overlay_ = value;
+                repaint();
+            }
+        }
+
+        /** Renders the overlay again without repainting the widgets.
+
+            The frame is not recorded in the frame statistics so that an overlay displaying them does not skew them by its own refreshes. 
+         */
+        void renderOverlay() {
+            if (overlay_ != nullptr) {
+                overlayOnly_ = true;
+                render(Rect{});
+                overlayOnly_ = false;
+            }
+        }
+
     /** \name Window Closing. 
 
         To request a window to close, the requestClose() method should be called, which triggers the onClose event. Unless deactivated in the handler, the close() method will be called immediately after the event is serviced. The close() method then actually closes the window. 
@@ -212,6 +261,14 @@ namespace tpp {
         /** Mouse buttons that are currently down so that we know when to release the mouse capture. */
         unsigned mouseButtonsDown_ = 0;
 
+        FrameStats frameStats_;
+
+        Overlay * overlay_ = nullptr;
+
+        /** True while the overlay is rendered on its own, see renderOverlay(). 
+         */
+        bool overlayOnly_ = false;
+
     }; // tpp::Window
 
     /** Templated child of the Window that provides support for fast rendering via CRTP. 
@@ -283,8 +340,10 @@ namespace tpp {
         }
 
 
-        /** Starts the blinker thread that runs for the duration of the application and periodically repaints all windows so that blinking text is properly displayed. 
+        /** Starts the blinker thread that runs for the duration of the application and periodically toggles the blink visibility. 
          
+            Only windows that display blinking text or a blinking cursor are rendered afterwards, and since the contents of the buffer did not change, the widgets are not repainted. The render itself only redraws the blinking cells and the cursor where the implementation retains the previous frame. 
+
             The method must be called by the Application instance startup.  
          */
         static void StartBlinkerThread() {
@@ -293,17 +352,30 @@ namespace tpp {
                 GlobalState_->blinkVisible = true;
                 while (true) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(GlobalState_->blinkSpeed));
-                    GlobalState_->blinkVisible = ! GlobalState_->blinkVisible;
-                    {
-                        std::lock_guard<std::mutex> g(GlobalState_->mWindows);
-                        for (auto i : GlobalState_->windows)
-                            i.second->repaint();
-                    }
+                    BlinkTick();
                 }
             });
             t.detach();
         }
 
+        /** Toggles the blink visibility and schedules the render of the windows that display blinking text or a blinking cursor. 
+         
+            Called by the blinker thread periodically. 
+         */
+        static void BlinkTick() {
+            ASSERT(GlobalState_ != nullptr);
+            GlobalState_->blinkVisible = ! GlobalState_->blinkVisible;
+            std::lock_guard<std::mutex> g(GlobalState_->mWindows);
+            for (auto i : GlobalState_->windows) {
+                if (i.second->blinking_) {
+                    IMPLEMENTATION * window = i.second;
+                    window->Renderer::schedule([window](){
+                        window->renderBlink();
+                    });
+                }
+            }
+        }
+
         /** Global state for the window management and rendering. 
          
             Because the blinker thread is detached, the global state must be heap allocated so that the objects here are never deallocated in case the blinker thread will execute after the main function ends. 
@@ -334,109 +406,367 @@ namespace tpp {
 
         using Renderer::render;
 
-        void render(Rect const & rect) override {
-            MARK_AS_UNUSED(rect);
-            // then actually render the entire window
-            Stopwatch t;
-            t.start();
+        /** Renders the buffer. 
+         
+            If the implementation retains the previously rendered frame (see retainsFrame_), only the cells in the rows of the given rectangle that differ from the last rendered frame are redrawn. For each row the damaged span of cells is widened by one cell on each side so that glyphs overhanging their cells are redrawn as well. The whole window is redrawn when the size of the buffer, cells, or window, or the window background changed, or when the last frame contained glyphs taller than a single row as these overlap their neighbouring rows. When the blink state changes, all blinking cells are damaged regardless of the rectangle. The cell the cursor was drawn at last time is always damaged so that the cursor can be erased. 
+
+            If the window has an overlay, it is painted on the buffer first and the rectangle it covers is rendered together with the given one. 
+
+            The redrawn parts are reported to the implementation's finalizeDraw() in damage_ and damageAll_. The statistics of the frame are counted as the implementation's drawing functions are called and recorded in frameStats_ after the frame has been finalized, unless only the overlay is rendered. 
+         */
+        void render(Rect const & renderRect) override {
+            // time the rendering
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            frame_ = FrameStats::Frame{};
+            // paint the overlay over the widgets
+            Rect rect = renderRect;
+            if (overlay() != nullptr) {
+                Canvas canvas = bufferCanvas();
+                Rect overlayRect = overlay()->paint(canvas);
+                rect = rect.empty() ? overlayRect : (rect | overlayRect);
+            }
             // shorthand to the buffer
             Buffer const & buffer = this->buffer();
+            int cols = buffer.width();
+            int rows = buffer.height();
+            // determine the cursor, its visibility and its position. The cursor is drawn when it is not blinking, when its position has changed since last time it was drawn with blink on or if it is blinking and blink is visible. This prevents the cursor for disappearing while moving
+            Point cursorPos = buffer.cursorPosition();
+            Canvas::Cursor cursor = buffer.cursor();
+            bool drawCursor = buffer.contains(cursorPos) && cursor.visible() && (! cursor.blink() || BlinkVisible() || cursorPos != lastCursorPos_);
+            bool blinkVisible = BlinkVisible();
+            // determine the damaged span of each row, the left column is inclusive, the right column exclusive
+            damageAll_ = ! retainsFrame_ 
+                || lastFrame_.size() != buffer.size() 
+                || lastFrameSizePx_ != sizePx_ 
+                || lastFrameCellSize_ != cellSize_ 
+                || lastFrameBackground_ != backgroundColor() 
+                || lastFrameTall_;
+            damageLeft_.assign(rows, cols);
+            damageRight_.assign(rows, 0);
+            if (! damageAll_) {
+                bool blinkChanged = blinkVisible != lastFrameBlink_;
+                damageAll_ = ! detectDamage(buffer, rect & Rect{buffer.size()}, blinkChanged);
+            }
+            if (! damageAll_) {
+                damageCells(lastCursorRect_);
+                if (drawCursor)
+                    damageCells(Rect{cursorPos, Size{buffer.at(cursorPos).font().width(), 1}});
+                for (int row = 0; row < rows; ++row) {
+                    if (damageLeft_[row] < damageRight_[row]) {
+                        damageLeft_[row] = std::max(0, damageLeft_[row] - 1);
+                        damageRight_[row] = std::min(cols, damageRight_[row] + 1);
+                    }
+                }
+            } else {
+                damageLeft_.assign(rows, 0);
+                damageRight_.assign(rows, cols);
+            }
             // initialize the drawing and set the state for the first cell
             initializeDraw();
             state_ = buffer.at(0,0);
+            ++frame_.fontChanges;
             changeFont(state_.font());
+            frame_.colorChanges += 3;
             changeFg(state_.fg());
             changeBg(state_.bg());
             changeDecor(state_.decor());
-            // loop over the buffer and draw the cells
-            for (int row = 0, re = height(); row < re; ++row) {
-                initializeGlyphRun(0, row);
-                for (int col = 0, ce = width(); col < ce; ) {
+            // loop over the damaged spans of the buffer and draw the cells, glyph runs are only counted when they contain any glyphs
+            bool tall = false;
+            for (int row = 0; row < rows; ++row) {
+                int col = 0;
+                int ce = damageRight_[row];
+                if (damageLeft_[row] >= ce)
+                    continue;
+                // start at the cell that covers the left of the damaged span (double width or larger font)
+                while (col + buffer.at(col, row).font().width() <= damageLeft_[row])
+                    col += buffer.at(col, row).font().width();
+                damageLeft_[row] = col;
+                runStart_ = frame_.cells;
+                initializeGlyphRun(col, row);
+                for (; col < ce; ) {
                     Cell const & c = buffer.at(col, row);
                     // detect if there were changes in the font & colors and update the state & draw the glyph run if present. The code looks a bit ugly as we have to first draw the glyph run and only then change the state.
                     bool drawRun = true;
                     if (state_.font() != c.font()) {
                         if (drawRun) {
+                            frame_.glyphRuns += (frame_.cells != runStart_);
                             drawGlyphRun();
+                            runStart_ = frame_.cells;
                             initializeGlyphRun(col, row);
                             drawRun = false;
                         }
+                        ++frame_.fontChanges;
                         changeFont(c.font());
                         state_.setFont(c.font());
                     }
                     if (state_.fg() != c.fg()) {
                         if (drawRun) {
+                            frame_.glyphRuns += (frame_.cells != runStart_);
                             drawGlyphRun();
+                            runStart_ = frame_.cells;
                             initializeGlyphRun(col, row);
                             drawRun = false;
                         }
+                        ++frame_.colorChanges;
                         changeFg(c.fg());
                         state_.setFg(c.fg());
                     }
                     if (state_.bg() != c.bg()) {
                         if (drawRun) {
+                            frame_.glyphRuns += (frame_.cells != runStart_);
                             drawGlyphRun();
+                            runStart_ = frame_.cells;
                             initializeGlyphRun(col, row);
                             drawRun = false;
                         }
+                        ++frame_.colorChanges;
                         changeBg(c.bg());
                         state_.setBg(c.bg());
                     }
                     if (state_.decor() != c.decor()) {
                         if (drawRun) {
+                            frame_.glyphRuns += (frame_.cells != runStart_);
                             drawGlyphRun();
+                            runStart_ = frame_.cells;
                             initializeGlyphRun(col, row);
                             drawRun = false;
                         }
+                        ++frame_.colorChanges;
                         changeDecor(c.decor());
                         state_.setDecor(c.decor());
                     }
+                    tall = tall || c.font().height() > 1;
                     // we don't care about the border at this stage
                     // draw the cell
+                    ++frame_.cells;
                     addGlyph(col, row, c);
                     // move to the next column (skip invisible cols if double width or larger font)
                     col += c.font().width();
                 }
+                damageRight_[row] = std::min(col, cols);
+                frame_.glyphRuns += (frame_.cells != runStart_);
                 drawGlyphRun();
             }
             
-            // determine the cursor, its visibility and its position and draw it if necessary. The cursor is drawn when it is not blinking, when its position has changed since last time it was drawn with blink on or if it is blinking and blink is visible. This prevents the cursor for disappearing while moving
-            Point cursorPos = buffer.cursorPosition();
-            Canvas::Cursor cursor = buffer.cursor();
-            if (buffer.contains(cursorPos) && cursor.visible() && (! cursor.blink() || BlinkVisible() || cursorPos != lastCursorPos_)) {
+            // draw the cursor if necessary
+            lastCursorRect_ = Rect{};
+            if (drawCursor) {
                 state_.setCodepoint(cursor.codepoint());
                 state_.setFg(cursor.color());
                 state_.setBg(Color::None);
                 state_.setFont(buffer.at(cursorPos).font());
+                ++frame_.fontChanges;
                 changeFont(state_.font());
+                frame_.colorChanges += 2;
                 changeFg(state_.fg());
                 changeBg(state_.bg());
                 initializeGlyphRun(cursorPos.x(), cursorPos.y());
+                ++frame_.cells;
                 addGlyph(cursorPos.x(), cursorPos.y(), state_);
+                ++frame_.glyphRuns;
                 drawGlyphRun();
                 if (BlinkVisible())
                     lastCursorPos_ = cursorPos;
+                lastCursorRect_ = Rect{cursorPos, Size{state_.font().width(), 1}};
             }
 
             // finally, draw the border, which is done on the base cell level over the already drawn text
             int wThin = std::min(cellSize_.width(), cellSize_.height()) / 4;
             int wThick = std::min(cellSize_.width(), cellSize_.height()) / 2;
             Color borderColor = buffer.at(0,0).border().color();
+            ++frame_.colorChanges;
             changeBg(borderColor);
-            for (int row = 0, re = height(); row < re; ++row) {
-                for (int col = 0, ce = width(); col < ce; ++col) {
+            for (int row = 0; row < rows; ++row) {
+                for (int col = damageLeft_[row], ce = damageRight_[row]; col < ce; ++col) {
                     Border b = buffer.at(col, row).border();
                     if (b.color() != borderColor) {
                         borderColor = b.color();
+                        ++frame_.colorChanges;
                         changeBg(borderColor);
                     }
                     if (! b.empty())
                         drawBorder(col, row, b, wThin, wThick);
                 }
             }
+            // remember the rendered frame and report the damaged rectangles, merging rows with identical spans
+            damage_.clear();
+            if (retainsFrame_) {
+                lastFrame_.resize(buffer.size());
+                for (int row = 0; row < rows; ++row) {
+                    int left = damageLeft_[row];
+                    int right = damageRight_[row];
+                    if (left >= right)
+                        continue;
+                    lastFrame_.copyRow(row, left, buffer, Point{left, row}, right - left);
+                    if (! damageAll_) {
+                        if (! damage_.empty() && damage_.back().bottom() == row && damage_.back().left() == left && damage_.back().right() == right)
+                            damage_.back().resize(Size{right - left, damage_.back().height() + 1});
+                        else
+                            damage_.push_back(Rect{Point{left, row}, Size{right - left, 1}});
+                    }
+                }
+                lastFrameSizePx_ = sizePx_;
+                lastFrameCellSize_ = cellSize_;
+                lastFrameBackground_ = backgroundColor();
+                lastFrameBlink_ = blinkVisible;
+                lastFrameTall_ = tall;
+            }
+            // update the rows with blinking cells and determine whether the window has to be rendered when blink visibility changes
+            blinkRows_.resize(rows, false);
+            bool blinking = buffer.contains(cursorPos) && cursor.visible() && cursor.blink();
+            for (int row = 0; row < rows; ++row) {
+                if (damageLeft_[row] < damageRight_[row])
+                    blinkRows_[row] = RowBlinks(buffer, row);
+                blinking = blinking || blinkRows_[row];
+            }
+            blinking_ = blinking;
             finalizeDraw();
+            frame_.renderTime = std::chrono::steady_clock::now() - start;
+            // frames rendering only the overlay are not recorded, their paint time is left for the next recorded frame
+            if (! overlayOnly_) {
+                frame_.paintTime = takePaintDuration();
+                frameStats_.add(frame_);
+            }
+            frameRendered(frame_.paintTime + frame_.renderTime);
+        }
+
+        /** Renders the window after the blink visibility changed. 
+         
+            Only the blinking cells and the cursor are damaged by the change, which the render detects itself, so an empty rectangle is rendered. 
+         */
+        void renderBlink() {
+            render(Rect{});
+        }
+
+        /** Determines whether the implementation keeps the contents of its drawing surface between frames so that only the damaged cells have to be redrawn. 
+         
+            Defaults to false, in which case the whole window is redrawn every time. 
+         */
+        bool retainsFrame_ = false;
+
+        /** The rectangles (in cells) that have been redrawn by the last render() call. 
+         
+            Valid only when damageAll_ is false. 
+         */
+        std::vector<Rect> damage_;
+
+        /** True if the entire window has been redrawn by the last render() call. 
+         */
+        bool damageAll_ = true;
+
+        /** Statistics of the frame being rendered. 
+         
+            The implementation may add the requests and bytes sent to the display server in its finalizeDraw(). 
+         */
+        FrameStats::Frame frame_;
+
+    private:
+
+        /** Compares the rows of the buffer in given rectangle with the last rendered frame and updates the damaged spans accordingly. 
+
+            The buffer and the last frame are walked simultaneously, cell by cell as they are drawn, so that a change of a cell's width, which affects the cells drawn after it, damages all cells whose drawing changed. If blinkChanged is true, all blinking cells are damaged too, including those in rows outside of the rectangle. Returns false if the frame contains cells taller than a single row, in which case the entire window must be redrawn. 
+         */
+        bool detectDamage(Buffer const & buffer, Rect const & rect, bool blinkChanged) {
+            int ce = buffer.width();
+            for (int row = rect.top(), re = rect.bottom(); row < re; ++row) {
+                int col = 0;
+                int lastCol = 0;
+                while (col < ce || lastCol < ce) {
+                    if (col == lastCol) {
+                        Cell const & c = buffer.at(col, row);
+                        if (c.font().height() > 1)
+                            return false;
+                        int w = c.font().width();
+                        int lastW = lastFrame_.at(col, row).font().width();
+                        bool damaged = w != lastW || (blinkChanged && c.font().blink());
+                        for (int i = col, e = std::min(col + w, ce); ! damaged && i < e; ++i)
+                            damaged = buffer.at(i, row) != lastFrame_.at(i, row);
+                        if (damaged)
+                            damageCells(Rect{Point{col, row}, Size{std::max(w, lastW), 1}});
+                        col += w;
+                        lastCol += lastW;
+                    } else if (col < lastCol) {
+                        // cell drawn now that was covered by a larger cell in the last frame
+                        Cell const & c = buffer.at(col, row);
+                        if (c.font().height() > 1)
+                            return false;
+                        damageCells(Rect{Point{col, row}, Size{c.font().width(), 1}});
+                        col += c.font().width();
+                    } else {
+                        // cell drawn in the last frame that is covered by a larger cell now
+                        int lastW = lastFrame_.at(lastCol, row).font().width();
+                        damageCells(Rect{Point{lastCol, row}, Size{lastW, 1}});
+                        lastCol += lastW;
+                    }
+                }
+            }
+            if (blinkChanged) {
+                for (int row = 0, re = buffer.height(); row < re; ++row) {
+                    if (! blinkRows_[row] || (row >= rect.top() && row < rect.bottom()))
+                        continue;
+                    for (int col = 0; col < ce; ) {
+                        Cell const & c = buffer.at(col, row);
+                        if (c.font().blink())
+                            damageCells(Rect{Point{col, row}, Size{c.font().width(), 1}});
+                        col += c.font().width();
+                    }
+                }
+            }
+            return true;
+        }
+
+        /** Returns true if given row of the buffer contains any blinking cells. 
+         */
+        static bool RowBlinks(Buffer const & buffer, int row) {
+            for (int col = 0, ce = buffer.width(); col < ce; ) {
+                Cell const & c = buffer.at(col, row);
+                if (c.font().blink())
+                    return true;
+                col += c.font().width();
+            }
+            return false;
+        }
+
+        /** Adds given rectangle (in cells) to the damaged spans. 
+         */
+        void damageCells(Rect const & rect) {
+            Rect r = rect & Rect{buffer().size()};
+            for (int row = r.top(), re = r.bottom(); row < re; ++row) {
+                damageLeft_[row] = std::min(damageLeft_[row], r.left());
+                damageRight_[row] = std::max(damageRight_[row], r.right());
+            }
         }
 
+        /** The last rendered frame. 
+         */
+        Buffer lastFrame_{Size{0, 0}};
+        Size lastFrameSizePx_;
+        Size lastFrameCellSize_;
+        Color lastFrameBackground_;
+        bool lastFrameBlink_ = false;
+        bool lastFrameTall_ = false;
+
+        /** The cells covered by the cursor when it was last drawn, empty if the cursor was not drawn. 
+         */
+        Rect lastCursorRect_;
+
+        std::vector<int> damageLeft_;
+        std::vector<int> damageRight_;
+
+        /** Number of cells drawn in the frame when the current glyph run was initialized. 
+         */
+        size_t runStart_ = 0;
+
+        /** Rows of the last rendered frame that contain blinking cells. 
+         */
+        std::vector<bool> blinkRows_;
+
+        /** True if the last rendered frame contains blinking cells, or a blinking cursor. 
+         
+            Read by the blinker thread to determine which windows must be rendered. 
+         */
+        std::atomic<bool> blinking_{false};
+
         #undef initializeDraw
         #undef initializeGlyphRun
         #undef addGlyph
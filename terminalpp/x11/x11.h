@@ -9,6 +9,9 @@
 #include <X11/Xcursor/Xcursor.h>
 #include <X11/extensions/Xrender.h>
 #include <fontconfig/fontconfig.h>
+#if (defined RENDERER_X11_XCB)
+    #include <X11/Xlib-xcb.h>
+#endif
 
 #undef None
 #undef RootWindow
@@ -1,5 +1,7 @@
 #if (defined ARCH_LINUX && defined RENDERER_NATIVE)
 #include <cmath>
+#include <cstring>
+#include <vector>
 
 #include "x11_font.h"
 
@@ -86,6 +88,20 @@ namespace tpp {
         underlineThickness_ = font_.size();
         strikethroughOffset_ = ascent_ * 2 / 3;
         strikethroughThickness_ = font_.size();
+        initializeRasterization();
+    }
+
+    void X11Font::initializeRasterization() {
+        loadFlags_ = FreeTypeLoadFlags(xftFont_->pattern, embolden_);
+    }
+
+    void X11Font::rasterizeGlyph(FT_UInt index, GlyphBitmap & bitmap) {
+        // locking the face also sets its size and transformation matrix as specified by the font
+        FT_Face face = XftLockFace(xftFont_);
+        if (face == nullptr)
+            return;
+        RasterizeGlyph(face, index, loadFlags_, embolden_, bitmap);
+        XftUnlockFace(xftFont_);
     }
 
     XftFont * X11Font::MatchFont(FcPattern * pattern) {
@@ -2,6 +2,7 @@
 #if (defined ARCH_UNIX && defined RENDERER_NATIVE)
 
 #include <unordered_map>
+#include <vector>
 
 #include "helpers/helpers.h"
 
@@ -11,12 +12,21 @@
 #include "x11_application.h"
 
 #include "../config.h"
+#include "../rasterization.h"
 
 namespace tpp {
 
     class X11Font : public Font<X11Font> {
     public:
 
+        /** Glyph of a codepoint, i.e. the font that renders the codepoint and the index of the codepoint's glyph in it. 
+         */
+        class Glyph {
+        public:
+            X11Font * font = nullptr;
+            FT_UInt index = 0;
+        }; // tpp::X11Font::Glyph
+
         ~X11Font() override {
             CloseFont(xftFont_);
             FcPatternDestroy(pattern_);
@@ -30,6 +40,27 @@ namespace tpp {
             return XftCharIndex(X11Application::Instance()->xDisplay_, xftFont_, codepoint) != 0;
         }
 
+        /** Returns the glyph for given codepoint. 
+         
+            If the font does not support the codepoint, the glyph from a fallback font is returned. The glyphs are cached on first use, see GlyphCache. 
+         */
+        Glyph glyphFor(char32_t codepoint) {
+            return glyphs_.get(codepoint, [this](char32_t c) { return lookupGlyph(c); });
+        }
+
+        /** Returns the rasterized glyph with given index. 
+         
+            The glyphs are rasterized on first use and cached. 
+         */
+        GlyphBitmap const & glyphBitmap(FT_UInt index) {
+            auto i = glyphBitmaps_.find(index);
+            if (i == glyphBitmaps_.end()) {
+                i = glyphBitmaps_.insert(std::make_pair(index, GlyphBitmap{})).first;
+                rasterizeGlyph(index, i->second);
+            }
+            return i->second;
+        }
+
     private:
         friend class Font<X11Font>;
 
@@ -39,9 +70,32 @@ namespace tpp {
 
         void initializeFromPattern();
 
+        /** Determines the FreeType load flags matching those Xft would use for the font. 
+         */
+        void initializeRasterization();
+
+        /** Rasterizes the glyph with FreeType. 
+         */
+        void rasterizeGlyph(FT_UInt index, GlyphBitmap & bitmap);
+
+        Glyph lookupGlyph(char32_t codepoint) {
+            Glyph result{this, XftCharIndex(X11Application::Instance()->xDisplay_, xftFont_, codepoint)};
+            if (result.index == 0) {
+                result.font = fallbackFor(codepoint);
+                result.index = XftCharIndex(X11Application::Instance()->xDisplay_, result.font->xftFont_, codepoint);
+            }
+            return result;
+        }
+
         XftFont * xftFont_;
         FcPattern * pattern_;
 
+        GlyphCache<Glyph> glyphs_;
+
+        FT_Int32 loadFlags_ = FT_LOAD_DEFAULT;
+        bool embolden_ = false;
+        std::unordered_map<FT_UInt, GlyphBitmap> glyphBitmaps_;
+
         static XftFont * MatchFont(FcPattern * pattern);
 
         static void CloseFont(XftFont * font);
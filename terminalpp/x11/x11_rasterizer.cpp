@@ -0,0 +1,277 @@
+#if (defined ARCH_UNIX && defined RENDERER_SOFTWARE)
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "x11_rasterizer.h"
+
+namespace tpp {
+
+    namespace {
+
+        /** Returns true if the display is connected over a local socket so that it can share memory with the client.
+         */
+        bool IsLocalDisplay(Display * display) {
+            char const * name = DisplayString(display);
+            return name != nullptr && (name[0] == ':' || strncmp(name, "unix:", 5) == 0);
+        }
+
+        /** Set by ShmAttachErrorHandler when the X server refuses to attach the shared memory segment.
+         */
+        bool ShmAttachFailed = false;
+
+        int ShmAttachErrorHandler(Display * display, XErrorEvent * e) {
+            MARK_AS_UNUSED(display);
+            MARK_AS_UNUSED(e);
+            ShmAttachFailed = true;
+            return 0;
+        }
+
+        /** Attaches the segment to the X server and waits for the result.
+
+            XShmAttach() only fails on the client side, a server that cannot access the segment (such as one running in a different IPC namespace) reports an error asynchronously. Presenting from a segment the server did not attach would never send the completion events flush() waits for, so the error is trapped here instead of being passed to the application's error handler. The errors of any requests sent before are flushed first so that they are not mistaken for the attach failure.
+         */
+        bool AttachShm(Display * display, XShmSegmentInfo * info) {
+            XSync(display, false);
+            ShmAttachFailed = false;
+            XErrorHandler handler = XSetErrorHandler(ShmAttachErrorHandler);
+            Status attached = XShmAttach(display, info);
+            XSync(display, false);
+            XSetErrorHandler(handler);
+            return attached && ! ShmAttachFailed;
+        }
+
+    } // anonymous namespace
+
+    X11Rasterizer::X11Rasterizer(Display * display, Visual * visual):
+        display_{display},
+        visual_{visual},
+        useShm_{XShmQueryExtension(display) && IsLocalDisplay(display)},
+        completionEvent_{useShm_ ? XShmGetEventBase(display) + ShmCompletion : -1},
+        threads_{std::max(1u, std::min(std::thread::hardware_concurrency(), MAX_THREADS))} {
+        memset(& shmInfo_, 0, sizeof(XShmSegmentInfo));
+        // the calling thread rasterizes the first band itself
+        for (unsigned i = 1; i < threads_; ++i)
+            workers_.push_back(std::thread{[this, i](){ worker(i); }});
+    }
+
+    X11Rasterizer::~X11Rasterizer() {
+        {
+            std::lock_guard<std::mutex> g{m_};
+            terminate_ = true;
+            cv_.notify_all();
+        }
+        for (std::thread & t : workers_)
+            t.join();
+        destroyImage();
+    }
+
+    void X11Rasterizer::resize(int width, int height) {
+        if (width == width_ && height == height_)
+            return;
+        destroyImage();
+        commands_.clear();
+        if (width > 0 && height > 0)
+            createImage(width, height);
+    }
+
+    void X11Rasterizer::flush() {
+        if (commands_.empty())
+            return;
+        if (image_ != nullptr) {
+            // the X server must have finished reading the shared image before it can be changed
+            while (pendingPuts_ > 0) {
+                XEvent e;
+                XIfEvent(display_, & e, IsCompletionOf, reinterpret_cast<XPointer>(this));
+                --pendingPuts_;
+            }
+            if (workers_.empty() || commands_.size() < MIN_PARALLEL_COMMANDS) {
+                rasterize(0, height_);
+            } else {
+                {
+                    std::lock_guard<std::mutex> g{m_};
+                    ++generation_;
+                    remaining_ = static_cast<unsigned>(workers_.size());
+                    cv_.notify_all();
+                }
+                rasterizeBand(0);
+                std::unique_lock<std::mutex> g{m_};
+                done_.wait(g, [this](){ return remaining_ == 0; });
+            }
+        }
+        commands_.clear();
+    }
+
+    void X11Rasterizer::present(Drawable drawable, GC gc, int x, int y, int width, int height) {
+        if (image_ == nullptr)
+            return;
+        // clip the rectangle to the image
+        if (x < 0) {
+            width += x;
+            x = 0;
+        }
+        if (y < 0) {
+            height += y;
+            y = 0;
+        }
+        width = std::min(width, width_ - x);
+        height = std::min(height, height_ - y);
+        if (width <= 0 || height <= 0)
+            return;
+        if (shmImage_) {
+            // the server sends a completion event once it has read the image, see flush()
+            XShmPutImage(display_, drawable, gc, image_, x, y, x, y, width, height, true);
+            ++pendingPuts_;
+        } else {
+            XPutImage(display_, drawable, gc, image_, x, y, x, y, width, height);
+        }
+    }
+
+    void X11Rasterizer::completed(XEvent const & e) {
+        if (pendingPuts_ > 0 && IsCompletionOf(nullptr, const_cast<XEvent *>(& e), reinterpret_cast<XPointer>(this)))
+            --pendingPuts_;
+    }
+
+    Bool X11Rasterizer::IsCompletionOf(Display * display, XEvent * e, XPointer rasterizer) {
+        MARK_AS_UNUSED(display);
+        X11Rasterizer * r = reinterpret_cast<X11Rasterizer *>(rasterizer);
+        return r->isCompletion(* e) && reinterpret_cast<XShmCompletionEvent *>(e)->shmseg == r->shmInfo_.shmseg;
+    }
+
+    void X11Rasterizer::createImage(int width, int height) {
+        if (useShm_) {
+            image_ = XShmCreateImage(display_, visual_, 32, ZPixmap, nullptr, & shmInfo_, width, height);
+            if (image_ != nullptr) {
+                shmInfo_.shmid = shmget(IPC_PRIVATE, image_->bytes_per_line * height, IPC_CREAT | 0600);
+                if (shmInfo_.shmid >= 0) {
+                    shmInfo_.shmaddr = static_cast<char *>(shmat(shmInfo_.shmid, nullptr, 0));
+                    if (shmInfo_.shmaddr != reinterpret_cast<char *>(-1)) {
+                        image_->data = shmInfo_.shmaddr;
+                        shmInfo_.readOnly = false;
+                        if (AttachShm(display_, & shmInfo_)) {
+                            // the segment is destroyed once both the server and the client detach from it
+                            shmctl(shmInfo_.shmid, IPC_RMID, nullptr);
+                            shmImage_ = true;
+                        } else {
+                            shmdt(shmInfo_.shmaddr);
+                        }
+                    }
+                    if (! shmImage_)
+                        shmctl(shmInfo_.shmid, IPC_RMID, nullptr);
+                }
+                if (! shmImage_) {
+                    image_->data = nullptr;
+                    XDestroyImage(image_);
+                    image_ = nullptr;
+                }
+            }
+            // don't try the shared memory again if it failed
+            if (! shmImage_) {
+                LOG() << "MIT-SHM image cannot be created, falling back to XPutImage";
+                useShm_ = false;
+            }
+        }
+        if (! shmImage_) {
+            char * data = static_cast<char *>(malloc(static_cast<size_t>(width) * height * 4));
+            image_ = XCreateImage(display_, visual_, 32, ZPixmap, 0, data, width, height, 32, width * 4);
+            if (image_ == nullptr) {
+                free(data);
+                return;
+            }
+            // the pixels are written as native 32bit values, Xlib swaps them if the server uses a different byte order
+            uint32_t one = 1;
+            image_->byte_order = (* reinterpret_cast<unsigned char const *>(& one) == 1) ? LSBFirst : MSBFirst;
+        }
+        pixels_ = reinterpret_cast<uint32_t *>(image_->data);
+        width_ = width;
+        height_ = height;
+        stride_ = image_->bytes_per_line / 4;
+    }
+
+    void X11Rasterizer::destroyImage() {
+        if (image_ != nullptr) {
+            if (shmImage_) {
+                XShmDetach(display_, & shmInfo_);
+                XSync(display_, false);
+                shmdt(shmInfo_.shmaddr);
+                image_->data = nullptr;
+                shmImage_ = false;
+            }
+            // destroys the pixels as well if not shared
+            XDestroyImage(image_);
+            image_ = nullptr;
+        }
+        // the detach above waited for the server, any completions left are ignored as they belong to the old segment
+        pendingPuts_ = 0;
+        pixels_ = nullptr;
+        width_ = 0;
+        height_ = 0;
+        stride_ = 0;
+    }
+
+    void X11Rasterizer::rasterize(int top, int bottom) {
+        for (Command const & cmd : commands_) {
+            int left = std::max(cmd.x, 0);
+            int right = std::min(cmd.x + cmd.width, width_);
+            int rowStart = std::max(cmd.y, top);
+            int rowEnd = std::min(cmd.y + cmd.height, bottom);
+            if (left >= right || rowStart >= rowEnd)
+                continue;
+            switch (cmd.kind) {
+                case Command::Kind::Fill:
+                    for (int y = rowStart; y < rowEnd; ++y)
+                        std::fill(pixels_ + y * stride_ + left, pixels_ + y * stride_ + right, cmd.color);
+                    break;
+                case Command::Kind::Blend:
+                    if ((cmd.color >> 24) == 0xff) {
+                        for (int y = rowStart; y < rowEnd; ++y)
+                            std::fill(pixels_ + y * stride_ + left, pixels_ + y * stride_ + right, cmd.color);
+                    } else {
+                        for (int y = rowStart; y < rowEnd; ++y) {
+                            uint32_t * p = pixels_ + y * stride_;
+                            for (int x = left; x < right; ++x)
+                                p[x] = PremultipliedOver(cmd.color, p[x]);
+                        }
+                    }
+                    break;
+                case Command::Kind::Glyph: {
+                    GlyphBitmap const & glyph = * cmd.glyph;
+                    bool opaque = (cmd.color >> 24) == 0xff;
+                    for (int y = rowStart; y < rowEnd; ++y) {
+                        uint32_t * p = pixels_ + y * stride_;
+                        unsigned char const * coverage = glyph.alpha.data() + (y - cmd.y) * glyph.stride;
+                        for (int x = left; x < right; ++x) {
+                            uint32_t c = coverage[x - cmd.x];
+                            if (c == 0)
+                                continue;
+                            p[x] = (c == 0xff && opaque) ? cmd.color : PremultipliedOver(PremultipliedScale(cmd.color, c), p[x]);
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    void X11Rasterizer::worker(unsigned index) {
+        size_t generation = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> g{m_};
+                cv_.wait(g, [&](){ return terminate_ || generation_ != generation; });
+                if (terminate_)
+                    return;
+                generation = generation_;
+            }
+            rasterizeBand(index);
+            std::lock_guard<std::mutex> g{m_};
+            if (--remaining_ == 0)
+                done_.notify_one();
+        }
+    }
+
+} // namespace tpp
+
+#endif
@@ -0,0 +1,172 @@
+#pragma once
+#if (defined ARCH_UNIX && defined RENDERER_SOFTWARE)
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "x11.h"
+#include <X11/extensions/XShm.h>
+
+#include "x11_font.h"
+
+namespace tpp {
+
+    /** CPU rasterizer of the software renderer.
+
+        The rasterizer draws into a 32bit ARGB image whose pixels are premultiplied 0xAARRGGBB values. The drawing functions only record the commands, which are executed by flush(). The image is split into horizontal bands of pixel rows, each band being rasterized by a different thread. Since every pixel belongs to exactly one band, the commands are executed in order for every pixel and no further synchronization is required.
+
+        If the X server supports the MIT-SHM extension and the display is local, the image lives in a shared memory segment and is presented by XShmPutImage without copying the pixels over the connection. Otherwise the image is sent with XPutImage.
+     */
+    class X11Rasterizer {
+    public:
+
+        /** Maximum number of threads (including the calling thread) the image is rasterized with.
+         */
+        static constexpr unsigned MAX_THREADS = 8;
+
+        /** Minimum number of commands for which the rasterization is split across the threads. Smaller batches are rasterized by the calling thread as the synchronization would cost more than the drawing itself.
+         */
+        static constexpr size_t MIN_PARALLEL_COMMANDS = 64;
+
+        X11Rasterizer(Display * display, Visual * visual);
+
+        ~X11Rasterizer();
+
+        /** Resizes the image.
+
+            The contents of the image are undefined after the resize.
+         */
+        void resize(int width, int height);
+
+        /** Replaces the pixels of given rectangle with the color.
+         */
+        void fillRect(uint32_t color, int x, int y, int width, int height) {
+            commands_.push_back(Command{Command::Kind::Fill, x, y, width, height, color, nullptr});
+        }
+
+        /** Blends the color over the pixels of given rectangle.
+         */
+        void blendRect(uint32_t color, int x, int y, int width, int height) {
+            commands_.push_back(Command{Command::Kind::Blend, x, y, width, height, color, nullptr});
+        }
+
+        /** Blends the color over the pixels covered by the glyph whose origin is at given coordinates.
+
+            The glyph bitmap must stay valid until the next flush().
+         */
+        void drawGlyph(GlyphBitmap const & glyph, int x, int y, uint32_t color) {
+            if (glyph.width == 0 || glyph.height == 0)
+                return;
+            commands_.push_back(Command{Command::Kind::Glyph, x + glyph.left, y - glyph.top, static_cast<int>(glyph.width), static_cast<int>(glyph.height), color, & glyph});
+        }
+
+        /** Executes all recorded commands.
+
+            Before the image is modified, waits for the completion events of the shared images presented previously, so that the X server is no longer reading them.
+         */
+        void flush();
+
+        /** Copies given rectangle of the image to the drawable.
+
+            The rectangle is clipped to the image. Shared images request a completion event from the X server, which the next flush() waits for.
+         */
+        void present(Drawable drawable, GC gc, int x, int y, int width, int height);
+
+        /** Returns true if the event is a completion of a shared image put.
+         */
+        bool isCompletion(XEvent const & e) const {
+            return e.type == completionEvent_;
+        }
+
+        /** Notifies the rasterizer of a completion event received by the application's event loop instead of by flush().
+         */
+        void completed(XEvent const & e);
+
+        /** Converts 16bit premultiplied Xft color to the pixel value.
+         */
+        static uint32_t ToPixel(XftColor const & color) {
+            return ((color.color.alpha >> 8) << 24) + ((color.color.red >> 8) << 16) + ((color.color.green >> 8) << 8) + (color.color.blue >> 8);
+        }
+
+    private:
+
+        class Command {
+        public:
+            enum class Kind {
+                Fill,
+                Blend,
+                Glyph,
+            };
+            Kind kind;
+            int x;
+            int y;
+            int width;
+            int height;
+            uint32_t color;
+            GlyphBitmap const * glyph;
+        }; // tpp::X11Rasterizer::Command
+
+        void createImage(int width, int height);
+
+        void destroyImage();
+
+        /** Executes all recorded commands clipped to given pixel rows.
+         */
+        void rasterize(int top, int bottom);
+
+        /** Rasterizes the band of rows for given thread index.
+         */
+        void rasterizeBand(unsigned index) {
+            int threads = static_cast<int>(threads_);
+            int bandHeight = (height_ + threads - 1) / threads;
+            int top = static_cast<int>(index) * bandHeight;
+            rasterize(top, std::min(top + bandHeight, height_));
+        }
+
+        void worker(unsigned index);
+
+        /** Predicate for XIfEvent that matches the completion events of the rasterizer's shared image.
+         */
+        static Bool IsCompletionOf(Display * display, XEvent * e, XPointer rasterizer);
+
+        Display * display_;
+        Visual * visual_;
+        bool useShm_;
+
+        XImage * image_ = nullptr;
+        XShmSegmentInfo shmInfo_;
+        bool shmImage_ = false;
+        /** Type of the MIT-SHM completion events, -1 if MIT-SHM is not used.
+         */
+        int completionEvent_;
+        /** Number of shared image puts whose completion event has not been received yet.
+         */
+        unsigned pendingPuts_ = 0;
+
+        uint32_t * pixels_ = nullptr;
+        int width_ = 0;
+        int height_ = 0;
+        int stride_ = 0;
+
+        std::vector<Command> commands_;
+
+        /** Number of threads rasterizing the image, including the thread calling flush().
+         */
+        unsigned threads_;
+        std::vector<std::thread> workers_;
+        std::mutex m_;
+        std::condition_variable cv_;
+        std::condition_variable done_;
+        size_t generation_ = 0;
+        unsigned remaining_ = 0;
+        bool terminate_ = false;
+
+    }; // tpp::X11Rasterizer
+
+} // namespace tpp
+
+#endif
@@ -67,8 +67,15 @@ namespace tpp {
         XGCValues gcv;
         memset(&gcv, 0, sizeof(XGCValues));
     	gcv.graphics_exposures = False;
+#if (defined RENDERER_SOFTWARE)
+        // the software renderer rasterizes into an image that is put directly to the window
+        rasterizer_ = new X11Rasterizer{display_, visual_};
+        rasterizer_->resize(sizePx_.width(), sizePx_.height());
+        gc_ = XCreateGC(display_, window_, GCGraphicsExposures, &gcv);
+#else
         buffer_ = XCreatePixmap(display_, window_, sizePx_.width(), sizePx_.height(), 32);
         gc_ = XCreateGC(display_, buffer_, GCGraphicsExposures, &gcv);
+#endif
 		// only create input context if XIM is present
 		if (X11Application::Instance()->xIm_ != nullptr) {
 			// create input context for the window... The extra arguments to the XCreateIC are c-c c-v from the internet and for now are a mystery to me
@@ -76,6 +83,9 @@ namespace tpp {
 				XNClientWindow, window_, XNFocusWindow, window_, nullptr);
 		}
 
+        // the buffer pixmap keeps the last frame so that only the damaged cells have to be redrawn
+        retainsFrame_ = true;
+
         updateXftStructures(width());
 
 		// register the window
@@ -91,7 +101,12 @@ namespace tpp {
 
     X11Window::~X11Window() {
         UnregisterWindowHandle(window_);
+        if (draw_ != nullptr)
+            XftDrawDestroy(draw_);
 		XFreeGC(display_, gc_);
+#if (defined RENDERER_SOFTWARE)
+        delete rasterizer_;
+#endif
         delete [] text_;
     }
 
@@ -374,10 +389,20 @@ namespace tpp {
 
     void X11Window::EventHandler(XEvent & e) {
         X11Window * window = GetWindowForHandle(e.xany.window);
+#if (defined RENDERER_SOFTWARE)
+        // completions of the presented shared images not yet waited for by the rasterizer
+        if (window != nullptr && window->rasterizer_->isCompletion(e)) {
+            window->rasterizer_->completed(e);
+            return;
+        }
+#endif
         switch(e.type) {
             /* Handles repaint event when window is shown or a repaint was triggered. 
              */
             case Expose: 
+                // exposures that did not originate from render() mean the window contents may have been lost
+                if (! e.xexpose.send_event)
+                    window->exposed_ = true;
                 if (e.xexpose.count != 0)
                     break;
                 // TODO actually get the widget to be rendered 
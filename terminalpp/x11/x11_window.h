@@ -4,7 +4,11 @@
 #include "x11.h"
 
 #include "x11_font.h"
+#if (defined RENDERER_SOFTWARE)
+#include "x11_rasterizer.h"
+#endif
 #include "../window.h"
+#include "../draw_batch.h"
 
 namespace tpp {
 
@@ -75,8 +79,12 @@ namespace tpp {
             }
         }
 
+        /** Accumulates the rectangle to be rendered and triggers a refresh. 
+         
+            The actual rendering happens when the expose event is processed, so rectangles of multiple render requests are merged. 
+         */
         void render(Rect const & rect) override {
-            MARK_AS_UNUSED(rect);
+            renderRect_ = renderRect_.empty() ? rect : (renderRect_ | rect);
             // trigger a refresh
             XEvent e;
             memset(&e, 0, sizeof(XEvent));
@@ -87,12 +95,20 @@ namespace tpp {
         }
 
         void expose() {
-            RendererWindow::render(Rect{size()});
+            Rect rect = renderRect_;
+            renderRect_ = Rect{};
+            RendererWindow::render(rect);
         }
 
         void windowResized(int width, int height) override {
+#if (defined RENDERER_SOFTWARE)
+            rasterizer_->resize(width, height);
+#else
             XFreePixmap(display_, buffer_);
             buffer_ = XCreatePixmap(display_, window_, width, height, 32);
+            if (draw_ != nullptr)
+                XftDrawChange(draw_, buffer_);
+#endif
             RendererWindow::windowResized(width, height);
         }
 
@@ -137,6 +153,10 @@ namespace tpp {
 			unsigned long   status;
 		};
 
+        /** Batch of glyph runs drawn with the window's fonts, colors and glyphs. 
+         */
+        using Batch = DrawBatch<X11Font, XftColor, XftGlyphSpec, XRectangle>;
+
         /** Creates the renderer window of appropriate size using the default font and zoom of 1.0. 
          */
         X11Window(std::string const & title, int cols, int rows, EventQueue & eventQueue);
@@ -144,23 +164,53 @@ namespace tpp {
         /** \name Rendering Functions
          */
         //@{
+        /** Prepares the drawing. 
+         
+            The Xft draw for the buffer pixmap is created on the first draw and then kept for the lifetime of the window. The software renderer draws into the rasterizer's image instead and requires no preparation. 
+         */
         void initializeDraw() {
+            firstRequest_ = NextRequest(display_);
+#if (defined RENDERER_X11_XCB)
+            firstByte_ = xcb_total_written(XGetXCBConnection(display_));
+#endif
+#if (! defined RENDERER_SOFTWARE)
             ASSERT(buffer_ != 0);
-            ASSERT(draw_ == nullptr);
-            draw_ = XftDrawCreate(display_, buffer_, visual_, colorMap_);
+            if (draw_ == nullptr)
+                draw_ = XftDrawCreate(display_, buffer_, visual_, colorMap_);
+#endif
         }
 
+        /** Finishes the drawing and copies the damaged parts of the buffer pixmap to the window. 
+         
+            The parts of the window not covered by cells are only drawn when the entire window has been redrawn. If the window has been exposed by the X server, the whole pixmap is copied to the window as its contents may have been lost. The requests issued by the frame, and the bytes written to the X server if Xlib's XCB connection is available, are added to the frame statistics. 
+         */
         void finalizeDraw() {
-            changeBackgroundColor(backgroundColor());
-            if (sizePx_.width() % cellSize_.width() != 0)
-                XftDrawRect(draw_, &bg_, width() * cellSize_.width(), 0, sizePx_.width() % cellSize_.width(), sizePx_.height());
-            if (sizePx_.height() % cellSize_.height() != 0)
-                XftDrawRect(draw_, &bg_, 0, height() * cellSize_.height(), sizePx_.width(), sizePx_.height() % cellSize_.height());
+            flushBatch();
+            if (damageAll_) {
+                changeBackgroundColor(backgroundColor());
+                if (sizePx_.width() % cellSize_.width() != 0)
+                    fillRect(bg_, width() * cellSize_.width(), 0, sizePx_.width() % cellSize_.width(), sizePx_.height());
+                if (sizePx_.height() % cellSize_.height() != 0)
+                    fillRect(bg_, 0, height() * cellSize_.height(), sizePx_.width(), sizePx_.height() % cellSize_.height());
+            }
+#if (defined RENDERER_SOFTWARE)
+            rasterizer_->flush();
+#endif
             // now bitblt the buffer
-            XCopyArea(display_, buffer_, window_, gc_, 0, 0, sizePx_.width(), sizePx_.height(), 0, 0);
-            XftDrawDestroy(draw_);
-            draw_ = nullptr;
-            XFlush(display_);
+            if (damageAll_ || exposed_) {
+                copyToWindow(0, 0, sizePx_.width(), sizePx_.height());
+            } else {
+                for (Rect const & r : damage_)
+                    copyToWindow(r.left() * cellSize_.width(), r.top() * cellSize_.height(), r.width() * cellSize_.width(), r.height() * cellSize_.height());
+            }
+            if (damageAll_ || exposed_ || ! damage_.empty()) {
+                exposed_ = false;
+                XFlush(display_);
+            }
+            frame_.requests = NextRequest(display_) - firstRequest_;
+#if (defined RENDERER_X11_XCB)
+            frame_.bytes = xcb_total_written(XGetXCBConnection(display_)) - firstByte_;
+#endif
         }
 
         void initializeGlyphRun(int col, int row) {
@@ -170,15 +220,15 @@ namespace tpp {
         }
 
         void addGlyph(int col, int row, Cell const & cell) {
-            FT_UInt glyph = XftCharIndex(display_, font_->xftFont(), cell.codepoint());
-            if (glyph == 0) {
+            X11Font::Glyph glyph = font_->glyphFor(cell.codepoint());
+            if (glyph.font != font_) {
                 // draw glyph run so far and initialize a new glyph run
                 drawGlyphRun();
                 initializeGlyphRun(col, row);
-                // obtain the fallback font and initialize the glyph run with it
+                // switch to the fallback font and initialize the glyph run with it
                 X11Font * oldFont = font_;
-                font_ = font_->fallbackFor(cell.codepoint());
-                text_[0].glyph = XftCharIndex(display_, font_->xftFont(), cell.codepoint());
+                font_ = glyph.font;
+                text_[0].glyph = glyph.index;
                 text_[0].x = textCol_ * cellSize_.width() + font_->offset().x();
                 text_[0].y = (textRow_ + 1 - font_->font().height()) * cellSize_.height() + font_->ascent() + font_->offset().y();
                 ++textSize_;
@@ -193,7 +243,7 @@ namespace tpp {
                     text_[textSize_].x = text_[textSize_ - 1].x + cellSize_.width() * state_.font().width();
                     text_[textSize_].y = text_[textSize_ - 1].y;
                 }
-                text_[textSize_].glyph = glyph;
+                text_[textSize_].glyph = glyph.index;
                 ++textSize_;
             }
         }
@@ -224,46 +274,95 @@ namespace tpp {
 
         /** Draws the glyph run. 
          
-            First clears the background with given background color, then draws the text and finally applies any decorations. 
+            The background, text and decorations of the run are not drawn immediately, but added to the batch that is flushed once the colors are known for the entire frame, see flushBatch(). If the run covers pixels of the runs already in the batch, the batch is flushed first so that the run is drawn over them. 
          */
         void drawGlyphRun() {
             if (textSize_ == 0)
                 return;
             int fontWidth = state_.font().width();
             int fontHeight = state_.font().height();
+            int x = textCol_ * cellSize_.width();
+            int y = (textRow_ + 1 - fontHeight) * cellSize_.height();
+            int width = textSize_ * cellSize_.width() * fontWidth;
+            int height = cellSize_.height() * fontHeight;
+            if (batch_.overlaps(x, y, width, height))
+                flushBatch();
+            batch_.addRun(x, y, width, height);
             // fill the background unless it is fully transparent
             if (bg_.color.alpha != 0)
-			    XftDrawRect(draw_, &bg_, textCol_ * cellSize_.width(), (textRow_ + 1 - fontHeight) * cellSize_.height(), textSize_ * cellSize_.width() * fontWidth, cellSize_.height() * fontHeight);
+                batch_.addBackground(ColorId(bg_), bg_, x, y, width, height);
             // draw the text
             if (!state_.font().blink() || BlinkVisible()) {
-                XftDrawGlyphSpec(draw_, &fg_, font_->xftFont(), text_, textSize_);
+                batch_.addText(font_, fg_, text_, textSize_);
                 // deal with the attributes
+                uint64_t decorId = ColorId(decor_);
                 if (state_.font().underline()) {
                     if (state_.font().dashed()) {
                         for (size_t i = 0; i < textSize_; ++i) {
-                            XftDrawRect(draw_, &decor_, (textCol_ + i) * cellSize_.width(), textRow_ * cellSize_.height() + font_->underlineOffset(), cellSize_.width() / 2, font_->underlineThickness());
+                            batch_.addDecoration(decorId, decor_, (textCol_ + i) * cellSize_.width(), textRow_ * cellSize_.height() + font_->underlineOffset(), cellSize_.width() / 2, font_->underlineThickness());
                         }
                     } else {
-					    XftDrawRect(draw_, &decor_, textCol_ * cellSize_.width(), textRow_ * cellSize_.height() + font_->underlineOffset(), cellSize_.width() * textSize_, font_->underlineThickness());
+                        batch_.addDecoration(decorId, decor_, textCol_ * cellSize_.width(), textRow_ * cellSize_.height() + font_->underlineOffset(), cellSize_.width() * textSize_, font_->underlineThickness());
                     }
                 }
                 if (state_.font().strikethrough()) {
                     if (state_.font().dashed()) {
                         for (size_t i = 0; i < textSize_; ++i) {
-                            XftDrawRect(draw_, &decor_, (textCol_ + i) * cellSize_.width(), textRow_ * cellSize_.height() + font_->strikethroughOffset(), cellSize_.width() / 2, font_->strikethroughThickness());
+                            batch_.addDecoration(decorId, decor_, (textCol_ + i) * cellSize_.width(), textRow_ * cellSize_.height() + font_->strikethroughOffset(), cellSize_.width() / 2, font_->strikethroughThickness());
                         }
                     } else {
-					    XftDrawRect(draw_, &decor_, textCol_ * cellSize_.width(), textRow_ * cellSize_.height() + font_->strikethroughOffset(), cellSize_.width() * textSize_, font_->strikethroughThickness());
+                        batch_.addDecoration(decorId, decor_, textCol_ * cellSize_.width(), textRow_ * cellSize_.height() + font_->strikethroughOffset(), cellSize_.width() * textSize_, font_->strikethroughThickness());
                     }
                 } 
             }
         }
 
+        /** Draws the batched glyph runs. 
+         
+            First all backgrounds are filled with a single request per color, then the text of the glyph runs is drawn and finally the decorations are filled, again with a single request per color. 
+         */
+        void flushBatch() {
+            batch_.flush(
+                [this](XftColor const & color, XRectangle const * rects, size_t size) {
+#if (defined RENDERER_SOFTWARE)
+                    uint32_t pixel = X11Rasterizer::ToPixel(color);
+                    for (size_t i = 0; i < size; ++i)
+                        rasterizer_->fillRect(pixel, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+#else
+                    XRenderFillRectangles(display_, PictOpSrc, XftDrawPicture(draw_), & color.color, rects, static_cast<int>(size));
+#endif
+                },
+                [this](X11Font * font, XftColor const & color, XftGlyphSpec const * glyphs, size_t size) {
+                    drawText(font, color, glyphs, size);
+                }
+            );
+        }
+
+        /** Draws the glyphs with given font and color. 
+         */
+        void drawText(X11Font * font, XftColor const & color, XftGlyphSpec const * glyphs, size_t size) {
+#if (defined RENDERER_SOFTWARE)
+            uint32_t fg = X11Rasterizer::ToPixel(color);
+            for (size_t i = 0; i < size; ++i)
+                rasterizer_->drawGlyph(font->glyphBitmap(glyphs[i].glyph), glyphs[i].x, glyphs[i].y, fg);
+#else
+            XftDrawGlyphSpec(draw_, & color, font->xftFont(), glyphs, static_cast<int>(size));
+#endif
+        }
+
+        /** Returns unique identifier of the color. 
+         */
+        static uint64_t ColorId(XftColor const & color) {
+            return (static_cast<uint64_t>(color.color.red) << 48) + (static_cast<uint64_t>(color.color.green) << 32) + (static_cast<uint64_t>(color.color.blue) << 16) + color.color.alpha;
+        }
+
         /** Draws the border. 
          
             Since the border is rendered over the contents and its color may be transparent, we can't use Xft's drawing, but have to revert to XRender which does the blending properly. 
          */
         void drawBorder(int col, int row, Border const & border, int widthThin, int widthThick) {
+            // the border is drawn over the cells
+            flushBatch();
             int left = col * cellSize_.width();
             int top = row * cellSize_.height();
             int widthTop = border.top() == Border::Kind::None ? 0 : (border.top() == Border::Kind::Thick ? widthThick : widthThin);
@@ -272,13 +371,43 @@ namespace tpp {
             int widthRight = border.right() == Border::Kind::None ? 0 : (border.right() == Border::Kind::Thick ? widthThick : widthThin);
 
             if (widthTop != 0)
-                XRenderFillRectangle(display_, PictOpOver, XftDrawPicture(draw_), &bg_.color, left, top, cellSize_.width(), widthTop);            
+                blendRect(bg_, left, top, cellSize_.width(), widthTop);            
             if (widthBottom != 0)
-                XRenderFillRectangle(display_, PictOpOver, XftDrawPicture(draw_), &bg_.color, left, top + cellSize_.height() - widthBottom, cellSize_.width(), widthBottom);
+                blendRect(bg_, left, top + cellSize_.height() - widthBottom, cellSize_.width(), widthBottom);
             if (widthLeft != 0) 
-                XRenderFillRectangle(display_, PictOpOver, XftDrawPicture(draw_), &bg_.color, left, top + widthTop, widthLeft, cellSize_.height() - widthTop - widthBottom);
+                blendRect(bg_, left, top + widthTop, widthLeft, cellSize_.height() - widthTop - widthBottom);
             if (widthRight != 0)
-                XRenderFillRectangle(display_, PictOpOver, XftDrawPicture(draw_), &bg_.color, left + cellSize_.width() - widthRight, top + widthTop, widthRight, cellSize_.height() - widthTop - widthBottom); 
+                blendRect(bg_, left + cellSize_.width() - widthRight, top + widthTop, widthRight, cellSize_.height() - widthTop - widthBottom); 
+        }
+
+        /** Fills the rectangle with given color, replacing its previous contents. 
+         */
+        void fillRect(XftColor const & color, int x, int y, int width, int height) {
+#if (defined RENDERER_SOFTWARE)
+            rasterizer_->fillRect(X11Rasterizer::ToPixel(color), x, y, width, height);
+#else
+            XftDrawRect(draw_, & color, x, y, width, height);
+#endif
+        }
+
+        /** Blends given color over the rectangle. 
+         */
+        void blendRect(XftColor const & color, int x, int y, int width, int height) {
+#if (defined RENDERER_SOFTWARE)
+            rasterizer_->blendRect(X11Rasterizer::ToPixel(color), x, y, width, height);
+#else
+            XRenderFillRectangle(display_, PictOpOver, XftDrawPicture(draw_), & color.color, x, y, width, height);
+#endif
+        }
+
+        /** Copies given rectangle of the drawn frame to the window. 
+         */
+        void copyToWindow(int x, int y, int width, int height) {
+#if (defined RENDERER_SOFTWARE)
+            rasterizer_->present(window_, gc_, x, y, width, height);
+#else
+            XCopyArea(display_, buffer_, window_, gc_, x, y, width, height, x, y);
+#endif
         }
         //@}
 
@@ -309,6 +438,26 @@ namespace tpp {
 
         GC gc_;
         Pixmap buffer_;
+#if (defined RENDERER_SOFTWARE)
+        X11Rasterizer * rasterizer_ = nullptr;
+#endif
+
+        /** Union of the rectangles requested to be rendered since the last expose event was processed. 
+         */
+        Rect renderRect_;
+
+        /** True if the window has been exposed by the X server and the entire buffer must be copied to it. 
+         */
+        bool exposed_ = false;
+
+        /** Serial number of the first request of the frame being rendered. 
+         */
+        unsigned long firstRequest_ = 0;
+#if (defined RENDERER_X11_XCB)
+        /** Bytes written to the X server before the frame being rendered. 
+         */
+        uint64_t firstByte_ = 0;
+#endif
 
 		XftDraw * draw_;
 		XftColor fg_;
@@ -319,6 +468,8 @@ namespace tpp {
 
         XftGlyphSpec * text_;
 
+        Batch batch_;
+
         /** Text buffer rendering data.
          */
         unsigned textCol_;
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "pty.h"
+
+namespace tpp {
+
+    /** Pseudoterminal master that receives nothing but the given output.
+
+        Once the output is received, receive() blocks until the pseudoterminal is terminated. Any data sent to the pseudoterminal and resize requests are ignored so that the input can be fed to the terminal directly, such as by the tests and benchmarks.
+     */
+    class NullPTYMaster : public PTYMaster {
+    public:
+
+        explicit NullPTYMaster(std::string const & output = std::string{}):
+            output_{output} {
+        }
+
+        void send(char const * buffer, size_t numBytes) override {
+            MARK_AS_UNUSED(buffer);
+            MARK_AS_UNUSED(numBytes);
+        }
+
+        size_t receive(char * buffer, size_t bufferSize) override {
+            std::unique_lock<std::mutex> g{m_};
+            if (! output_.empty()) {
+                size_t size = std::min(bufferSize, output_.size());
+                memcpy(buffer, output_.c_str(), size);
+                output_.erase(0, size);
+                return size;
+            }
+            while (! terminated_)
+                cv_.wait(g);
+            return 0;
+        }
+
+        void terminate() override {
+            std::lock_guard<std::mutex> g{m_};
+            terminated_ = true;
+            cv_.notify_all();
+        }
+
+        void resize(int cols, int rows) override {
+            MARK_AS_UNUSED(cols);
+            MARK_AS_UNUSED(rows);
+        }
+
+    private:
+
+        std::string output_;
+
+        std::mutex m_;
+        std::condition_variable cv_;
+
+    }; // tpp::NullPTYMaster
+
+} // namespace tpp
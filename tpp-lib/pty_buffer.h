@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <thread>
 
 #include "pty.h"
+#include "pty_capture.h"
 
 namespace tpp {
 
@@ -27,10 +31,27 @@ namespace tpp {
             return pty_;
         }
 
+        /** Returns the number of bytes processed by the reader so far.
+         */
+        size_t receivedBytes() const {
+            return receivedBytes_;
+        }
+
+        /** Returns the time the reader spent processing the received bytes so far, including the time spent waiting for the buffer lock.
+         */
+        std::chrono::microseconds receivedTime() const {
+            return std::chrono::microseconds{receivedTime_};
+        }
+
     protected:
 
-        explicit PTYBuffer(T * pty):
-            pty_{pty} {
+        /** Creates the buffer for given pseudoterminal, taking ownership of the optional capture.
+
+            The capture is set before the reader thread is started so that it records the data the pseudoterminal received before the buffer was created as well. Only the reader thread writes to the capture, which is closed when the buffer is destroyed.
+         */
+        explicit PTYBuffer(T * pty, PTYCapture::Writer * capture = nullptr):
+            pty_{pty},
+            capture_{capture} {
         }
 
 
@@ -50,8 +71,14 @@ namespace tpp {
                     // if no more bytes were read, then the PTY has been terminated, exit the loop
                     if (available == 0 && pty_->terminated())
                         break;
+                    if (available > 0 && capture_ != nullptr)
+                        capture_->record(buffer + unprocessed, available);
                     available += unprocessed;
-                    unprocessed = available - received(buffer, buffer + available);
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    size_t processed = received(buffer, buffer + available);
+                    receivedTime_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                    receivedBytes_ += processed;
+                    unprocessed = available - processed;
                     // copy the unprocessed bytes at the beginning of the buffer
                     memcpy(buffer, buffer + available - unprocessed, unprocessed);
                     // grow the buffer if unprocessed == bufferSize
@@ -92,6 +119,12 @@ namespace tpp {
 
         std::thread reader_;
 
+        std::unique_ptr<PTYCapture::Writer> capture_;
+
+        /** Statistics of the reader, updated by the reader thread. */
+        std::atomic<size_t> receivedBytes_{0};
+        std::atomic<int64_t> receivedTime_{0};
+
     }; // tpp::PTYBuffer
 
 } // namespace tpp
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "helpers/helpers.h"
+
+#include "pty_capture.h"
+
+namespace tpp {
+
+    namespace {
+
+        uint64_t ReadLittleEndian(char const * x, size_t bytes) {
+            uint64_t result = 0;
+            for (size_t i = bytes; i > 0; --i)
+                result = (result << 8) | static_cast<unsigned char>(x[i - 1]);
+            return result;
+        }
+
+        void WriteLittleEndian(std::string & into, uint64_t value, size_t bytes) {
+            for (size_t i = 0; i < bytes; ++i) {
+                into.push_back(static_cast<char>(value & 0xff));
+                value >>= 8;
+            }
+        }
+
+    } // anonymous namespace
+
+    PTYCapture::Writer::Writer(std::string const & filename):
+        filename_{filename},
+        f_{filename, std::ios::binary | std::ios::trunc},
+        start_{std::chrono::steady_clock::now()},
+        dropped_{0},
+        done_{false} {
+        if (! f_.good())
+            THROW(IOError()) << "Unable to create PTY capture " << filename;
+        f_.write(MAGIC, MAGIC_SIZE);
+        writer_ = std::thread{[this](){
+            write();
+        }};
+    }
+
+    PTYCapture::Writer::~Writer() {
+        {
+            std::lock_guard<std::mutex> g{m_};
+            done_ = true;
+            cv_.notify_one();
+        }
+        writer_.join();
+        if (dropped_ > 0)
+            LOG() << "PTY capture " << filename_ << " dropped " << dropped_ << " bytes";
+    }
+
+    void PTYCapture::Writer::record(char const * buffer, size_t size) {
+        auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_);
+        std::lock_guard<std::mutex> g{m_};
+        if (pending_.size() + CHUNK_HEADER_SIZE + size > MAX_PENDING) {
+            dropped_ += size;
+            return;
+        }
+        bool wasEmpty = pending_.empty();
+        WriteLittleEndian(pending_, static_cast<uint64_t>(time.count()), 8);
+        WriteLittleEndian(pending_, size, 4);
+        pending_.append(buffer, size);
+        if (wasEmpty)
+            cv_.notify_one();
+    }
+
+    void PTYCapture::Writer::write() {
+        std::string data;
+        std::unique_lock<std::mutex> g{m_};
+        while (true) {
+            while (pending_.empty() && ! done_)
+                cv_.wait(g);
+            if (pending_.empty())
+                break;
+            // take the pending chunks and write them without holding the lock, reusing the buffers
+            std::swap(data, pending_);
+            g.unlock();
+            f_.write(data.c_str(), data.size());
+            f_.flush();
+            data.clear();
+            g.lock();
+        }
+    }
+
+    std::vector<PTYCapture::Chunk> PTYCapture::Load(std::string const & filename) {
+        std::ifstream f{filename, std::ios::binary};
+        if (! f.good())
+            THROW(IOError()) << "Unable to open PTY capture " << filename;
+        std::string data{std::istreambuf_iterator<char>{f}, std::istreambuf_iterator<char>{}};
+        std::vector<Chunk> result;
+        // files without the header are raw byte streams
+        if (data.size() < MAGIC_SIZE || std::memcmp(data.c_str(), MAGIC, MAGIC_SIZE) != 0) {
+            result.push_back(Chunk{std::chrono::microseconds{0}, std::move(data)});
+            return result;
+        }
+        char const * x = data.c_str() + MAGIC_SIZE;
+        char const * end = data.c_str() + data.size();
+        while (x != end) {
+            if (static_cast<size_t>(end - x) < CHUNK_HEADER_SIZE)
+                THROW(IOError()) << "Truncated chunk header in PTY capture " << filename;
+            std::chrono::microseconds time{ReadLittleEndian(x, 8)};
+            size_t size = ReadLittleEndian(x + 8, 4);
+            x += CHUNK_HEADER_SIZE;
+            if (static_cast<size_t>(end - x) < size)
+                THROW(IOError()) << "Truncated chunk data in PTY capture " << filename;
+            result.push_back(Chunk{time, std::string{x, size}});
+            x += size;
+        }
+        return result;
+    }
+
+} // namespace tpp
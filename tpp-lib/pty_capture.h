@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tpp {
+
+    /** Capture of the data received from a pseudoterminal.
+
+        The capture is a list of chunks, each being the data returned by a single receive() call of the pseudoterminal together with the time since the start of the capture at which it was received.
+
+        The capture file starts with the MAGIC header followed by the chunks, each chunk consisting of the time in microseconds as 64bit little endian number, the size of the data as 32bit little endian number and the data itself. Files without the header are treated as raw byte streams and loaded as a single chunk.
+     */
+    class PTYCapture {
+    public:
+
+        class Chunk {
+        public:
+            std::chrono::microseconds time;
+            std::string data;
+        }; // tpp::PTYCapture::Chunk
+
+        /** Writes the capture to a file.
+
+            The chunks are timestamped with a monotonic clock relative to the creation of the writer and appended to an in-memory buffer, which is written to the file by a background thread so that the recording thread never waits for the disk. If the disk cannot keep up and the buffer exceeds MAX_PENDING bytes, new chunks are dropped and the number of dropped bytes is logged when the writer is destroyed.
+         */
+        class Writer {
+        public:
+
+            static constexpr size_t MAX_PENDING = 64 * 1024 * 1024;
+
+            /** Creates the capture file, throws IOError if the file cannot be created.
+             */
+            explicit Writer(std::string const & filename);
+
+            /** Writes all pending chunks and closes the file.
+             */
+            ~Writer();
+
+            std::string const & filename() const {
+                return filename_;
+            }
+
+            /** Records the given data as a single chunk.
+             */
+            void record(char const * buffer, size_t size);
+
+        private:
+
+            void write();
+
+            std::string filename_;
+            std::ofstream f_;
+            std::chrono::steady_clock::time_point start_;
+
+            std::mutex m_;
+            std::condition_variable cv_;
+            std::string pending_;
+            size_t dropped_;
+            bool done_;
+
+            std::thread writer_;
+
+        }; // tpp::PTYCapture::Writer
+
+        /** Loads the capture from given file.
+         */
+        static std::vector<Chunk> Load(std::string const & filename);
+
+        /** Header identifying the capture files.
+         */
+        static constexpr char const * MAGIC = "tppcap01";
+        static constexpr size_t MAGIC_SIZE = 8;
+
+        /** Size of the chunk header (time and size) in the capture file.
+         */
+        static constexpr size_t CHUNK_HEADER_SIZE = 12;
+
+    }; // tpp::PTYCapture
+
+} // namespace tpp
@@ -0,0 +1,42 @@
+#include <cstring>
+
+#include "replay_pty.h"
+
+namespace tpp {
+
+    void ReplayPTYMaster::terminate() {
+        std::lock_guard<std::mutex> g{m_};
+        terminated_ = true;
+        cv_.notify_all();
+    }
+
+    size_t ReplayPTYMaster::receive(char * buffer, size_t bufferSize) {
+        std::unique_lock<std::mutex> g{m_};
+        if (! started_) {
+            start_ = std::chrono::steady_clock::now();
+            started_ = true;
+        }
+        // skip empty chunks
+        while (chunk_ < chunks_.size() && offset_ == chunks_[chunk_].data.size()) {
+            ++chunk_;
+            offset_ = 0;
+        }
+        if (chunk_ == chunks_.size())
+            terminated_ = true;
+        if (terminated_)
+            return 0;
+        PTYCapture::Chunk const & chunk = chunks_[chunk_];
+        if (realTime_ && offset_ == 0) {
+            auto deadline = start_ + chunk.time;
+            while (! terminated_ && cv_.wait_until(g, deadline) != std::cv_status::timeout) {
+            }
+            if (terminated_)
+                return 0;
+        }
+        size_t result = std::min(bufferSize, chunk.data.size() - offset_);
+        std::memcpy(buffer, chunk.data.c_str() + offset_, result);
+        offset_ += result;
+        return result;
+    }
+
+} // namespace tpp
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "pty.h"
+#include "pty_capture.h"
+
+namespace tpp {
+
+    /** Pseudoterminal master that plays back a captured byte stream.
+
+        The chunks are returned by receive() in order and no receive() call ever crosses a chunk boundary so that the terminal sees the same reads as the original. In real time mode each chunk is returned no sooner than its capture time after the first receive() call, otherwise the chunks are returned as fast as the terminal reads them. Once all chunks have been returned, the pseudoterminal terminates with exit code 0.
+
+        Any data sent to the pseudoterminal and resize requests are ignored so that the whole terminal pipeline can be exercised without a process attached.
+     */
+    class ReplayPTYMaster : public PTYMaster {
+    public:
+
+        explicit ReplayPTYMaster(std::vector<PTYCapture::Chunk> && chunks, bool realTime = false):
+            chunks_{std::move(chunks)},
+            realTime_{realTime},
+            started_{false},
+            chunk_{0},
+            offset_{0} {
+        }
+
+        ~ReplayPTYMaster() override {
+            terminate();
+        }
+
+        void terminate() override;
+
+        void send(char const * buffer, size_t numBytes) override {
+            MARK_AS_UNUSED(buffer);
+            MARK_AS_UNUSED(numBytes);
+        }
+
+        size_t receive(char * buffer, size_t bufferSize) override;
+
+        void resize(int cols, int rows) override {
+            MARK_AS_UNUSED(cols);
+            MARK_AS_UNUSED(rows);
+        }
+
+    private:
+
+        std::vector<PTYCapture::Chunk> chunks_;
+        bool realTime_;
+        bool started_;
+        std::chrono::steady_clock::time_point start_;
+        size_t chunk_;
+        size_t offset_;
+
+        std::mutex m_;
+        std::condition_variable cv_;
+
+    }; // tpp::ReplayPTYMaster
+
+} // namespace tpp
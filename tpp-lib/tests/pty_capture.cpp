@@ -0,0 +1,79 @@
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "helpers/tests.h"
+#include "helpers/filesystem.h"
+
+#include "../pty_capture.h"
+
+using namespace tpp;
+
+namespace {
+
+    void WriteFile(std::string const & filename, std::string const & contents) {
+        std::ofstream f{filename, std::ios::binary | std::ios::trunc};
+        f.write(contents.c_str(), contents.size());
+    }
+
+}
+
+TEST(pty_capture, roundtrip) {
+    std::string filename = UniqueNameIn(TempDir(), "tpp-capture-");
+    std::vector<std::string> chunks{"hello", std::string{"\0\xff\x1b[0m", 6}, "", std::string(100000, 'x')};
+    {
+        PTYCapture::Writer w{filename};
+        for (std::string const & chunk : chunks) {
+            w.record(chunk.c_str(), chunk.size());
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+    }
+    std::vector<PTYCapture::Chunk> loaded = PTYCapture::Load(filename);
+    CHECK_EQ(loaded.size(), chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        EXPECT(loaded[i].data == chunks[i]);
+        // the chunks were recorded at least 10ms apart
+        if (i > 0) {
+            EXPECT(loaded[i].time - loaded[i - 1].time >= std::chrono::milliseconds{10});
+        }
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(pty_capture, raw) {
+    std::string filename = UniqueNameIn(TempDir(), "tpp-capture-");
+    WriteFile(filename, "raw\r\noutput");
+    std::vector<PTYCapture::Chunk> loaded = PTYCapture::Load(filename);
+    CHECK_EQ(loaded.size(), 1);
+    EXPECT_EQ(loaded[0].data, "raw\r\noutput");
+    EXPECT(loaded[0].time.count() == 0);
+    std::remove(filename.c_str());
+}
+
+TEST(pty_capture, truncated) {
+    std::string filename = UniqueNameIn(TempDir(), "tpp-capture-");
+    {
+        PTYCapture::Writer w{filename};
+        w.record("abc", 3);
+        w.record("defgh", 5);
+    }
+    std::string contents = ReadEntireFile(filename);
+    EXPECT_EQ(contents.size(), PTYCapture::MAGIC_SIZE + 2 * PTYCapture::CHUNK_HEADER_SIZE + 8);
+    // a capture cut anywhere but at a chunk boundary is an error
+    size_t boundary = PTYCapture::MAGIC_SIZE + PTYCapture::CHUNK_HEADER_SIZE + 3;
+    for (size_t size = PTYCapture::MAGIC_SIZE + 1; size < contents.size(); ++size) {
+        WriteFile(filename, contents.substr(0, size));
+        if (size == boundary) {
+            EXPECT_EQ(PTYCapture::Load(filename).size(), 1);
+        } else {
+            EXPECT_THROWS(IOError, PTYCapture::Load(filename));
+        }
+    }
+    // chunk size larger than the rest of the file
+    std::string corrupt = contents;
+    corrupt[PTYCapture::MAGIC_SIZE + 8 + 3] = '\x7f';
+    WriteFile(filename, corrupt);
+    EXPECT_THROWS(IOError, PTYCapture::Load(filename));
+    std::remove(filename.c_str());
+    EXPECT_THROWS(IOError, PTYCapture::Load(filename));
+}
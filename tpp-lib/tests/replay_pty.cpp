@@ -0,0 +1,69 @@
+#include <thread>
+
+#include "helpers/tests.h"
+
+#include "../replay_pty.h"
+
+using namespace tpp;
+
+namespace {
+
+    std::vector<PTYCapture::Chunk> Chunks(std::initializer_list<std::pair<int, char const *>> chunks) {
+        std::vector<PTYCapture::Chunk> result;
+        for (auto const & c : chunks)
+            result.push_back(PTYCapture::Chunk{std::chrono::milliseconds{c.first}, c.second});
+        return result;
+    }
+
+    std::string Receive(PTYMaster & pty, size_t bufferSize) {
+        std::string result(bufferSize, '\0');
+        result.resize(pty.receive(& result[0], bufferSize));
+        return result;
+    }
+
+}
+
+TEST(replay_pty, asFastAsPossible) {
+    // the capture times are ignored
+    ReplayPTYMaster pty{Chunks({{0, "ab"}, {10000, ""}, {20000, "cdefg"}, {30000, "h"}})};
+    auto start = std::chrono::steady_clock::now();
+    // reads never cross the chunk boundaries
+    EXPECT_EQ(Receive(pty, 3), "ab");
+    EXPECT_EQ(Receive(pty, 3), "cde");
+    EXPECT_EQ(Receive(pty, 3), "fg");
+    EXPECT_EQ(Receive(pty, 3), "h");
+    EXPECT(! pty.terminated());
+    // the end of the capture terminates the pseudoterminal cleanly
+    EXPECT_EQ(Receive(pty, 3), "");
+    EXPECT(pty.terminated());
+    EXPECT_EQ(pty.exitCode(), 0);
+    EXPECT_EQ(Receive(pty, 3), "");
+    EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds{5});
+}
+
+TEST(replay_pty, realTime) {
+    ReplayPTYMaster pty{Chunks({{0, "a"}, {50, "bc"}, {100, "d"}}), true};
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(Receive(pty, 16), "a");
+    EXPECT_EQ(Receive(pty, 1), "b");
+    EXPECT(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{50});
+    // the rest of a chunk is returned immediately
+    EXPECT_EQ(Receive(pty, 16), "c");
+    EXPECT_EQ(Receive(pty, 16), "d");
+    EXPECT(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{100});
+    EXPECT_EQ(Receive(pty, 16), "");
+    EXPECT(pty.terminated());
+}
+
+TEST(replay_pty, terminateWhileWaiting) {
+    ReplayPTYMaster pty{Chunks({{0, "a"}, {60000, "b"}}), true};
+    EXPECT_EQ(Receive(pty, 16), "a");
+    std::thread t{[&pty](){
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        pty.terminate();
+    }};
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(Receive(pty, 16), "");
+    EXPECT(std::chrono::steady_clock::now() - start < std::chrono::seconds{5});
+    t.join();
+}
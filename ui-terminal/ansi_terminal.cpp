@@ -1,6 +1,14 @@
 #include <functional>
 
-#include "helpers/memory.h"
+#if (defined __AVX2__)
+#include <immintrin.h>
+#elif (defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2))
+#define SSE2_ASCII_SCAN
+#include <emmintrin.h>
+#endif
+#if (defined _MSC_VER)
+#include <intrin.h>
+#endif
 
 #include "ansi_terminal.h"
 
@@ -28,6 +36,139 @@ namespace ui {
                 printableKeys.insert(Key::FromCode(k));
             }
         }
+
+#if (defined __AVX2__ || defined SSE2_ASCII_SCAN)
+        /** Returns the number of trailing zero bits in given mask, which must not be zero. 
+         */
+        unsigned CountTrailingZeros(unsigned mask) {
+            ASSERT(mask != 0);
+#if (defined _MSC_VER)
+            unsigned long result;
+            _BitScanForward(&result, mask);
+            return static_cast<unsigned>(result);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+#endif
+
+        /** Maximum number of characters of a printable ASCII run written to the buffer in a single step. 
+
+            The buffer lock can only be yielded between the steps, so this bounds the time the UI thread may have to wait for it. 
+         */
+        constexpr size_t MAX_ASCII_RUN = 16384;
+
+        /** Number of input bytes processed between the checks whether the buffer lock should be yielded to the UI thread. 
+
+            The lock is only yielded between complete characters and escape sequences so that the UI never sees the effects of a partially parsed sequence. 
+         */
+        constexpr size_t YIELD_INTERVAL = 4096;
+
+        /** Counts line feeds in the input that can be coalesced with a line feed that scrolls the whole region. 
+         
+            Scrolling k lines at once and moving the cursor k - 1 rows up gives the same result as k separate scrolls as long as the rows scrolled out are not modified in between, the scrolled in rows are filled with the same cell and the cursor never leaves the last row of the region other than by the line feeds. The first holds as long as k is smaller than the region height, the second as long as only text, CR and TAB separate the line feeds. Escape sequences and other control characters stop the counting. 
+            
+            For the last condition the cursor column, starting at given column, is tracked and the counting stops before any character, tab, or line feed that would wrap the cursor to the next row, because the wrap would move the cursor into the rows that the coalesced scroll assumes are still to be scrolled in. Each UTF8 encoded character is assumed to take a single column, as it does when written to the buffer. 
+         */
+        int CountCoalescableLFs(char const * x, char const * bufferEnd, int max, int col, int width) {
+            int result = 0;
+            for (; x != bufferEnd && result < max; ++x) {
+                char c = *x;
+                if (c >= 0 && c < 0x20) {
+                    if (col >= width) {
+                        break;
+                    } else if (c == Char::LF) {
+                        ++result;
+                    } else if (c == Char::CR) {
+                        col = 0;
+                    } else if (c == Char::TAB) {
+                        col += 8 - col % 8;
+                    } else {
+                        break;
+                    }
+                // UTF8 continuation bytes do not advance the cursor
+                } else if ((c & 0xc0) != 0x80) {
+                    if (col >= width)
+                        break;
+                    ++col;
+                }
+            }
+            return result;
+        }
+
+        /** Returns the end of the run of printable ASCII characters (0x20 - 0x7e inclusive) that starts at given position. 
+         
+            Plain 7bit text is by far the most common terminal input so the scan is vectorized where SSE2 or AVX2 is available. The comparisons are signed so that bytes above 0x7f (UTF8 multibyte sequences) fail the lower bound check. The scalar loop finishes the tail and serves as the fallback on other architectures. 
+         */
+        char const * PrintableASCIIRunEnd(char const * x, char const * bufferEnd) {
+#if (defined __AVX2__)
+            __m256i const lower = _mm256_set1_epi8(0x1f);
+            __m256i const upper = _mm256_set1_epi8(0x7f);
+            while (bufferEnd - x >= 32) {
+                __m256i v = _mm256_loadu_si256(pointer_cast<__m256i const *>(x));
+                __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(v, lower), _mm256_cmpgt_epi8(upper, v));
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(printable));
+                if (mask != 0xffffffff)
+                    return x + CountTrailingZeros(~mask);
+                x += 32;
+            }
+#elif (defined SSE2_ASCII_SCAN)
+            __m128i const lower = _mm_set1_epi8(0x1f);
+            __m128i const upper = _mm_set1_epi8(0x7f);
+            while (bufferEnd - x >= 16) {
+                __m128i v = _mm_loadu_si128(pointer_cast<__m128i const *>(x));
+                __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, lower), _mm_cmpgt_epi8(upper, v));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(printable));
+                if (mask != 0xffff)
+                    return x + CountTrailingZeros(~mask & 0xffff);
+                x += 16;
+            }
+#endif
+            while (x != bufferEnd && *x >= 0x20 && *x < 0x7f)
+                ++x;
+            return x;
+        }
+
+        /** Appends the UTF8 encoding of given codepoint to the string. 
+         
+            Unlike Char, any 21bit value is encoded so that the cell codepoints survive the round trip unchanged. 
+         */
+        void EncodeCodepoint(char32_t cp, std::string & into) {
+            if (cp < 0x80) {
+                into.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                into.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+                into.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            } else if (cp < 0x10000) {
+                into.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+                into.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                into.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            } else {
+                into.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+                into.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+                into.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                into.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            }
+        }
+
+        /** Decodes codepoint encoded by EncodeCodepoint() and advances the input past it. 
+         */
+        char32_t DecodeCodepoint(char const * & x) {
+            unsigned char const * u = pointer_cast<unsigned char const *>(x);
+            if (u[0] < 0x80) {
+                x += 1;
+                return u[0];
+            } else if (u[0] < 0xe0) {
+                x += 2;
+                return ((u[0] & 0x1f) << 6) | (u[1] & 0x3f);
+            } else if (u[0] < 0xf0) {
+                x += 3;
+                return ((u[0] & 0x0f) << 12) | ((u[1] & 0x3f) << 6) | (u[2] & 0x3f);
+            } else {
+                x += 4;
+                return ((u[0] & 0x07) << 18) | ((u[1] & 0x3f) << 12) | ((u[2] & 0x3f) << 6) | (u[3] & 0x3f);
+            }
+        }
     }
 
     std::unordered_map<Key, std::string> AnsiTerminal::KeyMap_;
@@ -42,11 +183,12 @@ namespace ui {
 
     char32_t AnsiTerminal::LineDrawingChars_[15] = {0x2518, 0x2510, 0x250c, 0x2514, 0x253c, 0, 0, 0x2500, 0, 0, 0x251c, 0x2524, 0x2534, 0x252c, 0x2502};
 
-    AnsiTerminal::AnsiTerminal(tpp::PTYMaster * pty, Palette && palette):
-        PTYBuffer{pty},
+    AnsiTerminal::AnsiTerminal(tpp::PTYMaster * pty, Palette && palette, tpp::PTYCapture::Writer * capture):
+        PTYBuffer{pty, capture},
         palette_{palette},
         state_{new State{palette.defaultBackground()}},
-        stateBackup_{new State{palette.defaultBackground()}} {
+        stateBackup_{new State{palette.defaultBackground()}},
+        history_{new History{}} {
         if (KeyMap_.empty()) {
             InitializeKeyMap(KeyMap_);
             InitializePrintableKeys(PrintableKeys_);
@@ -63,6 +205,7 @@ namespace ui {
         terminatePty();
         delete state_;
         delete stateBackup_;
+        delete history_;
     }
 
     // Widget
@@ -75,21 +218,51 @@ namespace ui {
         Rect visibleRect{ccanvas.visibleRect()};
         std::lock_guard<PriorityLock> g(bufferLock_.priorityLock(), std::adopt_lock);
         int top = terminalBufferTop();
-        ccanvas.setBg(palette_.defaultBackground());
-        // see if there are any history lines that need to be drawn
-        for (int row = std::max(0, visibleRect.top()), re = std::min(top, visibleRect.bottom()); row < re ; ++row) {
-            for (int col = 0, ce = historyRows_[row].first; col < ce; ++col) {
-                ccanvas.at(Point{col, row}).stripSpecialObjectAndAssign(historyRows_[row].second[col]);
+        Buffer & buffer = state_->buffer;
 #ifdef SHOW_LINE_ENDINGS
-                if (Buffer::IsLineEnd(historyRows_[row].second[col]))
-                    ccanvas.setBorder(Point{col, row}, endOfLine);
+        // changes of the line end flags alone do not mark the rows as dirty, so the line endings can only be displayed correctly if the whole terminal is repainted
+        repaintAll_ = true;
+#endif
+        if (! repaintAll_ 
+            && paintedDirectly() 
+            && visibleRect == lastPaintRect_ 
+            && toRendererCoordinates(Point{0, 0}) == lastPaintOffset_ 
+            && top == lastPaintTop_) {
+            // the history rows are unchanged, repaint only the changed buffer rows and the row with the old cursor
+            if (lastPaintCursorRow_ >= 0 && lastPaintCursorRow_ < buffer.height())
+                buffer.markDirty(lastPaintCursorRow_);
+            for (int row = std::max(top, visibleRect.top()) - top, re = std::min(top + buffer.height(), visibleRect.bottom()) - top; row < re; ++row) {
+                if (! buffer.isDirty(row))
+                    continue;
+                int end = row + 1;
+                while (end < re && buffer.isDirty(end))
+                    ++end;
+                ccanvas.drawFallbackBuffer(buffer, Rect{Point{0, row}, Point{buffer.width(), end}}, Point{0, top + row});
+                row = end;
+            }
+        } else {
+            canvas.fill(canvas.rect());
+            ccanvas.setBg(palette_.defaultBackground());
+            // see if there are any history lines that need to be drawn
+            for (int row = std::max(0, visibleRect.top()), re = std::min(top, visibleRect.bottom()); row < re ; ++row) {
+                auto historyRow = history_->row(row);
+                for (int col = 0, ce = historyRow.second; col < ce; ++col) {
+                    ccanvas.at(Point{col, row}).stripSpecialObjectAndAssign(historyRow.first[col]);
+#ifdef SHOW_LINE_ENDINGS
+                    if (Buffer::IsLineEnd(historyRow.first[col]))
+                        ccanvas.setBorder(Point{col, row}, endOfLine);
 #endif
+                }
+                ccanvas.fill(Rect{Point{historyRow.second, row}, Point{width(), row + 1}},
+                Cell{}.setBg(ccanvas.bg()));
             }
-            ccanvas.fill(Rect{Point{historyRows_[row].first, row}, Point{width(), row + 1}},
-            Cell{}.setBg(ccanvas.bg()));
+            // TODO once we support sixels or other shared objects that might survive to the drawing stage, this function will likely change. 
+            ccanvas.drawFallbackBuffer(buffer, Point{0, top});
+            lastPaintRect_ = visibleRect;
+            lastPaintOffset_ = toRendererCoordinates(Point{0, 0});
+            lastPaintTop_ = top;
         }
-        // TODO once we support sixels or other shared objects that might survive to the drawing stage, this function will likely change. 
-        ccanvas.drawFallbackBuffer(state_->buffer, Point{0, top});
+        buffer.clearDirty();
 #ifdef  SHOW_LINE_ENDINGS
         // now add borders to the cells that are marked as end of line
         for (int row = std::max(top, visibleRect.top()), rs = row, re = visibleRect.bottom(); ; ++row) {
@@ -101,8 +274,9 @@ namespace ui {
             }
         }
 #endif
-        // draw the selection, if any 
+        // draw the selection, if any, the selection has to be erased by repainting the whole terminal 
         SelectionOwner::paint(ccanvas);
+        repaintAll_ = ! selection().empty();
         // display scrollbars
         canvas.verticalScrollbar(top + height(), scrollOffset().y());
         // draw the cursor 
@@ -113,6 +287,7 @@ namespace ui {
             // TODO the color of this should be configurable
             ccanvas.setBorder(cursorPosition() + Point{0, top}, Border::All(inactiveCursorColor_, Border::Kind::Thin));
         }
+        lastPaintCursorRow_ = cursorPosition().y();
     }
 
     // User Input
@@ -186,12 +361,14 @@ namespace ui {
                 if (activeHyperlink_ != nullptr && activeHyperlink_ != a) {
                     activeHyperlink_->setActive(false);
                     activeHyperlink_ = nullptr;
+                    repaintAll_ = true;
                     repaint();
                     setMouseCursor(MouseCursor::Default);
                 }
                 if (activeHyperlink_ == nullptr && a != nullptr) {
                     activeHyperlink_ = a;
                     activeHyperlink_->setActive(true);
+                    repaintAll_ = true;
                     repaint();
                     setMouseCursor(MouseCursor::Hand);
                 }
@@ -258,7 +435,7 @@ namespace ui {
     void AnsiTerminal::mouseWheel(MouseWheelEvent::Payload & e) {
         onMouseWheel(e, this);
         if (e.active()) {
-            if (! alternateMode_ && historyRows_.size() > 0) {
+            if (! alternateMode_ && history_->rows() > 0) {
                 if (e->by > 0)
                     scrollBy(Point{0, -1});
                 else 
@@ -342,16 +519,17 @@ namespace ui {
         int endRow = sel.end().y();
         int col = sel.start().x();
         std::lock_guard<PriorityLock> g(bufferLock_);
-        int terminalTop =  alternateMode_ ? 0 : static_cast<int>(historyRows_.size());
+        int terminalTop = terminalBufferTop();
         while (row < endRow) {
             int endCol = (row < endRow - 1) ? width() : sel.end().x();
-            Cell * rowCells;
+            Cell const * rowCells;
             // if the current row comes from the history, get the appropriate cells
             if (row < terminalTop) {
-                rowCells = historyRows_[row].second;
+                auto historyRow = history_->row(row);
+                rowCells = historyRow.first;
                 // if the stored row is shorter than the start of the selection, adjust the endCol so that no processing will be involved
-                if (endCol > historyRows_[row].first)
-                    endCol = historyRows_[row].first;
+                if (endCol > historyRow.second)
+                    endCol = historyRow.second;
             } else {
                 rowCells = state_->buffer.row(row - terminalTop);
             }
@@ -452,44 +630,42 @@ namespace ui {
         if (matchSize == 0)
             return;
         // we have found a hyperlink, construct its address and determine which cells to use, which we do by retracting
-        Hyperlink::Ptr link{new Hyperlink{"", normalHyperlinkStyle_, activeHyperlinkStyle_}};
         std::string url{};
         Point pos = cursorPosition();
-        do {
+        for (size_t i = 0; i < matchSize; ++i) {
             // the url is too long and disappeared, do not match
-            if (pos == Point{0,0}) {
-                link->detachFromAllCells();
+            if (pos == Point{0,0})
                 return;
-            }
             if (pos.x() == 0)
                 pos = Point{state_->buffer.width() - 1, pos.y() - 1};
             else 
                 pos -= Point{1, 0};
-            Cell & cell = state_->buffer.at(pos);
-            url = Char{cell.codepoint()} + url;
-            cell.attachSpecialObject(link);
-        } while (--matchSize != 0);
-        // set the url we calculated
-        link->setUrl(url);
+            url = Char{state_->buffer.at(pos).codepoint()} + url;
+        }
+        // attach the hyperlink to the cells, starting at the first one
+        Hyperlink::Ptr link{new Hyperlink{url, normalHyperlinkStyle_, activeHyperlinkStyle_}};
+        for (size_t i = 0; i < matchSize; ++i) {
+            state_->buffer.attachSpecialObject(pos, link);
+            state_->buffer.markDirty(pos.y());
+            if (pos.x() == state_->buffer.width() - 1)
+                pos = Point{0, pos.y() + 1};
+            else
+                pos += Point{1, 0};
+        }
     }
 
     // Terminal State 
 
     void AnsiTerminal::deleteCharacters(unsigned num) {
-		int r = cursorPosition().y();
-		for (unsigned c = cursorPosition().x(), e = state_->buffer.width() - num; c < e; ++c) 
-			state_->buffer.at(c, r) = state_->buffer.at(c + num, r);
-		for (unsigned c = state_->buffer.width() - num, e = state_->buffer.width(); c < e; ++c)
-			state_->buffer.at(c, r) = state_->cell;
+        int n = static_cast<int>(std::min(num, static_cast<unsigned>(state_->buffer.width())));
+        state_->buffer.deleteCells(cursorPosition().y(), cursorPosition().x(), n, state_->cell);
+        state_->buffer.markDirty(cursorPosition().y());
     }
 
     void AnsiTerminal::insertCharacters(unsigned num) {
-		unsigned r = cursorPosition().y();
-		// first copy the characters
-		for (unsigned c = state_->buffer.width() - 1, e = cursorPosition().x() + num; c >= e; --c)
-			state_->buffer.at(c, r) = state_->buffer.at(c - num, r);
-		for (unsigned c = cursorPosition().x(), e = cursorPosition().x() + num; c < e; ++c)
-			state_->buffer.at(c, r) = state_->cell;
+        int n = static_cast<int>(std::min(num, static_cast<unsigned>(state_->buffer.width())));
+        state_->buffer.insertCells(cursorPosition().y(), cursorPosition().x(), n, state_->cell);
+        state_->buffer.markDirty(cursorPosition().y());
     }
     
     void AnsiTerminal::updateCursorPosition() {
@@ -516,87 +692,77 @@ namespace ui {
 
     // Scrollback buffer
 
+    /** The lines are inserted in a single step. If the region is invalid (such as when the cursor is outside of the scroll region), nothing happens and if there are more lines than the region size, the whole region is cleared. 
+     */
     void AnsiTerminal::insertLines(int lines, int top, int bottom, Cell const & fill) {
-        while (lines-- > 0)
-            state_->buffer.insertLine(top, bottom, fill);
+        bottom = std::min(bottom, state_->buffer.height());
+        if (top < 0 || top >= bottom || lines <= 0)
+            return;
+        state_->buffer.insertLines(std::min(lines, bottom - top), top, bottom, fill);
     }
 
-    /** If history is enabled, i.e. when history limit is greater than 0 and the terminal is not in alternate mode, the deleted line is added to the history. 
+    /** If history is enabled, i.e. when history limit is greater than 0 and the terminal is not in alternate mode, the deleted lines are added to the history. The lines are then deleted in a single step. 
+     
+        Like insertLines(), invalid regions are ignored and the number of lines is capped by the region size. 
      */
     void AnsiTerminal::deleteLines(int lines, int top, int bottom, Cell const & fill) {
-        // scroll the lines
-        while (lines-- > 0) {
-            if (! alternateMode_ && maxHistoryRows_ != 0) {
-                auto removedRow = state_->buffer.copyRow(top, palette_.defaultBackground());
+        bottom = std::min(bottom, state_->buffer.height());
+        if (top < 0 || top >= bottom || lines <= 0)
+            return;
+        lines = std::min(lines, bottom - top);
+        if (! alternateMode_ && history_->limit() != 0) {
+            for (int i = 0; i < lines; ++i) {
+                auto removedRow = state_->buffer.historyRow(top + i, palette_.defaultBackground());
                 addHistoryRow(removedRow.first, removedRow.second);
             }
-            state_->buffer.deleteLine(top, bottom, fill);
+            // if the terminal is scrolled into view, scroll the terminal into view after the history lines have been added as well
+            if (scrollToTerminal_)
+                schedule([this](){
+                    setScrollOffset(Point{0, static_cast<int>(history_->rows())});
+                });
         }
+        state_->buffer.deleteLines(lines, top, bottom, fill);
     }
 
-    /** If the terminal is scrolled into view, scrolls the terminal into view after the history line has been added as well. 
-     */
-    void AnsiTerminal::addHistoryRow(Cell * row, int cols) {
+    void AnsiTerminal::addHistoryRow(Cell const * row, int cols) {
+        repaintAll_ = true;
         if (cols <= width()) {
-            historyRows_.push_back(std::make_pair(cols, row));
+            history_->addRow(row, cols);
         // if the line is too long, simply chop it in pieces of maximal length
         } else {
-            Cell * i = row;
             while (cols != 0) {
                 int xSize = std::min(width(), cols);
-                Cell * x = new Cell[xSize];
-                // copy the cells one by one as they are PODs
-                MemCopy(x, i, xSize);
-                i += xSize;
+                history_->addRow(row, xSize);
+                row += xSize;
                 cols -= xSize;
-                historyRows_.push_back(std::make_pair(xSize, x));
             }
-            delete [] row;
         }
-        while (historyRows_.size() > static_cast<size_t>(maxHistoryRows_)) {
-            delete [] historyRows_.front().second;
-            historyRows_.pop_front();
-        }
-        if (scrollToTerminal_)
-            schedule([this](){
-                setScrollOffset(Point{0, static_cast<int>(historyRows_.size())});
-            });
     }
 
+    /** Joins the wrapped rows of the old history and adds them to a new history so that they are wrapped to the new width. 
+     */
     void AnsiTerminal::resizeHistory() {
-        std::deque<std::pair<int, Cell*>> oldRows{std::move(historyRows_)};
-        Cell * row = nullptr;
-        int rowSize = 0;
-        for (auto & i : oldRows) {
-            if (row == nullptr) {
-                row = i.second;
-                rowSize = i.first;
-            } else {
-                Cell * newRow = new Cell[rowSize + i.first];
-                MemCopy(newRow, row, rowSize);
-                MemCopy(newRow + rowSize, i.second, i.first);
-                rowSize += i.first;
-                delete [] i.second;
-                delete [] row;
-                row = newRow;
-            }
-            ASSERT(row != nullptr);
-            if (Buffer::IsLineEnd(row[rowSize - 1])) {
-                addHistoryRow(row, rowSize);
-                row = nullptr;
-                rowSize = 0;
+        std::unique_ptr<History> oldHistory{history_};
+        history_ = new History{oldHistory->limit()};
+        std::vector<Cell> row;
+        for (size_t i = 0, e = oldHistory->rows(); i < e; ++i) {
+            auto oldRow = oldHistory->row(i);
+            row.insert(row.end(), oldRow.first, oldRow.first + oldRow.second);
+            if (! row.empty() && Buffer::IsLineEnd(row.back())) {
+                addHistoryRow(row.data(), static_cast<int>(row.size()));
+                row.clear();
             }
         }
-        if (row != nullptr)
-            addHistoryRow(row, rowSize);
+        if (! row.empty())
+            addHistoryRow(row.data(), static_cast<int>(row.size()));
     }
 
     void AnsiTerminal::resizeBuffers(Size size) {
         if (alternateMode_) {
             state_->resize(size, nullptr);
-            stateBackup_->resize(size, std::bind(&AnsiTerminal::addHistoryRow, this, std::placeholders::_1, std::placeholders::_2));
+            stateBackup_->resize(size, [this](Cell const * row, int cols) { addHistoryRow(row, cols); });
         } else {
-            state_->resize(size, std::bind(&AnsiTerminal::addHistoryRow, this, std::placeholders::_1, std::placeholders::_2));
+            state_->resize(size, [this](Cell const * row, int cols) { addHistoryRow(row, cols); });
             stateBackup_->resize(size, nullptr);
         }
     }
@@ -612,10 +778,10 @@ namespace ui {
         } else {
             if (coords.y() < 0)
                 return nullptr;
-            auto const & row = historyRows_[coords.y()];
-            if (coords.x() >= row.first)
+            auto row = history_->row(coords.y());
+            if (coords.x() >= row.second)
                 return nullptr;
-            return row.second + coords.x();
+            return row.first + coords.x();
         }
     }
 
@@ -637,67 +803,87 @@ namespace ui {
 
     // Input Processing
 
+    /** The input is processed by a state machine modelled after the DEC ANSI parser (https://vt100.net/emu/dec_ansi_parser). In the ground state, printable characters and control characters are processed directly, all other states are handled by parseEscapeSequence(). The parser state is kept between the calls so that each byte of the input is processed only once even if escape sequences, or UTF8 characters span multiple reads. The only exception are the t++ sequences, whose payload must be contiguous in the buffer. 
+     
+        The buffer lock is held while processing the input, but it is yielded after each parser step if the UI thread requests it, so that painting and user input are not blocked for the entire input, which can be up to the PTY buffer size. 
+     */
     size_t AnsiTerminal::received(char * buffer, char const * bufferEnd) {
         {
             std::lock_guard<PriorityLock> g(bufferLock_);
             // then process the input
             char const * x = buffer;
+            char const * lastYield = buffer;
             while (x != bufferEnd) {
-                switch (*x) {
-                    /* Parse the escape sequence */
-                    case Char::ESC: {
-                        size_t processed = parseEscapeSequence(x, bufferEnd);
-                        // if no characters were processed, the sequence was incomplete and we should end processing
-                        if (processed == 0)
-                            return x - buffer;
-                        // move past the sequence
-                        x += processed;
-                        break;
+                // if the UI thread waits for the buffer, let it in so that it does not have to wait for the entire input to be processed
+                if (static_cast<size_t>(x - lastYield) >= YIELD_INTERVAL && parserState_ == ParserState::Ground) {
+                    bufferLock_.yieldToPriority();
+                    lastYield = x;
+                }
+                // continuation of UTF8 character from previous input
+                if (parserState_ == ParserState::UTF8) {
+                    utf8Codepoint_ = (utf8Codepoint_ << 6) + (*x++ & 0x3f);
+                    if (--utf8Remaining_ == 0) {
+                        parserState_ = ParserState::Ground;
+                        parseCodepoint(utf8Codepoint_);
                     }
-                    /* BEL triggers the notification */
-                    case Char::BEL:
-                        parseNotification();
-                        ++x;
-                        break;
-                    case Char::TAB:
-                        parseTab();
-                        ++x;
-                        break;
+                    continue;
+                }
+                // if inside an escape sequence, parse it
+                if (parserState_ != ParserState::Ground) {
+                    size_t processed = parseEscapeSequence(x, bufferEnd);
+                    // if no characters were processed, the t++ sequence is incomplete and we should end processing
+                    if (processed == 0)
+                        return x - buffer;
+                    x += processed;
+                    continue;
+                }
+                switch (*x) {
                     case Char::LF:
-                        parseLF();
                         ++x;
+                        parseLF(x, bufferEnd);
                         break;
+                    case Char::ESC:
+                    case Char::BEL:
+                    case Char::TAB:
                     case Char::CR:
-                        parseCR();
-                        ++x;
-                        break;
                     case Char::BACKSPACE:
-                        parseBackspace();
-                        ++x;
+                        parseControlCharacter(*x++);
                         break;
                     default: {
+                        // runs of printable ASCII characters are written to the buffer in bulk, unless there is a state that requires per-character processing
+                        if (*x >= 0x20 && *x < 0x7f && ! lineDrawingSet_ && inProgressHyperlink_ == nullptr && ! SEQ.enabled()) {
+                            char const * runEnd = PrintableASCIIRunEnd(x + 1, x + std::min(static_cast<size_t>(bufferEnd - x), MAX_ASCII_RUN));
+                            parseASCIIRun(x, runEnd);
+                            x = runEnd;
+                            break;
+                        }
                         // while this is a code duplication from the Char class, since this code is a bottleneck for processing large ammounts of text, the code is copied for performance
                         char32_t cp = 0;
                         unsigned char const * ux = pointer_cast<unsigned char const *>(x);
+                        unsigned size = 1;
                         if (*ux < 0x80) {
                             cp = *ux;
-                            ++x;
                         } else if (*ux < 0xe0) {
-                            if (x + 2 > bufferEnd)
-                                return x - buffer;
-                            cp = ((ux[0] & 0x1f) << 6) + (ux[1] & 0x3f);
-                            x += 2;
+                            cp = ux[0] & 0x1f;
+                            size = 2;
                         } else if (*ux < 0xf0) {
-                            if (x + 3 > bufferEnd)
-                                return x - buffer;
-                            cp = ((ux[0] & 0x0f) << 12) + ((ux[1] & 0x3f) << 6) + (ux[2] & 0x3f);
-                            x += 3;
+                            cp = ux[0] & 0x0f;
+                            size = 3;
                         } else {
-                            if (x + 4 > bufferEnd)
-                                return x - buffer;
-                            cp = ((ux[0] & 0x07) << 18) + ((ux[1] & 0x3f) << 12) + ((ux[2] & 0x3f) << 6) + (ux[3] & 0x3f);
-                            x += 4;
+                            cp = ux[0] & 0x07;
+                            size = 4;
+                        }
+                        // if the character is not complete in the input, remember its first byte and decode the rest when more input is available
+                        if (x + size > bufferEnd) {
+                            utf8Codepoint_ = cp;
+                            utf8Remaining_ = size - 1;
+                            parserState_ = ParserState::UTF8;
+                            ++x;
+                            break;
                         }
+                        for (unsigned i = 1; i < size; ++i)
+                            cp = (cp << 6) + (ux[i] & 0x3f);
+                        x += size;
                         parseCodepoint(cp);
                         break;
                     }
@@ -718,8 +904,7 @@ namespace ui {
             detectHyperlink(codepoint);
         updateCursorPosition();
         // set the cell according to the codepoint and current settings. If there is an active hyperlink, the hyperlink is first attached to the cell and then new cell is added to the hyperlink fallback 
-        Cell & cell = state_->buffer.at(cursorPosition());
-        cell = state_->cell;
+        Cell cell{state_->cell};
         // attach hyperlink special object, of one is active
         if (inProgressHyperlink_ != nullptr)
             cell.attachSpecialObject(inProgressHyperlink_);
@@ -731,6 +916,13 @@ namespace ui {
             //columnWidth = 1;
             cell.font().setDoubleWidth(true);
         }
+        // update the buffer, marking the row as changed only if the cell's contents differs
+        Cell & target = state_->buffer.at(cursorPosition());
+        if (! state_->buffer.isDirty(cursorPosition().y()) && target != cell)
+            state_->buffer.markDirty(cursorPosition().y());
+        target = cell;
+        if (cell.hasSpecialObject())
+            state_->buffer.markSpecialObjects(cursorPosition().y());
 
         // advance cursor's column
         setCursorPosition(cursorPosition() + Point{1, 0});
@@ -763,6 +955,71 @@ namespace ui {
         */
     }
 
+    /** The run is split into row segments. For each segment the cursor position is updated only once, which wraps and scrolls the buffer as necessary, and the cells of the segment are then written directly. The end result is identical to calling parseCodepoint() for each character, provided that the line drawing set and in progress hyperlink are not active. 
+     */
+    void AnsiTerminal::parseASCIIRun(char const * begin, char const * end) {
+        ASSERT(! lineDrawingSet_ && inProgressHyperlink_ == nullptr);
+        while (begin != end) {
+            // as in parseCodepoint(), the hyperlink detection must precede the cursor update
+            if (detectHyperlinks_)
+                detectHyperlink(static_cast<char32_t>(*begin));
+            updateCursorPosition();
+            Point pos = cursorPosition();
+            int n = std::min(static_cast<int>(end - begin), state_->buffer.width() - pos.x());
+            Cell * row = state_->buffer.row(pos.y()) + pos.x();
+            Cell cell{state_->cell};
+            bool changed = state_->buffer.isDirty(pos.y());
+            for (int i = 0; i < n; ++i) {
+                // hyperlink detection examines the cells before the cursor, so the cursor must be up to date when a character is matched
+                if (detectHyperlinks_ && i > 0) {
+                    setCursorPosition(pos + Point{i, 0});
+                    detectHyperlink(static_cast<char32_t>(begin[i]));
+                }
+                cell.setCodepoint(static_cast<char32_t>(begin[i]));
+                changed = changed || row[i] != cell;
+                row[i] = cell;
+            }
+            if (changed)
+                state_->buffer.markDirty(pos.y());
+            state_->setLastCharacter(pos + Point{n - 1, 0});
+            setCursorPosition(pos + Point{n, 0});
+            begin += n;
+        }
+    }
+
+    /** Besides the ground state, C0 control characters are executed in the middle of escape sequences as well. The exceptions are ESC, which starts a new escape sequence and CAN and SUB which cancel the sequence being parsed. Other control characters are ignored. 
+     */
+    void AnsiTerminal::parseControlCharacter(char c) {
+        switch (c) {
+            case Char::ESC:
+                parserState_ = ParserState::Escape;
+                break;
+            case Char::CAN:
+            case Char::SUB:
+                parserState_ = ParserState::Ground;
+                break;
+            /* BEL triggers the notification */
+            case Char::BEL:
+                parseNotification();
+                break;
+            case Char::TAB:
+                parseTab();
+                break;
+            case Char::LF:
+                parseLF();
+                break;
+            case Char::CR:
+                parseCR();
+                break;
+            case Char::BACKSPACE:
+                parseBackspace();
+                break;
+            default:
+                LOG(SEQ_UNKNOWN) << "Ignored control character " << static_cast<int>(c);
+                break;
+        }
+    }
+
     void AnsiTerminal::parseNotification() {
         schedule([this](){
             VoidEvent::Payload p;
@@ -780,7 +1037,9 @@ namespace ui {
         LOG(SEQ) << "Tab: cursor col is " << cursorPosition().x();
     }
 
-    void AnsiTerminal::parseLF() {
+    /** When the line feed scrolls the region, the line feeds that follow in the input can be coalesced into the same scroll operation, provided that they are separated only by text that does not wrap and the result is identical to scrolling the region line by line. See CountCoalescableLFs() for the details. The cursor is then moved up by the extra lines so that the coalesced line feeds only move the cursor down. 
+     */
+    void AnsiTerminal::parseLF(char const * next, char const * bufferEnd) {
         LOG(SEQ) << "LF";
         resetHyperlinkDetection();
         state_->markLineEnd();
@@ -789,8 +1048,11 @@ namespace ui {
         setCursorPosition(cursorPosition() + Point{0, 1});
         // determine if region should be scrolled
         if (cursorPosition().y() == state_->scrollEnd) {
-            deleteLines(1, state_->scrollStart, state_->scrollEnd, state_->cell);
-            setCursorPosition(cursorPosition() - Point{0, 1});
+            int lines = 1;
+            if (next != nullptr)
+                lines += CountCoalescableLFs(next, bufferEnd, state_->scrollEnd - state_->scrollStart - 2, cursorPosition().x(), state_->buffer.width());
+            deleteLines(lines, state_->scrollStart, state_->scrollEnd, state_->cell);
+            setCursorPosition(cursorPosition() - Point{0, lines});
         }
         // update the cursor position as LF takes immediate effect
         updateCursorPosition();
@@ -817,39 +1079,106 @@ namespace ui {
     }
 
     size_t AnsiTerminal::parseEscapeSequence(char const * buffer, char const * bufferEnd) {
-        ASSERT(*buffer == Char::ESC);
-        // if we have nothing after the escape character, it is incomplete sequence
+        ASSERT(parserState_ != ParserState::Ground && parserState_ != ParserState::UTF8);
         char const * x = buffer;
-        if (++x == bufferEnd)
-            return 0;
-        switch (*x++) {
-            /* CSI Sequence. */
-            case '[': {
-                x -= 2;
-                CSISequence seq{CSISequence::Parse(x, bufferEnd)};
-                // if the sequence is not valid, it has been reported already and we should just exit
-                if (!seq.valid())
+        switch (parserState_) {
+            /* The character after ESC determines the sequence. */
+            case ParserState::Escape:
+                parseEscapeCharacter(*x++);
+                break;
+    		/* Character set specification - most cases are ignored, with the exception of the box drawing and reset to english (0 and B) respectively. 
+             */
+            case ParserState::Charset: {
+                if (*x >= 0 && *x < 0x20) {
+                    parseControlCharacter(*x++);
                     break;
-                // if the sequence is not complete, return false and do not advance the buffer
-                if (!seq.complete())
-                    return false;
-                // otherwise parse the CSI sequence
-                parseCSISequence(seq);
+                }
+                char c = *x++;
+                parserState_ = ParserState::Ground;
+                if (charset_ == '(' && c == '0') {
+                    lineDrawingSet_ = true;
+                    LOG(SEQ) << "Line drawing set selected";
+                } else if (charset_ == '(' && c == 'B') {
+                    lineDrawingSet_ = false;
+                    LOG(SEQ) << "Normal character set selected";
+                } else if (c != 'B') { // US
+                    LOG(SEQ_WONT_SUPPORT) << "Unknown (possibly mismatched) character set final char " << c;
+                }
                 break;
             }
+            /* CSI Sequence. */
+            case ParserState::CSI:
+                if (csiSequence_.parse(x, bufferEnd)) {
+                    parserState_ = ParserState::Ground;
+                    // invalid sequences are ignored
+                    if (csiSequence_.valid())
+                        parseCSISequence(csiSequence_);
+                } else if (x != bufferEnd) {
+                    parseControlCharacter(*x++);
+                }
+                break;
             /* OSC (Operating System Command) */
-            case ']': {
-                x -= 2;
-                OSCSequence seq{OSCSequence::Parse(x, bufferEnd)};
-                // if the sequence is not valid, it has been reported already and we should just exit
-                if (!seq.valid())
-                    break;
-                // if the sequence is not complete, return false and do not advance the buffer
-                if (!seq.complete())
-                    return false;
-                parseOSCSequence(seq);
-				break;
-            }
+            case ParserState::OSC:
+                if (oscSequence_.parse(x, bufferEnd)) {
+                    parserState_ = ParserState::Ground;
+                    // invalid sequences are ignored
+                    if (oscSequence_.valid())
+                        parseOSCSequence(oscSequence_);
+                }
+                break;
+            /* Device Control String (DCS). 
+             */
+            case ParserState::DCS:
+                if (*x == '+') {
+                    // frees the UI thread to draw the buffer while we are dealing with the tpp sequence
+                    bufferLock_.unlock();
+                    size_t p = parseTppSequence(x, bufferEnd);
+                    bufferLock_.lock();
+                    // the tpp sequence is not complete, keep the state and wait for more data
+                    if (p == 0)
+                        return 0;
+                    x += p;
+                    parserState_ = ParserState::Ground;
+                } else if (*x >= 0 && *x < 0x20) {
+                    parseControlCharacter(*x++);
+                } else {
+                    LOG(SEQ_UNKNOWN) << "Unknown DCS sequence";
+                    parserState_ = ParserState::DCSIgnore;
+                }
+                break;
+            /* The contents of unknown DCS sequences is ignored up to the string terminator (or BEL, which is used by t++ sequences). 
+             */
+            case ParserState::DCSIgnore:
+                while (x != bufferEnd) {
+                    char c = *x++;
+                    if (c == Char::ESC || c == Char::CAN || c == Char::SUB) {
+                        parseControlCharacter(c);
+                        break;
+                    } else if (c == Char::BEL) {
+                        parserState_ = ParserState::Ground;
+                        break;
+                    }
+                }
+                break;
+            default:
+                UNREACHABLE;
+        }
+        return x - buffer;
+    }
+
+    void AnsiTerminal::parseEscapeCharacter(char c) {
+        parserState_ = ParserState::Ground;
+        switch (c) {
+            /* CSI Sequence. */
+            case '[':
+                csiSequence_.clear();
+                parserState_ = ParserState::CSI;
+                break;
+            /* OSC (Operating System Command) */
+            case ']':
+                oscSequence_.clear();
+                parserState_ = ParserState::OSC;
+                break;
 			/* Save Cursor. */
 			case '7':
 				LOG(SEQ) << "DECSC: Cursor position saved";
@@ -876,51 +1205,21 @@ namespace ui {
              */
             case 'P':
                 resetHyperlinkDetection();
-                if (x == bufferEnd)
-                    return false;
-                if (*x == '+') {
-                    resetHyperlinkDetection();
-                    // frees the UI thread to draw the buffer while we are dealing with the tpp sequence
-                    bufferLock_.unlock();
-                    size_t p = parseTppSequence(buffer, bufferEnd);
-                    bufferLock_.lock();
-                    return p;
-                } else {
-                    LOG(SEQ_UNKNOWN) << "Unknown DCS sequence";
-                }
+                parserState_ = ParserState::DCS;
                 break;
-    		/* Character set specification - most cases are ignored, with the exception of the box drawing and reset to english (0 and B) respectively. 
+            /* String terminator, which terminates ignored strings. */
+            case '\\':
+                break;
+    		/* Character set specification, the character set itself follows. 
              */
 			case '(':
-                resetHyperlinkDetection();
-                if (x != bufferEnd) {
-                    if (*x == '0') {
-                        ++x;
-                        lineDrawingSet_ = true;
-                        LOG(SEQ) << "Line drawing set selected";
-                        break;
-                    } else if (*x == 'B') {
-                        ++x;
-                        lineDrawingSet_ = false;
-                        LOG(SEQ) << "Normal character set selected";
-                        break;
-                    }
-                }
-                [[fallthrough]]; // fallthrough
 			case ')':
 			case '*':
 			case '+':
-				// missing character set specification
                 resetHyperlinkDetection();
-				if (x == bufferEnd)
-					return false;
-				if (*x == 'B') { // US
-					++x;
-					break;
-				}
-				LOG(SEQ_WONT_SUPPORT) << "Unknown (possibly mismatched) character set final char " << *x;
-				++x;
-				break;
+                charset_ = c;
+                parserState_ = ParserState::Charset;
+                break;
 			/* ESC = -- Application keypad */
 			case '=':
 				LOG(SEQ) << "Application keypad mode enabled";
@@ -943,16 +1242,21 @@ namespace ui {
                 break;
                 */
             default:
+                // control characters are executed, keeping the escape state
+                if (c >= 0 && c < 0x20) {
+                    parserState_ = ParserState::Escape;
+                    parseControlCharacter(c);
+                    break;
+                }
                 resetHyperlinkDetection();
-				LOG(SEQ_UNKNOWN) << "Unknown escape sequence \x1b" << *(x-1);
+				LOG(SEQ_UNKNOWN) << "Unknown escape sequence \x1b" << c;
 				break;
         }
-        return x - buffer;
     }
 
     size_t AnsiTerminal::parseTppSequence(char const * buffer, char const * bufferEnd) {
-        // we know that we have at least \033P+   
-        char const * i = buffer + 3;
+        // we know that we have at least +
+        char const * i = buffer + 1;
         char const * tppEnd = tpp::Sequence::FindSequenceEnd(i, bufferEnd);
         // if not found, we need more data
         if (tppEnd == bufferEnd) 
@@ -1046,28 +1350,28 @@ namespace ui {
                         switch (seq[0]) {
                             case 0:
                                 updateCursorPosition();
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{cursorPosition(), Point{state_->buffer.width(), cursorPosition().y() + 1}},
                                     state_->cell
                                 );
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{Point{0, cursorPosition().y() + 1}, Point{state_->buffer.width(), state_->buffer.height()}},                                
                                     state_->cell
                                 );
                                 return;
                             case 1:
                                 updateCursorPosition();
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{Point{}, Point{state_->buffer.width(), cursorPosition().y()}},
                                     state_->cell
                                 );
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{Point{0, cursorPosition().y()}, cursorPosition() + Point{1,1}},
                                     state_->cell
                                 );
                                 return;
                             case 2:
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{state_->buffer.size()},
                                     state_->cell
                                 );
@@ -1087,21 +1391,21 @@ namespace ui {
                         switch (seq[0]) {
                             case 0:
                                 updateCursorPosition();
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{cursorPosition(), Point{state_->buffer.width(), cursorPosition().y() + 1}},
                                     state_->cell
                                 );
                                 return;
                             case 1:
                                 updateCursorPosition();
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{Point{0, cursorPosition().y()}, Point{cursorPosition().x() + 1, cursorPosition().y() + 1}},
                                     state_->cell
                                 );
                                 return;
                             case 2:
                                 updateCursorPosition();
-                                state_->canvas.fill(
+                                state_->buffer.fill(
                                     Rect{Point{0, cursorPosition().y()}, Size{state_->buffer.width(),1}},
                                     state_->cell
                                 );
@@ -1155,7 +1459,7 @@ namespace ui {
                         // erase from first line
                         int n = static_cast<unsigned>(seq[0]);
                         int l = std::min(state_->buffer.width() - cursorPosition().x(), n);
-                        state_->canvas.fill(
+                        state_->buffer.fill(
                             Rect{cursorPosition(), Size{l, 1}},
                             state_->cell
                         );
@@ -1163,7 +1467,7 @@ namespace ui {
                         // while there is enough stuff left to be larger than a line, erase entire line
                         l = cursorPosition().y() + 1;
                         while (n >= state_->buffer.width() && l < state_->buffer.height()) {
-                            state_->canvas.fill(
+                            state_->buffer.fill(
                                 Rect{Point{0,l}, Size{state_->buffer.width(), 1}},
                                 state_->cell    
                             );
@@ -1172,7 +1476,7 @@ namespace ui {
                         }
                         // if there is still something to erase, erase from the beginning
                         if (n != 0 && l < state_->buffer.height())
-                            state_->canvas.fill(
+                            state_->buffer.fill(
                                 Rect{Point{0, l}, Size{n, 1}},
                                 state_->cell
                             );
@@ -1187,6 +1491,7 @@ namespace ui {
                         } else {
                             LOG(SEQ) << "Repeat previous character " << seq[0] << " times";
                             Cell const & prev = state_->buffer.at(cursorPosition() - Point{1, 0});
+                            state_->buffer.markDirty(cursorPosition().y());
                             for (size_t i = 0, e = seq[0]; i < e; ++i) {
                                 state_->buffer.at(cursorPosition()) = prev;
                                 setCursorPosition(cursorPosition() + Point{1,0});
@@ -1420,12 +1725,13 @@ namespace ui {
                         });
                         // perform the mode change
                         std::swap(state_, stateBackup_);
+                        state_->buffer.markAllDirty();
                         alternateMode_ = value;
                         schedule([this](){
                             if (alternateMode_)
                                 setScrollOffset(Point{0, 0});
                             else
-                                setScrollOffset(Point{0, static_cast<int>(historyRows_.size())});
+                                setScrollOffset(Point{0, static_cast<int>(history_->rows())});
                         });
                         // if we are entering the alternate mode, reset the state to default values
                         if (value) {
@@ -1644,7 +1950,7 @@ namespace ui {
                 if (seq.numArgs() != 1)
                     break;
     			LOG(SEQ) << "Title change to " << seq[0];
-                schedule([this, title = seq[0]](){
+                schedule([this, title = std::string{seq[0]}](){
                     StringEvent::Payload p{title};
                     onTitleChange(p, this);
                 });
@@ -1673,7 +1979,7 @@ namespace ui {
                             if (inProgressHyperlink_ != nullptr)
                                 LOG(SEQ_ERROR) << "Unterminaled hyperlink to url " << inProgressHyperlink_->url();
                             LOG(SEQ) << "hyperlink to " << seq[1];
-                            inProgressHyperlink_ = new Hyperlink(seq[1], normalHyperlinkStyle_, activeHyperlinkStyle_);
+                            inProgressHyperlink_ = new Hyperlink(std::string{seq[1]}, normalHyperlinkStyle_, activeHyperlinkStyle_);
                         } else {
                             if (inProgressHyperlink_ == nullptr)
                             LOG(SEQ_ERROR) << "Hyperlink terminated wiothout active one";
@@ -1689,7 +1995,7 @@ namespace ui {
              */
             case 52: {
                 if (seq.numArgs() == 2 && seq[0] == "c") {
-                    std::string text = seq[1];
+                    std::string text{seq[1]};
                     LOG(SEQ) << "Clipboard set to " << text;
                     schedule([this, contents = text]() {
                         StringEvent::Payload p{contents};
@@ -1717,14 +2023,24 @@ namespace ui {
     // ============================================================================================
     // AnsiTerminal::Buffer
 
-    void AnsiTerminal::Buffer::insertLine(int top, int bottom, Cell const & fill) {
-        Cell * x = rows_[bottom - 1];
-        memmove(rows_ + top + 1, rows_ + top, sizeof(Cell*) * (bottom - top - 1));
-        rows_[top] = x;
-        fillRow(top, fill, 0, width());
+    /** Rotates the row pointers so that the rows at the bottom of the region, which are to be discarded, are moved to its top, where they are cleared and reused. 
+     
+        If the region is the entire buffer, the rotation is done in constant time by moving the head of the rows. 
+     */
+    void AnsiTerminal::Buffer::insertLines(int lines, int top, int bottom, Cell const & fill) {
+        ASSERT(lines > 0 && top >= 0 && bottom <= height() && lines <= bottom - top);
+        if (top == 0 && bottom == height()) {
+            rotateRows(height() - lines);
+        } else {
+            std::rotate(rows_ + top, rows_ + bottom - lines, rows_ + bottom);
+            updateMirroredRows(top, bottom);
+        }
+        for (int i = top, e = top + lines; i < e; ++i)
+            fillRow(i, fill, 0, width());
+        markDirty(top, bottom);
     }
 
-    std::pair<AnsiTerminal::Cell *, int> AnsiTerminal::Buffer::copyRow(int row, Color defaultBg) {
+    std::pair<AnsiTerminal::Cell const *, int> AnsiTerminal::Buffer::historyRow(int row, Color defaultBg) {
         int lastCol = width();
         Cell * x = rows_[row];
         while (lastCol-- > 0) {
@@ -1738,36 +2054,60 @@ namespace ui {
             }
         }   
         // if we are not at the end of line, we must remember the whole line
-        if (IsLineEnd(x[lastCol])) 
+        if (lastCol >= 0 && IsLineEnd(x[lastCol])) 
             lastCol += 1;
         else
             lastCol = width();
-        // make the copy and return it
-        Cell * result = new Cell[lastCol];
-        // we cannot use memcopy here because the cells can be special
-        MemCopy(result, x, lastCol);
-        return std::make_pair(result, lastCol);
+        return std::make_pair(x, lastCol);
+    }
+
+    /** Like insertLines(), but the rows at the top of the region are rotated to its bottom. 
+     */
+    void AnsiTerminal::Buffer::deleteLines(int lines, int top, int bottom, Cell const & fill) {
+        ASSERT(lines > 0 && top >= 0 && bottom <= height() && lines <= bottom - top);
+        if (top == 0 && bottom == height()) {
+            rotateRows(lines);
+        } else {
+            std::rotate(rows_ + top, rows_ + top + lines, rows_ + bottom);
+            updateMirroredRows(top, bottom);
+        }
+        for (int i = bottom - lines; i < bottom; ++i)
+            fillRow(i, fill, 0, width());
+        markDirty(top, bottom);
     }
 
-    void AnsiTerminal::Buffer::deleteLine(int top, int bottom, Cell const & fill) {
-        Cell * x = rows_[top];
-        memmove(rows_ + top, rows_ + top + 1, sizeof(Cell*) * (bottom - top - 1));
-        rows_[bottom - 1] = x;
-        fillRow(bottom - 1, fill, 0, width());
+    /** The cells are always overwritten so that any flags they have are cleared, but the contents of rows not already marked dirty is compared first. 
+     */
+    void AnsiTerminal::Buffer::fill(Rect const & rect, Cell const & fill) {
+        Rect r = rect & Rect{size()};
+        if (r.empty())
+            return;
+        for (int row = r.top(), re = r.bottom(); row < re; ++row) {
+            if (! dirty_[row]) {
+                Cell const * cells = rows_[row];
+                for (int col = r.left(), ce = r.right(); col < ce; ++col) {
+                    if (cells[col] != fill) {
+                        dirty_[row] = true;
+                        break;
+                    }
+                }
+            }
+            fillRow(row, fill, r.left(), r.width());
+        }
     }
 
-    void AnsiTerminal::Buffer::resize(Size size, Cell const & fill, std::function<void(Cell*, int)> addToHistory) {
+    void AnsiTerminal::Buffer::resize(Size size, Cell const & fill, std::function<void(Cell const *, int)> addToHistory) {
         if (size_ == size)
             return;
         // determine the line at which the cursor is, which can span multiple terminal lines if it is wrapped. This is important because the contents of the cursor line and all lines below is not being copied to the resized buffer as it should be rewritten by the terminal app
         int stopRow = getCursorRowWrappedStart();
-        // first keep the old rows and size so that we can copy the data from it
-        Cell ** oldRows = rows_;
-        int oldWidth = width();
-        int oldHeight = height();
-        // move the old rows out and call basic buffer resize to adjust width and height, fill the buffer with given cell so that we do not have to deal with uninitialized cells later. 
-        rows_ = nullptr;
+        // first move the old rows out so that we can copy the data from them, they will be deleted when the old buffer goes out of scope
+        Buffer old{std::move(*this)};
+        Cell ** oldRows = old.rows_;
+        int oldWidth = old.width();
+        // call basic buffer resize to adjust width and height, fill the buffer with given cell so that we do not have to deal with uninitialized cells later. 
         Canvas::Buffer::resize(size);
+        dirty_.assign(height(), true);
         this->fill(fill);
         // now copy the contents from the old buffer to the new buffer, line by line, char by char
         // this is where we will be writing to
@@ -1778,6 +2118,8 @@ namespace ui {
                 adjustCursorPosition(fill, addToHistory);
                 // append the character from the old buffer
                 rows_[cursorPosition_.y()][cursorPosition_.x()] = old[col];
+                if (old[col].hasSpecialObject())
+                    markSpecialObjects(cursorPosition_.y());
                 // if the cell is marked as end of line and the rest of the line are just whitespace characters then set position to new line and ignore the whitespace
                 if (IsLineEnd(old[col]) && hasOnlyWhitespace(old, col + 1, oldWidth)) {
                     cursorPosition_ = Point{0, cursorPosition_.y() + 1};
@@ -1789,10 +2131,6 @@ namespace ui {
         }
         // adjust the cursor position after the last character
         adjustCursorPosition(fill, addToHistory);
-        // and delete the old rows
-        for (int i = 0; i < oldHeight; ++i)
-            delete [] oldRows[i];
-        delete [] oldRows;
     }
 
     /** The algorithm is simple. Start at the row one above current cursor position. Then if we find an end of line character on that row, we know the next row was the first line of the cursor. If there is no end of line character, then the line is wordwrapped to the line after it so we check the line above, or if we get all the way to the top of the buffer its the first line by definition.  
@@ -1802,7 +2140,7 @@ namespace ui {
         ASSERT(row < height() && row >= -1);
         while (row >= 0) {
             Cell * cells = rows_[row];
-            for (int col = width(); col >= 0; --col) {
+            for (int col = width() - 1; col >= 0; --col) {
                 if (IsLineEnd(cells[col]))
                     return row + 1;
             }
@@ -1811,18 +2149,15 @@ namespace ui {
         return row + 1;
     }
 
-    void AnsiTerminal::Buffer::adjustCursorPosition(Cell const & fill, std::function<void(Cell*, int)> addToHistory) {
+    void AnsiTerminal::Buffer::adjustCursorPosition(Cell const & fill, std::function<void(Cell const *, int)> addToHistory) {
         // first make sure that the position where we enter the cell is valid
         if (cursorPosition_.x() >= width())
             cursorPosition_ = Point{0, cursorPosition_.y() + 1};
         // if the y coordinate is outside the buffer, we will be scrolling one line up
         if (cursorPosition_.y() >= height()) {
-            if (addToHistory) {
-                Cell * rowCopy = new Cell[width()];
-                MemCopy(rowCopy, rows_[0], width());
-                addToHistory(rowCopy, width());
-            }
-            deleteLine(0, height(), fill);
+            if (addToHistory)
+                addToHistory(rows_[0], width());
+            deleteLines(1, 0, height(), fill);
             cursorPosition_ -= Point{0,1};
         }
     }
@@ -1834,6 +2169,133 @@ namespace ui {
         return true;
     }
 
+    // ============================================================================================
+    // AnsiTerminal::History
+
+    void AnsiTerminal::History::addRow(Cell const * cells, int cols) {
+        ASSERT(cols >= 0);
+        // encode the row into the spans and text first
+        spans_.clear();
+        text_.clear();
+        objects_.clear();
+        for (int i = 0; i < cols; ++i) {
+            Cell const & c = cells[i];
+            Span span;
+            span.cells = 1;
+            span.object = 0;
+            if (c.hasSpecialObject()) {
+                Canvas::SpecialObject * so = c.specialObject();
+                if (objects_.empty() || objects_.back() != so)
+                    objects_.push_back(so);
+                span.object = static_cast<uint32_t>(objects_.size());
+            }
+            span.lineEnd = Buffer::IsLineEnd(c);
+            Style style{c.fg(), c.bg(), c.decor(), c.font(), c.border()};
+            if (! spans_.empty() && spans_.back().first.object == span.object && spans_.back().first.lineEnd == span.lineEnd && spans_.back().second == style)
+                ++spans_.back().first.cells;
+            else
+                spans_.emplace_back(span, style);
+            EncodeCodepoint(c.codepoint(), text_);
+        }
+        size_t size = sizeof(RowHeader) + sizeof(Span) * spans_.size() + text_.size();
+        // get the chunk the row will be stored in, the chunks are smaller for small limits so that the history does not discard all its rows at once
+        if (chunks_.empty() || chunks_.back().capacity - chunks_.back().size < size || chunks_.back().styles.size() + spans_.size() > MAX_CHUNK_STYLES) {
+            size_t capacity = std::max(std::min(CHUNK_SIZE, limit_ / 8), size);
+            chunks_.emplace_back(capacity, discardedRows_ + rows_);
+            bytes_ += capacity;
+            styleIds_.clear();
+        }
+        Chunk & chunk = chunks_.back();
+        // copy the encoded row to the arena, adjusting the special object indices to those of the chunk and interning the styles
+        uint32_t objectsStart = static_cast<uint32_t>(chunk.objects.size());
+        for (Canvas::SpecialObject * so : objects_)
+            chunk.objects.emplace_back(so);
+        char * x = chunk.data.get() + chunk.size;
+        RowHeader header{static_cast<uint32_t>(cols), static_cast<uint32_t>(spans_.size())};
+        memcpy(x, & header, sizeof(RowHeader));
+        x += sizeof(RowHeader);
+        for (auto & i : spans_) {
+            Span & span = i.first;
+            if (span.object != 0)
+                span.object += objectsStart;
+            auto id = styleIds_.find(i.second);
+            if (id == styleIds_.end()) {
+                id = styleIds_.insert(std::make_pair(i.second, static_cast<uint16_t>(chunk.styles.size()))).first;
+                chunk.styles.push_back(i.second);
+                bytes_ += sizeof(Style);
+            }
+            span.style = id->second;
+            memcpy(x, & span, sizeof(Span));
+            x += sizeof(Span);
+        }
+        memcpy(x, text_.data(), text_.size());
+        chunk.rows.push_back(static_cast<uint32_t>(chunk.size));
+        chunk.size += size;
+        bytes_ += sizeof(uint32_t);
+        ++rows_;
+        trim();
+    }
+
+    std::pair<AnsiTerminal::Cell const *, int> AnsiTerminal::History::row(size_t index) {
+        ASSERT(index < rows_);
+        index += discardedRows_;
+        if (index == cachedRow_)
+            return std::make_pair(cache_.get(), cachedCols_);
+        // find the chunk containing the row
+        auto chunk = std::upper_bound(chunks_.begin(), chunks_.end(), index, [](size_t row, Chunk const & c) {
+            return row < c.firstRow;
+        });
+        ASSERT(chunk != chunks_.begin());
+        --chunk;
+        char const * x = chunk->data.get() + chunk->rows[index - chunk->firstRow];
+        RowHeader header;
+        memcpy(& header, x, sizeof(RowHeader));
+        x += sizeof(RowHeader);
+        char const * text = x + sizeof(Span) * header.spans;
+        // make sure the cache is large enough and decode the cells into it
+        int cols = static_cast<int>(header.cols);
+        if (cacheCapacity_ < cols) {
+            cache_.reset(new Cell[cols]);
+            cacheCapacity_ = cols;
+        }
+        Cell * c = cache_.get();
+        for (uint32_t i = 0; i < header.spans; ++i, x += sizeof(Span)) {
+            Span span;
+            memcpy(& span, x, sizeof(Span));
+            Style const & style = chunk->styles[span.style];
+            Cell cell;
+            cell.setFg(style.fg).setBg(style.bg).setDecor(style.decor).setFont(style.font).setBorder(style.border);
+            if (span.lineEnd)
+                Buffer::MarkAsLineEnd(cell);
+            for (uint32_t j = 0; j < span.cells; ++j, ++c) {
+                *c = cell;
+                c->setCodepoint(DecodeCodepoint(text));
+                if (span.object != 0)
+                    c->attachSpecialObject(chunk->objects[span.object - 1]);
+            }
+        }
+        cachedRow_ = index;
+        cachedCols_ = cols;
+        return std::make_pair(cache_.get(), cols);
+    }
+
+    void AnsiTerminal::History::clear() {
+        discardedRows_ += rows_;
+        rows_ = 0;
+        bytes_ = 0;
+        chunks_.clear();
+    }
+
+    void AnsiTerminal::History::trim() {
+        while (bytes_ > limit_ && ! chunks_.empty()) {
+            Chunk & chunk = chunks_.front();
+            bytes_ -= chunk.capacity + sizeof(uint32_t) * chunk.rows.size() + sizeof(Style) * chunk.styles.size();
+            rows_ -= chunk.rows.size();
+            discardedRows_ += chunk.rows.size();
+            chunks_.pop_front();
+        }
+    }
+
     // ============================================================================================
     // AnsiTerminal::Palette
 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -38,6 +42,7 @@ namespace ui {
         using Cursor = Canvas::Cursor;
         class Buffer;
         class State;
+        class History;
 
         /** Palette
          */
@@ -147,7 +152,9 @@ namespace ui {
     //@}
 
     public:
-        AnsiTerminal(tpp::PTYMaster * pty, Palette && palette);
+        /** Creates the terminal for given pseudoterminal. If the capture is given, the terminal takes its ownership and records all data received from the pseudoterminal into it.
+         */
+        AnsiTerminal(tpp::PTYMaster * pty, Palette && palette, tpp::PTYCapture::Writer * capture = nullptr);
 
         ~AnsiTerminal() override;
 
@@ -203,15 +210,18 @@ namespace ui {
 
     protected:
 
-        Size contentsSize() const override {
-            if (alternateMode_) {
-                return Widget::contentsSize();
-            } else {
-                std::lock_guard<PriorityLock> g(bufferLock_.priorityLock(), std::adopt_lock);
-                return Size{width(), height() + static_cast<int>(historyRows_.size())};
-            }
+        Size contentsSize() const override;
+
+        /** The background is filled by paint() itself, and only when the whole terminal is repainted. 
+         */
+        void paintBackground(Canvas & canvas) override {
+            MARK_AS_UNUSED(canvas);
         }
 
+        /** Paints the terminal. 
+         
+            When painted directly by the renderer at the same position and with the same scroll offset as the last time, only the buffer rows that have changed since are repainted. Otherwise the whole terminal, including its background and the history rows, is repainted. 
+         */
         void paint(Canvas & canvas) override;
 
     //@}
@@ -526,25 +536,15 @@ namespace ui {
          
             Note that to do so, the buffer must be locked as history rows are protected by its mutex so this function is not as cheap as getting a size of a vector. 
          */
-        int historyRows() {
-            std::lock_guard<PriorityLock> g{bufferLock_};
-            return static_cast<int>(historyRows_.size());
-        }
+        int historyRows();
 
-        int maxHistoryRows() const {
-            return maxHistoryRows_;
-        }
+        /** Returns the maximum memory in bytes the history may occupy. 
+         */
+        size_t historyLimit() const;
 
-        void setMaxHistoryRows(int value) {
-            if (value != maxHistoryRows_) {
-                maxHistoryRows_ = std::max(value, 0);
-                std::lock_guard<PriorityLock> g{bufferLock_};
-                while (historyRows_.size() > static_cast<size_t>(maxHistoryRows_)) {
-                    delete [] historyRows_.front().second;
-                    historyRows_.pop_front();
-                }
-            }
-        }
+        /** Sets the maximum memory in bytes the history may occupy. If set to 0, the history is disabled. 
+         */
+        void setHistoryLimit(size_t bytes);
 
     protected:
 
@@ -575,7 +575,11 @@ namespace ui {
             */
         void deleteLines(int lines, int top, int bottom, Cell const & fill);
 
-        void addHistoryRow(Cell * row, int cols);
+        /** Adds given row to the history. 
+         
+            If the row is wider than the terminal, it is split into multiple history rows. 
+         */
+        void addHistoryRow(Cell const * row, int cols);
 
         void ptyTerminated(ExitCode exitCode) override {
             schedule([this, exitCode](){
@@ -594,10 +598,7 @@ namespace ui {
 
         /** Returns the top offset of the terminal buffer in the currently drawed. 
          */
-        int terminalBufferTop() const {
-            ASSERT(bufferLock_.locked());
-            return alternateMode_ ? 0 : static_cast<int>(historyRows_.size());            
-        }
+        int terminalBufferTop() const;
 
         /** Converts the given widget coordinates to terminal buffer coordinates. 
          
@@ -690,8 +691,23 @@ namespace ui {
         State * stateBackup_;
         mutable PriorityLock bufferLock_;
 
-        int maxHistoryRows_ = 0;
-        std::deque<std::pair<int, Cell*>> historyRows_;
+        /** Rows scrolled out of the normal mode buffer. Protected by the buffer lock. 
+         */
+        History * history_;
+
+        /** Visible rectangle, renderer offset and buffer top of the last paint, the changed rows alone can only be repainted if none of them has changed. Protected by the buffer lock. 
+         */
+        Rect lastPaintRect_;
+        Point lastPaintOffset_;
+        int lastPaintTop_ = -1;
+
+        /** Buffer row at which the cursor was painted the last time. The row is repainted with the changed rows so that the cursor is erased if it moves. 
+         */
+        int lastPaintCursorRow_ = -1;
+
+        /** When set, the next paint repaints the whole terminal. Set when the history or the active hyperlink change, or when selection was painted. Protected by the buffer lock. 
+         */
+        bool repaintAll_ = true;
 
     //@}
 
@@ -699,16 +715,55 @@ namespace ui {
      */
     //@{
     protected:
+
+        /** State of the input parser. 
+         
+            See received() for more details. 
+         */
+        enum class ParserState {
+            Ground,
+            UTF8,
+            Escape,
+            Charset,
+            CSI,
+            OSC,
+            DCS,
+            DCSIgnore,
+        }; // AnsiTerminal::ParserState
+
         size_t received(char * buffer, char const * bufferEnd) override;
 
         void parseCodepoint(char32_t cp);
+
+        /** Writes a run of printable ASCII characters (0x20 - 0x7e) to the buffer. 
+         
+            Bulk equivalent of calling parseCodepoint() for each character in the run, which is used when neither the line drawing set, nor an in progress hyperlink are active. 
+         */
+        void parseASCIIRun(char const * begin, char const * end);
         void parseNotification();
         void parseTab();
-        void parseLF();
+        /** Parses the line feed. 
+         
+            If given, the rest of the input is examined for line feeds that can be coalesced into a single scroll. 
+         */
+        void parseLF(char const * next = nullptr, char const * bufferEnd = nullptr);
         void parseCR();
         void parseBackspace();
+
+        /** Executes given C0 control character. 
+         */
+        void parseControlCharacter(char c);
+
+        /** Parses the input while inside an escape sequence. 
+         
+            Returns the number of bytes processed, which is always at least one, unless an incomplete t++ sequence is encountered, in which case 0 is returned and the parser waits for more input. 
+         */
         size_t parseEscapeSequence(char const * buffer, char const * bufferEnd);
 
+        /** Parses the character following the ESC and updates the parser state accordingly. 
+         */
+        void parseEscapeCharacter(char c);
+
         size_t parseTppSequence(char const * buffer, char const * bufferEnd);
 
         /** Called when `t++` sequence is parsed & received by the terminal. 
@@ -755,6 +810,16 @@ namespace ui {
 
         static char32_t LineDrawingChars_[15];
 
+        ParserState parserState_ = ParserState::Ground;
+        /** Character set selector (the intermediate byte) when the character set is being specified. */
+        char charset_ = 0;
+        /** Partially decoded UTF8 character and number of its remaining bytes. */
+        char32_t utf8Codepoint_ = 0;
+        unsigned utf8Remaining_ = 0;
+        /** The CSI and OSC sequences being parsed. */
+        CSISequence csiSequence_;
+        OSCSequence oscSequence_;
+
 
     //@}
 
@@ -771,15 +836,66 @@ namespace ui {
         friend class AnsiTerminal;
     public:
         Buffer(Size const & size, Cell const & defaultCell):
-            ui::Canvas::Buffer(size) {
+            ui::Canvas::Buffer(size),
+            dirty_(size.height(), true) {
             fill(defaultCell);
         }
 
-        void insertLine(int top, int bottom, Cell const & fill);
+        /** \name Changed rows
+         
+            The buffer remembers which rows have changed since the flags were last cleared so that only those have to be repainted. Writes that leave the contents of the cells unchanged do not mark the row, scrolling marks the whole scrolled region. 
+         */
+        //@{
+        bool isDirty(int row) const {
+            ASSERT(row >= 0 && row < height());
+            return dirty_[row];
+        }
+
+        void markDirty(int row) {
+            ASSERT(row >= 0 && row < height());
+            dirty_[row] = true;
+        }
 
-        std::pair<Cell *, int> copyRow(int row, Color defaultBg);
+        void markDirty(int from, int to) {
+            ASSERT(from >= 0 && from <= to && to <= height());
+            std::fill(dirty_.begin() + from, dirty_.begin() + to, true);
+        }
 
-        void deleteLine(int top, int bottom, Cell const & fill);
+        void markAllDirty() {
+            std::fill(dirty_.begin(), dirty_.end(), true);
+        }
+
+        void clearDirty() {
+            std::fill(dirty_.begin(), dirty_.end(), false);
+        }
+        //@}
+
+        /** Fills the entire buffer with given cell. 
+         */
+        void fill(Cell const & fill) {
+            ui::Canvas::Buffer::fill(fill);
+            markAllDirty();
+        }
+
+        /** Fills the given rectangle, clipped to the buffer, with given cell. 
+         
+            Only the rows where a cell actually changes are marked as dirty. 
+         */
+        void fill(Rect const & rect, Cell const & fill);
+
+        /** Inserts given number of lines at the top of the region, scrolling the rest of the region down. 
+         */
+        void insertLines(int lines, int top, int bottom, Cell const & fill);
+
+        /** Returns the cells of given row that should be stored in the history and their number. 
+         
+            If the row is terminated by a line end, only the cells up to and including the line end are returned, unless there are visible characters after it. 
+         */
+        std::pair<Cell const *, int> historyRow(int row, Color defaultBg);
+
+        /** Deletes given number of lines at the top of the region, scrolling the rest of the region up. 
+         */
+        void deleteLines(int lines, int top, int bottom, Cell const & fill);
 
         void markAsLineEnd(Point p) {
             if (p.x() >= 0)
@@ -790,6 +906,10 @@ namespace ui {
             return GetUnusedBits(c) & END_OF_LINE;
         }
 
+        static void MarkAsLineEnd(Cell & c) {
+            SetUnusedBits(c, END_OF_LINE);
+        }
+
         /** Overrides canvas cursor position to disable the check whether the cell has the cursor flag. 
          
             The cursor in terminal is only one and always valid at the coordinates specified in the buffer. 
@@ -807,15 +927,8 @@ namespace ui {
             cursorPosition_ = position;
         }
 
-        /** Fills the entire terminal withe the given cell. 
-         */
-        void fill(Cell const& defaultCell) {
-            for (int i = 0, e = height(); i < e; ++i)
-                fillRow(i, defaultCell, 0, width());
-        }
-        
 
-        void resize(Size size, Cell const & fill, std::function<void(Cell*, int)> addToHistory);
+        void resize(Size size, Cell const & fill, std::function<void(Cell const *, int)> addToHistory);
 
     private:
 
@@ -836,7 +949,7 @@ namespace ui {
 
             TODO can this be used by the terminal cursor positioning, perhaps by making sure it works on more than + 1 offsets outside the valid bounds? And also scroll region and so on...
          */
-        void adjustCursorPosition(Cell const & fill, std::function<void(Cell*, int)> addToHistory);
+        void adjustCursorPosition(Cell const & fill, std::function<void(Cell const *, int)> addToHistory);
         
         /** Returns true if the given line contains only whitespace characters from given column to its width. 
          
@@ -848,10 +961,167 @@ namespace ui {
         /** Flag designating the end of line in the buffer. 
          */
         static constexpr char32_t END_OF_LINE = 0x200000;
+
+        std::vector<bool> dirty_;
     }; // ui::AnsiTerminal::Buffer
 
     // ============================================================================================
 
+    /** Terminal history. 
+     
+        Rows are stored compactly in a chunked arena, each row as run-length encoded spans of cell attributes followed by the UTF8 encoded codepoints of its cells. Rows are appended to the last chunk and when the memory used exceeds the limit, the oldest chunks are discarded with all their rows, so that there are no per-row allocations and deallocations. 
+
+        Rows are decoded to cells when accessed. The last decoded row is cached so that repeated accesses to the same row, such as when searching for word boundaries, are cheap. The returned cells are valid only until next access to the history. 
+     */
+    class AnsiTerminal::History {
+    public:
+
+        explicit History(size_t limit = 0):
+            limit_{limit} {
+        }
+
+        /** Returns the number of rows in the history. 
+         */
+        size_t rows() const {
+            return rows_;
+        }
+
+        /** Returns the memory used by the history in bytes. 
+         */
+        size_t bytes() const {
+            return bytes_;
+        }
+
+        /** Returns the maximum memory in bytes the history may occupy. 
+         */
+        size_t limit() const {
+            return limit_;
+        }
+
+        /** Sets the memory limit, discarding the oldest rows if necessary. 
+         */
+        void setLimit(size_t bytes) {
+            limit_ = bytes;
+            trim();
+        }
+
+        /** Appends given row to the history. 
+         */
+        void addRow(Cell const * cells, int cols);
+
+        /** Returns the cells of given row and their number. 
+         */
+        std::pair<Cell const *, int> row(size_t index);
+
+        /** Removes all rows from the history. 
+         */
+        void clear();
+
+    private:
+
+        /** Visual attributes of the cells. 
+         
+            Styles are interned per chunk so that the spans only store a small index to the chunk's style table. 
+         */
+        class Style {
+        public:
+            Color fg;
+            Color bg;
+            Color decor;
+            Font font;
+            Border border;
+
+            bool operator == (Style const & other) const {
+                return fg == other.fg && bg == other.bg && decor == other.decor && font == other.font && border == other.border;
+            }
+
+            class Hash {
+            public:
+                size_t operator () (Style const & style) const {
+                    size_t result = std::hash<uint64_t>{}((static_cast<uint64_t>(style.fg.toRGBA()) << 32) ^ (static_cast<uint64_t>(style.bg.toRGBA()) << 8) ^ style.decor.toRGBA());
+                    result = result * 31 + std::hash<Font>{}(style.font);
+                    return result * 31 + std::hash<Border>{}(style.border);
+                }
+            }; // AnsiTerminal::History::Style::Hash
+        }; // AnsiTerminal::History::Style
+
+        /** Consecutive cells with the same appearance. 
+         
+            The special object is stored as an index to the objects of the chunk the row belongs to, 0 meaning no special object. The style is index to the chunk's styles. 
+         */
+        class Span {
+        public:
+            uint32_t cells;
+            uint32_t object;
+            uint16_t style;
+            bool lineEnd;
+        }; // AnsiTerminal::History::Span
+
+        /** Header of encoded row. 
+         */
+        class RowHeader {
+        public:
+            uint32_t cols;
+            uint32_t spans;
+        }; // AnsiTerminal::History::RowHeader
+
+        /** Arena chunk. 
+         
+            Contains the encoded rows, their offsets in the data and the special objects their cells were attached to. 
+         */
+        class Chunk {
+        public:
+            Chunk(size_t capacity, size_t firstRow):
+                data{new char[capacity]},
+                capacity{capacity},
+                firstRow{firstRow} {
+            }
+
+            std::unique_ptr<char[]> data;
+            size_t size = 0;
+            size_t capacity;
+            /** Index of the first row in the chunk counted since the history was created. */
+            size_t firstRow;
+            std::vector<uint32_t> rows;
+            std::vector<Canvas::SpecialObject::Ptr<Canvas::SpecialObject>> objects;
+            std::vector<Style> styles;
+        }; // AnsiTerminal::History::Chunk
+
+        /** Discards the oldest chunks while the memory used exceeds the limit. 
+         */
+        void trim();
+
+        size_t limit_;
+        size_t bytes_ = 0;
+        size_t rows_ = 0;
+        /** Number of rows discarded since the history was created. */
+        size_t discardedRows_ = 0;
+        std::deque<Chunk> chunks_;
+
+        /** Spans with their styles, text and special objects of the row being added so that it can be copied to the arena at once. */
+        std::vector<std::pair<Span, Style>> spans_;
+        std::string text_;
+        std::vector<Canvas::SpecialObject *> objects_;
+
+        /** The last decoded row (counted since the history was created) and its cells. */
+        size_t cachedRow_ = std::numeric_limits<size_t>::max();
+        int cachedCols_ = 0;
+        std::unique_ptr<Cell[]> cache_;
+        int cacheCapacity_ = 0;
+
+        /** Indices of the styles of the last chunk. */
+        std::unordered_map<Style, uint16_t, Style::Hash> styleIds_;
+
+        /** Maximum size of an arena chunk. */
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+        /** Maximum number of styles in a chunk so that they can be indexed by the spans. */
+        static constexpr size_t MAX_CHUNK_STYLES = 65536;
+
+    }; // ui::AnsiTerminal::History
+
+    // ============================================================================================
+
     /** Terminal buffer and settings that are specific for each mode (normal vs alternate). 
      */
     class AnsiTerminal::State {
@@ -863,7 +1133,6 @@ namespace ui {
 
         State(Size size, Color defaultBackground):
             buffer{ size, Cell{}.setBg(defaultBackground) },
-            canvas{buffer},
             scrollEnd{size.height()} {
         }
 
@@ -877,12 +1146,11 @@ namespace ui {
             scrollEnd = buffer.height();
             inverseMode = false;
             // clear the buffer
-            canvas.fill(Rect{buffer.size()}, cell);
+            buffer.fill(cell);
         }
 
-        void resize(Size size, std::function<void(Cell*, int)> addToHistory) {
+        void resize(Size size, std::function<void(Cell const *, int)> addToHistory) {
             buffer.resize(size, cell, addToHistory);
-            canvas = Canvas{buffer};
             scrollStart = 0;
             scrollEnd = size.height();
         }
@@ -921,7 +1189,6 @@ namespace ui {
         }
 
         Buffer buffer;
-        Canvas canvas;
         Cell cell;
         int scrollStart{0};
         int scrollEnd;
@@ -940,6 +1207,34 @@ namespace ui {
 
     // ============================================================================================
 
+    inline int AnsiTerminal::historyRows() {
+        std::lock_guard<PriorityLock> g{bufferLock_};
+        return static_cast<int>(history_->rows());
+    }
+
+    inline size_t AnsiTerminal::historyLimit() const {
+        return history_->limit();
+    }
+
+    inline void AnsiTerminal::setHistoryLimit(size_t bytes) {
+        std::lock_guard<PriorityLock> g{bufferLock_};
+        history_->setLimit(bytes);
+    }
+
+    inline int AnsiTerminal::terminalBufferTop() const {
+        ASSERT(bufferLock_.locked());
+        return alternateMode_ ? 0 : static_cast<int>(history_->rows());
+    }
+
+    inline Size AnsiTerminal::contentsSize() const {
+        if (alternateMode_) {
+            return Widget::contentsSize();
+        } else {
+            std::lock_guard<PriorityLock> g(bufferLock_.priorityLock(), std::adopt_lock);
+            return Size{width(), height() + static_cast<int>(history_->rows())};
+        }
+    }
+
     inline Point AnsiTerminal::cursorPosition() const {
         return state_->buffer.cursorPosition();
     }
@@ -5,61 +5,88 @@
 
 namespace ui {
 
+    bool CSISequence::parse(char const * & buffer, char const * end) {
+        ASSERT(state_ != State::Complete);
+        char const * x = buffer;
+        while (x != end) {
+            char c = *x;
+            // C0 control characters are executed by the caller without terminating the sequence
+            if (c >= 0 && c < 0x20)
+                break;
+            switch (state_) {
+                // parse the first byte, if it is not a digit or separator
+                case State::FirstByte:
+                    state_ = State::Parameters;
+                    if (IsParameterByte(c) && c != ';' && !IsDecimalDigit(c)) {
+                        firstByte_ = c;
+                        ++x;
+                    }
+                    continue;
+                case State::Parameters:
+                    // if we see digit, parse the argument given
+                    if (IsDecimalDigit(c)) {
+                        if (! argInProgress_) {
+                            addArgument(0, true);
+                            argInProgress_ = true;
+                        }
+                        int & arg = args_[numArgs_ - 1].first;
+                        arg = std::min(arg * 10 + static_cast<int>(DecCharToNumber(c)), MAX_ARG_VALUE);
+                        ++x;
+                        continue;
+                    }
+                    // semicolon separates arguments, if there were no digits before it, it is an empty argument, which is initialized to default value (0)
+                    if (c == ';') {
+                        if (! argInProgress_)
+                            addArgument(DEFAULT_ARG_VALUE, false);
+                        argInProgress_ = false;
+                        ++x;
+                        continue;
+                    }
+                    // other than numeric values are not supported for now
+                    if (IsParameterByte(c)) {
+                        firstByte_ = INVALID;
+                        ++x;
+                        continue;
+                    }
+                    state_ = State::Intermediate;
+                    [[fallthrough]];
+                // parse intermediate bytes, if there are any, the sequence is marked as invalid because these are not supported now
+                case State::Intermediate:
+                    if (IsIntermediateByte(c)) {
+                        firstByte_ = INVALID;
+                        ++x;
+                        continue;
+                    }
+                    state_ = State::Complete;
+                    // parse the final byte, anything else is invalid and terminates the sequence without being consumed
+                    if (IsFinalByte(c))
+                        finalByte_ = *x++;
+                    else
+                        firstByte_ = INVALID;
+                    buffer = x;
+                    return true;
+                default:
+                    UNREACHABLE;
+            }
+        }
+        buffer = x;
+        return false;
+    }
+
     CSISequence CSISequence::Parse(char const * & start, char const * end) {
         CSISequence result;
         char const * x = start + 2; // skip the leading '\033['
-        // if we are at the end, return incomplete
-        if (x >= end) {
-            result.firstByte_ = INCOMPLETE;
-            return result;
-        }
-        // parse the first byte
-        if (IsParameterByte(*x) && *x != ';' && !IsDecimalDigit(*x))
-            result.firstByte_ = *x++;
-        ASSERT(result.firstByte_ != INVALID);
-        // parse arguments, if any
-        while (x != end && IsParameterByte(*x)) {
-            // semicolon separates arguments, in this case an empty argument, which is initialized to default value (0)
-            if (*x == ';') {
-                ++x;
-                result.args_.push_back(std::make_pair(DEFAULT_ARG_VALUE, false));
-            // otherwise if we see digit, parse the argument given
-            } else if (IsDecimalDigit(*x)) {
-                int arg = 0;
-                do {
-                    arg = arg * 10 + DecCharToNumber(*x++);
-                } while (x != end && IsDecimalDigit(*x));
-                result.args_.push_back(std::make_pair(arg, true));
-                // if there is separator, parse it as well
-                if (x != end && *x == ';')
-                    ++x;
-            // other than numeric values are not supported for now
-            } else {
-                ++x;
-                result.firstByte_ = INVALID;
+        // the sequence is parsed until it is complete, invalid control characters in it are skipped
+        while (! result.parse(x, end)) {
+            if (x == end) {
+                result.clear();
+                return result;
             }
+            ++x;
         }
-        // parse intermediate bytes, if there are any, the sequence is marked as invalid because these are not supported now
-		while (x != end && IsIntermediateByte(*x)) {
-			result.firstByte_ = INVALID;
-			++x;
-		}
-		// parse final byte, first check we are not at the end
-		if (x == end) {
-            result.firstByte_ = INCOMPLETE;
-            return result;
-        }
-		if (IsFinalByte(*x))
-			result.finalByte_ = *x++;
-		else
-			result.firstByte_ = INVALID;
-        // log the sequence if invalid
-        // TODO
-        //if (! result.valid())
-			//LOG(SEQ_UNKNOWN) << "Unknown, possibly invalid CSI sequence: \x1b" << std::string(start - 1 , x - start + 1);
         start = x;
         return result;
     }
 
 
-} // namespace ui
\ No newline at end of file
+} // namespace ui
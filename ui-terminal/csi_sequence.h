@@ -1,16 +1,25 @@
-#pragma once 
+#pragma once
 
-#include <vector>
 #include <ostream>
+#include <utility>
 
 namespace ui {
 
+    /** The CSI sequence.
+
+        The sequence is parsed incrementally, i.e. the parse() method can be called multiple times with consecutive parts of the input and the parsing state is kept in the sequence itself, so that each input byte is processed exactly once even if the sequence is split across multiple reads.
+
+        The arguments are stored inline in a fixed capacity array so that parsing the sequences does not touch the heap. Sequences with more than MAX_ARGS arguments are invalid.
+     */
     class CSISequence {
     public:
 
         CSISequence():
             firstByte_{0},
-            finalByte_{0} {
+            finalByte_{0},
+            state_{State::FirstByte},
+            argInProgress_{false},
+            numArgs_{0} {
         }
 
         bool valid() const {
@@ -18,7 +27,7 @@ namespace ui {
         }
 
         bool complete() const {
-            return firstByte_ != INCOMPLETE;
+            return state_ == State::Complete;
         }
 
         char firstByte() const {
@@ -30,18 +39,19 @@ namespace ui {
         }
 
         size_t numArgs() const {
-            return args_.size();
+            return numArgs_;
         }
 
         int operator [] (size_t index) const {
-            if (index >= args_.size())
+            if (index >= numArgs_)
                 return 0; // the default value for argument if not given
             return args_[index].first;
         }
 
         CSISequence & setDefault(size_t index, int value) {
-            while (args_.size() <= index)
-                args_.push_back(std::make_pair(0, false));
+            ASSERT(index < MAX_ARGS);
+            while (numArgs_ <= index)
+                args_[numArgs_++] = std::make_pair(0, false);
             std::pair<int, bool> & arg = args_[index];
             // because we set default args after parsing, we only change default value if it was not supplied
             if (!arg.second)
@@ -49,12 +59,12 @@ namespace ui {
             return *this;
         }
 
-        /** If the given argument has the specified value, it is replaced with the new value given. 
+        /** If the given argument has the specified value, it is replaced with the new value given.
 
-            Returns true if the replace occured, false otherwise. 
+            Returns true if the replace occured, false otherwise.
             */
         bool conditionalReplace(size_t index, int value, int newValue) {
-            if (index >= args_.size())
+            if (index >= numArgs_)
                 return false;
             if (args_[index].first != value)
                 return false;
@@ -62,20 +72,65 @@ namespace ui {
             return true;
         }
 
-        /** Parses the CSI sequence from given input. 
+        /** Resets the sequence so that a new sequence can be parsed.
+         */
+        void clear() {
+            firstByte_ = 0;
+            finalByte_ = 0;
+            state_ = State::FirstByte;
+            argInProgress_ = false;
+            numArgs_ = 0;
+        }
+
+        /** Continues parsing the sequence from given input.
+
+            The input must start *after* the CSI introducer (`ESC [`), or where the previous call to parse() stopped. Returns true when the sequence has been terminated, in which case the sequence is complete, but may be invalid. Otherwise returns false and the buffer is either fully consumed, or points to a C0 control character, which per ECMA-48 must be executed by the caller before the parsing can continue.
+         */
+        bool parse(char const * & buffer, char const * end);
+
+        /** Parses the CSI sequence from given input.
 
+            Unlike parse(), the input must start with the CSI introducer and the sequence must be contained in it in its entirety. If the input ends before the sequence, returns an incomplete sequence and does not advance the buffer.
          */
         static CSISequence Parse(char const * & buffer, char const * end);
 
+        /** Maximum number of arguments a sequence may have. 
+         */
+        static constexpr size_t MAX_ARGS = 32;
+
     private:
 
+        /** Parsing state of the sequence.
+         */
+        enum class State : char {
+            FirstByte,
+            Parameters,
+            Intermediate,
+            Complete,
+        }; // CSISequence::State
+
         char firstByte_;
         char finalByte_;
-        std::vector<std::pair<int, bool>> args_;
+        State state_;
+        /** True if there are digits of the last argument being parsed. */
+        bool argInProgress_;
+        size_t numArgs_;
+        std::pair<int, bool> args_[MAX_ARGS];
 
         static constexpr char INVALID = -1;
-        static constexpr char INCOMPLETE = -2;
         static constexpr int DEFAULT_ARG_VALUE = 0;
+        /** Upper limit on argument values so that overly long digit sequences do not overflow. */
+        static constexpr int MAX_ARG_VALUE = 65535;
+
+        /** Adds new argument to the sequence. If there are too many arguments, the last one is overwritten and the sequence is marked as invalid. 
+         */
+        void addArgument(int value, bool specified) {
+            if (numArgs_ == MAX_ARGS) {
+                firstByte_ = INVALID;
+                --numArgs_;
+            }
+            args_[numArgs_++] = std::make_pair(value, specified);
+        }
 
         static bool IsParameterByte(char c) {
             return (c >= 0x30) && (c <= 0x3f);
@@ -97,10 +152,10 @@ namespace ui {
                 s << "Incomplete CSI Sequence";
             } else {
                 s << "\x1b[";
-                if (seq.firstByte_ != 0) 
+                if (seq.firstByte_ != 0)
                     s << seq.firstByte_;
-                if (!seq.args_.empty()) {
-                    for (size_t i = 0, e = seq.args_.size(); i != e; ++i) {
+                if (seq.numArgs_ != 0) {
+                    for (size_t i = 0, e = seq.numArgs_; i != e; ++i) {
                         if (seq.args_[i].second)
                             s << seq.args_[i].first;
                         if (i != e - 1)
@@ -115,4 +170,4 @@ namespace ui {
     }; // ui::CISSequence
 
 
-} // namespace ui
\ No newline at end of file
+} // namespace ui
@@ -4,59 +4,73 @@
 
 namespace ui {
 
-    OSCSequence OSCSequence::Parse(char const * & start, char const * end) {
-        OSCSequence result;
-        char const * x = start + 2; // skip the leading '\033]'
-        if (x == end) {
-            result.num_ = INCOMPLETE;
-            return result;
-        }
-        // parse the number
-        if (IsDecimalDigit(*x)) {
-            int arg = 0;
-            do {
-                arg = arg * 10 + DecCharToNumber(*x++);
-            } while (x != end && IsDecimalDigit(*x));
-            // if there is no semicolon, keep the INVALID in the number, but continue parsing to BEL or ST
-            if (x != end && *x == ';') {
-                    ++x;
-                    result.num_ = arg;
-            } 
-        }
-        // parse the value, which is terminated by either BEL, or ST, which is ESC followed by backslash
-        char const * valueStart = x;
-        while (true) {
+    bool OSCSequence::parse(char const * & buffer, char const * end) {
+        ASSERT(state_ != State::Complete);
+        char const * x = buffer;
+        // parse the number, if there is no semicolon after the number, the sequence is invalid, but the parsing continues to BEL or ST
+        while (state_ == State::Number) {
             if (x == end) {
-                result.num_ = INCOMPLETE;
-                return result;
+                buffer = x;
+                return false;
             }
-            // BEL
-            if (*x == Char::BEL) {
-                result.values_.push_back(std::string(valueStart, x - valueStart));
+            if (IsDecimalDigit(*x)) {
+                num_ = std::min((num_ == INVALID ? 0 : num_ * 10) + static_cast<int>(DecCharToNumber(*x)), MAX_NUM);
                 ++x;
-                break;
+                continue;
             }
-            // ST
-            if (*x == Char::ESC && x + 1 != end && x[1] == '\\') {
-                result.values_.push_back(std::string(valueStart, x - valueStart));
-                x += 2;
-                break;
-            }
-            switch (*x) {
-                // TODO should we do escape for the semicolon? 
-                // semicolon
-                case ';': {
-                    result.values_.push_back(std::string(valueStart, x - valueStart));
-                    ++x;
-                    valueStart = x;
+            if (*x == ';')
+                ++x;
+            else
+                num_ = INVALID;
+            state_ = State::Value;
+        }
+        // parse the values, which are terminated by either BEL, or ST, which is ESC followed by backslash, the offsets are relative to the beginning of the payload, parts of which may have been parsed already
+        char const * payloadStart = x;
+        while (x != end) {
+            char c = *x++;
+            // escape followed by backslash is ST, otherwise the escape character is part of the value
+            if (state_ == State::Escape) {
+                if (c == '\\') {
+                    endValue(size_ + (x - payloadStart) - 2);
+                    state_ = State::Complete;
                     break;
                 }
+                state_ = State::Value;
+            }
+            switch (c) {
+                case Char::BEL:
+                    endValue(size_ + (x - payloadStart) - 1);
+                    state_ = State::Complete;
+                    break;
+                case Char::ESC:
+                    state_ = State::Escape;
+                    break;
+                // TODO should we do escape for the semicolon?
+                case ';':
+                    endValue(size_ + (x - payloadStart) - 1);
+                    break;
                 default:
-                    ++x;
+                    break;
             }
+            if (state_ == State::Complete)
+                break;
+        }
+        buffer = x;
+        // if there is no previously stored payload and the sequence is complete, the payload is in the input buffer
+        if (size_ == 0 && state_ == State::Complete) {
+            payload_ = payloadStart;
+            return true;
         }
-        start = x;
-        return result;
+        // otherwise store the payload parsed so far
+        size_ += (x - payloadStart);
+        if (size_ > MAX_SIZE)
+            num_ = INVALID;
+        else
+            storage_.append(payloadStart, x);
+        if (state_ != State::Complete)
+            return false;
+        payload_ = storage_.data();
+        return true;
     }
 
-}
\ No newline at end of file
+} // namespace ui
@@ -1,13 +1,23 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 namespace ui {
 
+    /** The OSC sequence.
+
+        Like the CSI sequence, the OSC sequence is parsed incrementally so that the sequence can be split across multiple reads without the need to parse its beginning again.
+
+        The values of the sequence are non-owning views. If the whole sequence was parsed from a single input, the views point directly to the input buffer. Otherwise the parts of the sequence from previous inputs are accumulated in an internal storage, which keeps its capacity between the sequences, and the views point there. Either way, the values are only valid until the input buffer is modified, or another sequence is parsed.
+
+        At most MAX_VALUES values are supported, sequences with more values are invalid.
+     */
     class OSCSequence {
     public:
         OSCSequence():
-            num_{INVALID} {
+            num_{INVALID},
+            state_{State::Number} {
         }
 
         int num() const {
@@ -15,12 +25,13 @@ namespace ui {
         }
 
         size_t numArgs() const {
-            return values_.size();
+            return numValues_;
         }
 
-        std::string const & operator [] (size_t index) const {
-            ASSERT(index < values_.size());
-            return values_[index];
+        std::string_view operator [] (size_t index) const {
+            ASSERT(index < numValues_ && complete());
+            size_t start = index == 0 ? 0 : valueEnds_[index - 1] + 1;
+            return std::string_view{payload_ + start, valueEnds_[index] - start};
         }
 
         bool valid() const {
@@ -28,20 +39,67 @@ namespace ui {
         }
 
         bool complete() const {
-            return num_ != INCOMPLETE;
+            return state_ == State::Complete;
         }
 
-        /** Parses the OSC sequence from given input. 
+        /** Resets the sequence so that a new sequence can be parsed.
+         */
+        void clear() {
+            num_ = INVALID;
+            state_ = State::Number;
+            size_ = 0;
+            numValues_ = 0;
+            payload_ = nullptr;
+            storage_.clear();
+        }
+
+        /** Continues parsing the sequence from given input.
+
+            The input must start *after* the OSC introducer (`ESC ]`), or where the previous call to parse() stopped. Returns true if the sequence has been terminated by either BEL, or ST, otherwise the whole input is consumed and false is returned.
          */
-        static OSCSequence Parse(char const * & buffer, char const * end);
+        bool parse(char const * & buffer, char const * end);
+
+        /** Maximum number of values a sequence may have.
+         */
+        static constexpr size_t MAX_VALUES = 16;
 
     private:
 
+        /** Parsing state of the sequence.
+         */
+        enum class State : char {
+            Number,
+            Value,
+            Escape,
+            Complete,
+        }; // OSCSequence::State
+
+        /** Terminates the current value at given offset.
+         */
+        void endValue(size_t offset) {
+            if (numValues_ == MAX_VALUES)
+                num_ = INVALID;
+            else
+                valueEnds_[numValues_++] = offset;
+        }
+
         int num_;
-        std::vector<std::string> values_;
+        State state_;
+        /** Size of the payload (the values and their separators) parsed so far. */
+        size_t size_ = 0;
+        /** Number of values and offsets of their ends in the payload. */
+        size_t numValues_ = 0;
+        size_t valueEnds_[MAX_VALUES];
+        /** Payload of complete sequence, either in the input buffer, or the storage. */
+        char const * payload_ = nullptr;
+        /** Parts of the payload from previous inputs. */
+        std::string storage_;
 
         static constexpr int INVALID = -1;
-        static constexpr int INCOMPLETE = -2;
+        static constexpr int MAX_NUM = 65535;
+        /** Maximum size of the sequence's payload. Larger sequences are parsed till their end, but marked invalid.
+         */
+        static constexpr size_t MAX_SIZE = 1024 * 1024;
 
         friend std::ostream & operator << (std::ostream & s, OSCSequence const & seq) {
             if (!seq.valid()) {
@@ -50,8 +108,8 @@ namespace ui {
                 s << "Incomplete OSC Sequence";
             } else {
                 s << "\x1b]" << seq.num();
-                for (auto & arg : seq.values_)
-                    s << ';' << arg;
+                for (size_t i = 0; i < seq.numValues_; ++i)
+                    s << ';' << seq[i];
             }
             return s;
         }
@@ -59,4 +117,4 @@ namespace ui {
     }; // ui::OSCSequence
 
 
-} // namespace ui
\ No newline at end of file
+} // namespace ui
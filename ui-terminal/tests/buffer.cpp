@@ -0,0 +1,199 @@
+#include "helpers/tests.h"
+
+#include "ui/tests/test_special_object.h"
+
+#include "../ansi_terminal.h"
+
+using namespace ui;
+
+namespace {
+
+    /** Returns the contents of the buffer row as a string, with the line end cells followed by '|'.
+     */
+    std::string RowText(AnsiTerminal::Buffer const & buffer, int row) {
+        std::string result;
+        for (int col = 0; col < buffer.width(); ++col) {
+            AnsiTerminal::Cell const & c = buffer.at(Point{col, row});
+            result.push_back(static_cast<char>(c.codepoint()));
+            if (AnsiTerminal::Buffer::IsLineEnd(c))
+                result.push_back('|');
+        }
+        return result;
+    }
+
+    /** Fills each row of the buffer with its letter, starting at given one, and marks the line end after the first three cells.
+     */
+    void FillRows(AnsiTerminal::Buffer & buffer, char first) {
+        AnsiTerminal::Cell x;
+        for (int row = 0; row < buffer.height(); ++row) {
+            x.setCodepoint(static_cast<char32_t>(first + row));
+            buffer.fill(Rect{Point{0, row}, Size{3, 1}}, x);
+            buffer.markAsLineEnd(Point{2, row});
+        }
+    }
+
+}
+
+TEST(terminal_buffer, dirtyRows) {
+    AnsiTerminal::Cell blank;
+    blank.setBg(Color::Black);
+    AnsiTerminal::Buffer buffer{Size{10, 4}, blank};
+    for (int i = 0; i < 4; ++i)
+        EXPECT(buffer.isDirty(i));
+    buffer.clearDirty();
+    // rewriting identical contents does not mark the row
+    buffer.fill(Rect{Point{0, 1}, Size{10, 1}}, blank);
+    EXPECT(! buffer.isDirty(1));
+    AnsiTerminal::Cell x{blank};
+    x.setCodepoint('x');
+    buffer.fill(Rect{Point{2, 1}, Size{3, 2}}, x);
+    EXPECT(! buffer.isDirty(0));
+    EXPECT(buffer.isDirty(1));
+    EXPECT(buffer.isDirty(2));
+    EXPECT(! buffer.isDirty(3));
+    EXPECT(buffer.at(Point{4, 2}).codepoint() == 'x');
+    // scrolling marks the whole region
+    buffer.clearDirty();
+    buffer.deleteLines(1, 2, 4, blank);
+    EXPECT(! buffer.isDirty(0));
+    EXPECT(! buffer.isDirty(1));
+    EXPECT(buffer.isDirty(2));
+    EXPECT(buffer.isDirty(3));
+}
+
+TEST(terminal_buffer, rotateRows) {
+    AnsiTerminal::Cell blank;
+    AnsiTerminal::Buffer buffer{Size{5, 4}, blank};
+    FillRows(buffer, 'a');
+    // full screen scrolls rotate the rows, including past the end of the row pointers
+    buffer.deleteLines(1, 0, 4, blank);
+    EXPECT_EQ(RowText(buffer, 0), "bbb|  ");
+    EXPECT_EQ(RowText(buffer, 2), "ddd|  ");
+    EXPECT_EQ(RowText(buffer, 3), "     ");
+    buffer.deleteLines(3, 0, 4, blank);
+    EXPECT_EQ(RowText(buffer, 0), "     ");
+    FillRows(buffer, 'e');
+    buffer.insertLines(2, 0, 4, blank);
+    EXPECT_EQ(RowText(buffer, 0), "     ");
+    EXPECT_EQ(RowText(buffer, 1), "     ");
+    EXPECT_EQ(RowText(buffer, 2), "eee|  ");
+    EXPECT_EQ(RowText(buffer, 3), "fff|  ");
+    buffer.deleteLines(1, 0, 4, blank);
+    FillRows(buffer, 'i');
+    // partial regions reorder the rows while the rows are rotated
+    buffer.deleteLines(1, 1, 3, blank);
+    EXPECT_EQ(RowText(buffer, 0), "iii|  ");
+    EXPECT_EQ(RowText(buffer, 1), "kkk|  ");
+    EXPECT_EQ(RowText(buffer, 2), "     ");
+    EXPECT_EQ(RowText(buffer, 3), "lll|  ");
+    buffer.insertLines(2, 1, 4, blank);
+    EXPECT_EQ(RowText(buffer, 0), "iii|  ");
+    EXPECT_EQ(RowText(buffer, 1), "     ");
+    EXPECT_EQ(RowText(buffer, 2), "     ");
+    EXPECT_EQ(RowText(buffer, 3), "kkk|  ");
+    // full screen scroll after the reordering uses the updated mirrored rows
+    buffer.deleteLines(3, 0, 4, blank);
+    EXPECT_EQ(RowText(buffer, 0), "kkk|  ");
+    buffer.insertLines(3, 0, 4, blank);
+    EXPECT_EQ(RowText(buffer, 3), "kkk|  ");
+    // all rows are distinct
+    buffer.fill(blank);
+    AnsiTerminal::Cell x;
+    x.setCodepoint('x');
+    buffer.fill(Rect{Point{0, 1}, Size{5, 1}}, x);
+    for (int row = 0; row < 4; ++row)
+        EXPECT_EQ(RowText(buffer, row), row == 1 ? "xxxxx" : "     ");
+}
+
+TEST(terminal_buffer, resizeRotatedRows) {
+    AnsiTerminal::Cell blank;
+    AnsiTerminal::Buffer buffer{Size{5, 4}, blank};
+    buffer.deleteLines(3, 0, 4, blank);
+    buffer.deleteLines(1, 1, 4, blank);
+    FillRows(buffer, 'a');
+    buffer.setCursorPosition(Point{0, 3});
+    std::vector<std::string> history;
+    auto addToHistory = [&](AnsiTerminal::Cell const * cells, int cols) {
+        std::string row;
+        for (int i = 0; i < cols; ++i)
+            row.push_back(static_cast<char>(cells[i].codepoint()));
+        history.push_back(row);
+    };
+    // the rows above the cursor are copied in order, each ending at its line end
+    buffer.resize(Size{8, 5}, blank, addToHistory);
+    EXPECT_EQ(RowText(buffer, 0), "aaa|     ");
+    EXPECT_EQ(RowText(buffer, 1), "bbb|     ");
+    EXPECT_EQ(RowText(buffer, 2), "ccc|     ");
+    EXPECT_EQ(RowText(buffer, 3), "        ");
+    EXPECT_EQ(buffer.cursorPosition(), Point(0, 3));
+    EXPECT(history.empty());
+    // narrower buffer wraps the rows and scrolls the top ones to the history
+    buffer.deleteLines(1, 0, 5, blank);
+    buffer.setCursorPosition(Point{0, 2});
+    buffer.resize(Size{2, 3}, blank, addToHistory);
+    EXPECT_EQ(history.size(), 2);
+    EXPECT_EQ(history[0], "bb");
+    EXPECT_EQ(history[1], "b ");
+    EXPECT_EQ(RowText(buffer, 0), "cc");
+    EXPECT_EQ(RowText(buffer, 1), "c| ");
+    EXPECT_EQ(RowText(buffer, 2), "  ");
+}
+
+TEST(terminal_buffer, specialObjectsRotateAndResize) {
+    bool deletedA = false;
+    bool deletedB = false;
+    bool deletedC = false;
+    TestSpecialObject * a = new TestSpecialObject{deletedA};
+    TestSpecialObject * b = new TestSpecialObject{deletedB};
+    TestSpecialObject * c = new TestSpecialObject{deletedC};
+    AnsiTerminal::Cell blank;
+    AnsiTerminal::Buffer buffer{Size{5, 4}, blank};
+    AnsiTerminal::Buffer const & view = buffer;
+    buffer.attachSpecialObject(Point{1, 1}, a);
+    buffer.attachSpecialObject(Point{0, 0}, b);
+    buffer.attachSpecialObject(Point{0, 3}, c);
+    EXPECT(buffer.hasSpecialObjects(0));
+    EXPECT(! buffer.hasSpecialObjects(2));
+    // the rotated rows keep their objects and flags, the row scrolled out releases its objects and is cleared
+    buffer.deleteLines(1, 0, 4, blank);
+    EXPECT(deletedB);
+    EXPECT(view.at(Point{1, 0}).specialObject() == a);
+    EXPECT(view.at(Point{0, 2}).specialObject() == c);
+    EXPECT(! view.at(Point{0, 3}).hasSpecialObject());
+    EXPECT(buffer.hasSpecialObjects(0));
+    EXPECT(! buffer.hasSpecialObjects(1));
+    EXPECT(buffer.hasSpecialObjects(2));
+    EXPECT(! buffer.hasSpecialObjects(3));
+    buffer.deleteLines(1, 1, 3, blank);
+    EXPECT(view.at(Point{0, 1}).specialObject() == c);
+    EXPECT(! view.at(Point{0, 2}).hasSpecialObject());
+    EXPECT(buffer.hasSpecialObjects(1));
+    EXPECT(! buffer.hasSpecialObjects(2));
+    buffer.insertLines(2, 0, 4, blank);
+    EXPECT(view.at(Point{1, 2}).specialObject() == a);
+    EXPECT(view.at(Point{0, 3}).specialObject() == c);
+    EXPECT(! buffer.hasSpecialObjects(0));
+    EXPECT(! buffer.hasSpecialObjects(1));
+    EXPECT(buffer.hasSpecialObjects(2));
+    EXPECT(buffer.hasSpecialObjects(3));
+    for (int row = 0; row < 2; ++row)
+        for (int col = 0; col < 5; ++col)
+            EXPECT(! view.at(Point{col, row}).hasSpecialObject());
+    EXPECT(! deletedA);
+    EXPECT(! deletedC);
+    // resize copies the rows above the cursor with their objects, the rest are released with the old buffer
+    for (int row = 0; row < 4; ++row)
+        buffer.markAsLineEnd(Point{4, row});
+    buffer.setCursorPosition(Point{0, 3});
+    buffer.resize(Size{8, 5}, blank, nullptr);
+    EXPECT(deletedC);
+    EXPECT(! deletedA);
+    EXPECT(view.at(Point{1, 2}).specialObject() == a);
+    EXPECT(buffer.hasSpecialObjects(2));
+    EXPECT(! buffer.hasSpecialObjects(3));
+    buffer.deleteLines(3, 0, 5, blank);
+    EXPECT(deletedA);
+    for (int row = 0; row < 5; ++row)
+        for (int col = 0; col < 8; ++col)
+            EXPECT(! view.at(Point{col, row}).hasSpecialObject());
+}
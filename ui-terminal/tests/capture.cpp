@@ -0,0 +1,25 @@
+#include <cstdio>
+#include <thread>
+
+#include "helpers/filesystem.h"
+
+#include "test_terminal.h"
+
+using namespace ui;
+
+TEST(terminal_capture, recordsOutputReceivedBeforeCreation) {
+    std::string filename = UniqueNameIn(TempDir(), "tpp-capture-");
+    // the output is available in the pseudoterminal before the terminal and its reader exist
+    tpp::NullPTYMaster * pty = new tpp::NullPTYMaster{"motd\r\nprompt$ "};
+    {
+        AnsiTerminal terminal{pty, AnsiTerminal::Palette::XTerm256(), new tpp::PTYCapture::Writer{filename}};
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (terminal.receivedBytes() < 14 && std::chrono::steady_clock::now() < end)
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        EXPECT_EQ(terminal.receivedBytes(), 14);
+    }
+    std::vector<tpp::PTYCapture::Chunk> loaded = tpp::PTYCapture::Load(filename);
+    CHECK_EQ(loaded.size(), 1);
+    EXPECT_EQ(loaded[0].data, "motd\r\nprompt$ ");
+    std::remove(filename.c_str());
+}
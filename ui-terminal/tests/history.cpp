@@ -0,0 +1,60 @@
+#include "helpers/tests.h"
+
+#include "../ansi_terminal.h"
+
+using namespace ui;
+
+TEST(terminal_history, roundtrip) {
+    AnsiTerminal::History history{1024 * 1024};
+    AnsiTerminal::Cell cells[4];
+    cells[0].setCodepoint('a');
+    cells[1].setCodepoint(0x1f600).setFg(Color::Red);
+    cells[2].setCodepoint(0x10ffff).setFg(Color::Red).setFont(Font{}.setUnderline());
+    AnsiTerminal::Buffer::MarkAsLineEnd(cells[3]);
+    history.addRow(cells, 4);
+    history.addRow(cells, 0);
+    EXPECT_EQ(history.rows(), 2);
+    auto row = history.row(0);
+    EXPECT_EQ(row.second, 4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT(row.first[i].codepoint() == cells[i].codepoint());
+        EXPECT(row.first[i].fg() == cells[i].fg());
+        EXPECT(row.first[i].font() == cells[i].font());
+        EXPECT(AnsiTerminal::Buffer::IsLineEnd(row.first[i]) == (i == 3));
+    }
+    EXPECT_EQ(history.row(1).second, 0);
+}
+
+TEST(terminal_history, limit) {
+    AnsiTerminal::History history{64 * 1024};
+    AnsiTerminal::Cell cells[80];
+    for (int i = 0; i < 10000; ++i) {
+        cells[0].setCodepoint('0' + (i % 10));
+        history.addRow(cells, 80);
+        EXPECT(history.bytes() <= history.limit());
+    }
+    // the oldest rows are discarded, the most recent ones are kept
+    EXPECT(history.rows() > 0 && history.rows() < 10000);
+    EXPECT(history.row(history.rows() - 1).first[0].codepoint() == '9');
+    EXPECT(history.row(history.rows() - 2).first[0].codepoint() == '8');
+    history.setLimit(0);
+    EXPECT_EQ(history.rows(), 0);
+    EXPECT_EQ(history.bytes(), 0);
+}
+
+TEST(terminal_history, styles) {
+    AnsiTerminal::History history{1024 * 1024};
+    AnsiTerminal::Cell cells[3];
+    for (int i = 0; i < 1000; ++i) {
+        cells[0].setFg(Color{static_cast<unsigned char>(i), 0, 0});
+        cells[1].setBg(Color{0, static_cast<unsigned char>(i % 7), 0});
+        cells[2].setBorder(Border{}.setColor(Color::Red).setTop(i % 2 ? Border::Kind::Thin : Border::Kind::Thick));
+        history.addRow(cells, 3);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        auto row = history.row(i);
+        EXPECT(row.first[0].fg() == (Color{static_cast<unsigned char>(i), 0, 0}));
+        EXPECT(row.first[1].bg() == (Color{0, static_cast<unsigned char>(i % 7), 0}));
+        EXPECT(row.first[2].border() == Border{}.setColor(Color::Red).setTop(i % 2 ? Border::Kind::Thin : Border::Kind::Thick));
+    }
+}
@@ -0,0 +1,127 @@
+#include "helpers/tests.h"
+
+#include "test_terminal.h"
+
+using namespace ui;
+
+namespace {
+
+    /** Encodes the printable ASCII characters of the input as overlong two byte UTF8 sequences.
+
+        The decoder does not reject overlong encodings, so the terminal receives the same codepoints, but processes each of them with parseCodepoint() instead of the printable ASCII run fast path. The input must not contain escape sequences.
+     */
+    std::string Overlong(std::string const & input) {
+        std::string result;
+        for (char c : input) {
+            if (c >= 0x20 && c < 0x7f) {
+                result.push_back(static_cast<char>(0xc0 | (c >> 6)));
+                result.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            } else {
+                result.push_back(c);
+            }
+        }
+        return result;
+    }
+
+    /** Returns the first difference between the input processed by the printable ASCII fast path in chunks of various sizes and the input processed character by character, or an empty string if there is none.
+     */
+    std::string ASCIIRunDifference(std::string const & input, int cols, int rows, bool detectHyperlinks = false) {
+        TestTerminal expected{cols, rows, detectHyperlinks};
+        expected.feed(Overlong(input));
+        for (size_t chunkSize : { std::string::npos, static_cast<size_t>(1), static_cast<size_t>(7), static_cast<size_t>(16), static_cast<size_t>(33) }) {
+            TestTerminal t{cols, rows, detectHyperlinks};
+            t.feed(input, chunkSize);
+            std::string difference = t.differenceFrom(expected);
+            if (! difference.empty())
+                return STR("chunk size " << chunkSize << ": " << difference);
+        }
+        return std::string{};
+    }
+
+}
+
+TEST(terminal_input, asciiRunWrapsAtLastColumn) {
+    // exactly filling a row does not wrap until the next character is written
+    EXPECT_EQ(ASCIIRunDifference("0123456789", 10, 4), "");
+    EXPECT_EQ(ASCIIRunDifference("0123456789x", 10, 4), "");
+    EXPECT_EQ(ASCIIRunDifference("0123456789\r\nabcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ", 10, 4), "");
+    EXPECT_EQ(ASCIIRunDifference("first line that is longer than the buffer is wide and scrolls into the history", 16, 3), "");
+}
+
+TEST(terminal_input, asciiRunLineEnds) {
+    // the line ends and dirty rows are identical, including the rows that were only partially rewritten
+    EXPECT_EQ(ASCIIRunDifference("abc\r\nde\r\n\r\nfghijklmnopq\r\nr", 8, 6), "");
+    EXPECT_EQ(ASCIIRunDifference("12345678\r\n1234567\r\n123456789\r\n", 8, 3), "");
+}
+
+TEST(terminal_input, asciiRunHyperlinks) {
+    EXPECT_EQ(ASCIIRunDifference("see http://terminalpp.com for details", 80, 4, true), "");
+    // the link wraps to the next line
+    EXPECT_EQ(ASCIIRunDifference("see https://github.com/terminalpp/terminalpp/issues now", 20, 6, true), "");
+    EXPECT_EQ(ASCIIRunDifference("http://a.com\r\nhttp://b.com http://c.com ", 16, 4, true), "");
+}
+
+TEST(terminal_input, asciiRunAcrossBuffers) {
+    // long runs cross the vector widths and the chunk boundaries at various offsets
+    std::string input;
+    for (int i = 0; i < 40; ++i)
+        input += STR("line " << i << " of text with varying length " << std::string(static_cast<size_t>(i), '.') << "\r\n");
+    EXPECT_EQ(ASCIIRunDifference(input, 33, 10), "");
+}
+
+namespace {
+
+    /** Returns the first difference between the input received in a single buffer and received byte by byte, or an empty string if there is none.
+
+        Line feeds received in a single buffer may be coalesced into a single scroll, while byte by byte each line feed scrolls separately.
+     */
+    std::string CoalescedLFDifference(std::string const & input, int cols, int rows) {
+        TestTerminal expected{cols, rows};
+        expected.feed(input, 1);
+        TestTerminal t{cols, rows};
+        t.feed(input);
+        return t.differenceFrom(expected);
+    }
+
+}
+
+TEST(terminal_input, coalescedLFs) {
+    EXPECT_EQ(CoalescedLFDifference("1\n2\n3\n4\n5\n6\n7\n8\n9\n", 10, 6), "");
+    EXPECT_EQ(CoalescedLFDifference("1\r\n2\r\n3\t4\r\n5\r\n6\r\n7\r\n8\t\r\n9\r\n", 10, 6), "");
+    // partial scroll region
+    EXPECT_EQ(CoalescedLFDifference("\033[2;5r\033[5;1H1\n2\n3\n4\n5\n", 10, 6), "");
+}
+
+TEST(terminal_input, coalescedLFsWithWrappingText) {
+    EXPECT_EQ(CoalescedLFDifference("\033[2;4r\033[4;1Hx\nABCDEFGHIJKLMNOPQRS\nB\n", 10, 6), "");
+    EXPECT_EQ(CoalescedLFDifference("\033[6;1Hx\nABCDEFGHIJKLMNOPQRS\nB\nC\n", 10, 6), "");
+    EXPECT_EQ(CoalescedLFDifference("\033[2;5r\033[5;1Hx\n0123456789\n0123456789A\nB\n", 10, 6), "");
+    // tabs past the last column wrap as well
+    EXPECT_EQ(CoalescedLFDifference("\033[2;5r\033[5;1Hx\n\t\t\tx\nB\nC\n", 10, 6), "");
+    // the line feed itself wraps when the cursor is past the last column
+    EXPECT_EQ(CoalescedLFDifference("\033[2;5r\033[5;1H0123456789\n\n\nx", 10, 6), "");
+    EXPECT_EQ(CoalescedLFDifference("\033[6;1H0123456789\n0123456789\n\nx", 10, 6), "");
+    // multibyte characters take a single column
+    EXPECT_EQ(CoalescedLFDifference("\033[6;1Hx\n\xc4\x8d\xc4\x8d\xc4\x8d\xc4\x8d\xc4\x8d\xc4\x8d\xc4\x8d\xc4\x8d\xc4\x8d\n\xc4\x8d\n", 10, 6), "");
+}
+
+TEST(terminal_input, insertAndDeleteCharactersKeepLineEnds) {
+    TestTerminal t{8, 4};
+    t.feed("abc\r\ndefg\r\n");
+    EXPECT(t.isLineEnd(2, 0));
+    EXPECT(t.isLineEnd(3, 1));
+    // ICH moves the line end with the text
+    t.feed("\033[1;2H\033[2@");
+    EXPECT_EQ(static_cast<char>(t.cellAt(4, 0).codepoint()), 'c');
+    EXPECT(t.isLineEnd(4, 0));
+    EXPECT(! t.isLineEnd(2, 0));
+    // DCH as well
+    t.feed("\033[2;2H\033[P");
+    EXPECT_EQ(static_cast<char>(t.cellAt(2, 1).codepoint()), 'g');
+    EXPECT(t.isLineEnd(2, 1));
+    EXPECT(! t.isLineEnd(3, 1));
+    // line ends shifted past the end of the row are discarded
+    t.feed("\033[1;1H\033[4@");
+    for (int col = 0; col < 8; ++col)
+        EXPECT(! t.isLineEnd(col, 0));
+}
@@ -0,0 +1,88 @@
+#include "helpers/tests.h"
+
+#include "../csi_sequence.h"
+#include "../osc_sequence.h"
+
+using namespace ui;
+
+TEST(csi_sequence, complete) {
+    std::string input{"1;;23m"};
+    char const * x = input.c_str();
+    CSISequence seq;
+    EXPECT(seq.parse(x, input.c_str() + input.size()));
+    EXPECT(x == input.c_str() + input.size());
+    EXPECT(seq.complete() && seq.valid());
+    EXPECT_EQ(seq.numArgs(), 3);
+    EXPECT_EQ(seq[0], 1);
+    EXPECT_EQ(seq[1], 0);
+    EXPECT_EQ(seq[2], 23);
+    EXPECT_EQ(seq.finalByte(), 'm');
+}
+
+TEST(csi_sequence, split) {
+    std::string input{"?10;255h"};
+    // split the input at every position and feed the sequence the parts one by one
+    for (size_t i = 0; i < input.size(); ++i) {
+        CSISequence seq;
+        char const * x = input.c_str();
+        EXPECT(! seq.parse(x, input.c_str() + i));
+        EXPECT(x == input.c_str() + i);
+        EXPECT(seq.parse(x, input.c_str() + input.size()));
+        EXPECT(seq.complete() && seq.valid());
+        EXPECT_EQ(seq.firstByte(), '?');
+        EXPECT_EQ(seq.numArgs(), 2);
+        EXPECT_EQ(seq[0], 10);
+        EXPECT_EQ(seq[1], 255);
+        EXPECT_EQ(seq.finalByte(), 'h');
+    }
+}
+
+TEST(csi_sequence, controlCharacter) {
+    std::string input{"1\n2H"};
+    char const * x = input.c_str();
+    CSISequence seq;
+    EXPECT(! seq.parse(x, input.c_str() + input.size()));
+    EXPECT_EQ(*x, '\n');
+    ++x;
+    EXPECT(seq.parse(x, input.c_str() + input.size()));
+    EXPECT_EQ(seq[0], 12);
+    EXPECT_EQ(seq.finalByte(), 'H');
+}
+
+TEST(osc_sequence, split) {
+    std::string input{"2;window title\033\\"};
+    for (size_t i = 0; i < input.size(); ++i) {
+        OSCSequence seq;
+        char const * x = input.c_str();
+        EXPECT(! seq.parse(x, input.c_str() + i));
+        EXPECT(seq.parse(x, input.c_str() + input.size()));
+        EXPECT(x == input.c_str() + input.size());
+        EXPECT(seq.complete() && seq.valid());
+        EXPECT_EQ(seq.num(), 2);
+        EXPECT_EQ(seq.numArgs(), 1);
+        EXPECT_EQ(seq[0], "window title");
+    }
+}
+
+TEST(osc_sequence, multipleValues) {
+    std::string input{"8;;http://terminalpp.com\007"};
+    char const * x = input.c_str();
+    OSCSequence seq;
+    EXPECT(seq.parse(x, input.c_str() + input.size()));
+    EXPECT_EQ(seq.num(), 8);
+    EXPECT_EQ(seq.numArgs(), 2);
+    EXPECT(seq[0].empty());
+    EXPECT_EQ(seq[1], "http://terminalpp.com");
+}
+
+TEST(csi_sequence, tooManyArguments) {
+    std::string input;
+    for (size_t i = 0; i <= CSISequence::MAX_ARGS; ++i)
+        input += "1;";
+    input += "m";
+    char const * x = input.c_str();
+    CSISequence seq;
+    EXPECT(seq.parse(x, input.c_str() + input.size()));
+    EXPECT(x == input.c_str() + input.size());
+    EXPECT(! seq.valid());
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "helpers/tests.h"
+
+#include "tpp-lib/null_pty.h"
+#include "ui/special_objects/hyperlink.h"
+
+#include "../ansi_terminal.h"
+
+namespace ui {
+
+    /** Terminal without a renderer whose input is fed by the tests.
+     */
+    class TestTerminal : public AnsiTerminal {
+    public:
+        TestTerminal(int cols, int rows, bool detectHyperlinks = false):
+            AnsiTerminal{new tpp::NullPTYMaster{}, Palette::XTerm256()} {
+            setHistoryLimit(1024 * 1024);
+            setDetectHyperlinks(detectHyperlinks);
+            resize(Size{cols, rows});
+            state_->buffer.clearDirty();
+        }
+
+        /** Feeds the input to the terminal in chunks of given size.
+         */
+        void feed(std::string const & input, size_t chunkSize = std::string::npos) {
+            std::string data{input};
+            char * x = & data[0];
+            char * end = x + data.size();
+            while (x != end) {
+                char * chunkEnd = x + std::min(chunkSize, static_cast<size_t>(end - x));
+                size_t processed = received(x, chunkEnd);
+                if (processed == 0)
+                    break;
+                x += processed;
+            }
+        }
+
+        Cell const & cellAt(int col, int row) const {
+            return static_cast<Buffer const &>(state_->buffer).at(Point{col, row});
+        }
+
+        bool isLineEnd(int col, int row) const {
+            return Buffer::IsLineEnd(cellAt(col, row));
+        }
+
+        Point cursor() const {
+            return state_->buffer.cursorPosition();
+        }
+
+        bool isDirty(int row) const {
+            return state_->buffer.isDirty(row);
+        }
+
+        /** Returns the description of the first difference between the contents of the terminals, or an empty string if they are identical.
+
+            The cursor, the visible cells including their line end and dirty flags and hyperlinks and the history rows are compared.
+         */
+        std::string differenceFrom(TestTerminal & other) {
+            // const access so that reading the cells does not clear their line end flags
+            Buffer const & a = state_->buffer;
+            Buffer const & b = other.state_->buffer;
+            if (a.size() != b.size())
+                return STR("size " << a.width() << "x" << a.height() << " vs " << b.width() << "x" << b.height());
+            if (a.cursorPosition() != b.cursorPosition())
+                return STR("cursor " << a.cursorPosition() << " vs " << b.cursorPosition());
+            for (int row = 0; row < a.height(); ++row) {
+                if (a.isDirty(row) != b.isDirty(row))
+                    return STR("dirty flag of row " << row);
+                for (int col = 0; col < a.width(); ++col) {
+                    Cell const & x = a.at(Point{col, row});
+                    Cell const & y = b.at(Point{col, row});
+                    if (x.codepoint() != y.codepoint() || x.fg() != y.fg() || x.bg() != y.bg() || x.font() != y.font())
+                        return STR("cell " << Point{col, row} << ": " << Char{x.codepoint()} << " vs " << Char{y.codepoint()});
+                    if (Buffer::IsLineEnd(x) != Buffer::IsLineEnd(y))
+                        return STR("line end at " << Point{col, row});
+                    if (HyperlinkUrl(x) != HyperlinkUrl(y))
+                        return STR("hyperlink at " << Point{col, row} << ": " << HyperlinkUrl(x) << " vs " << HyperlinkUrl(y));
+                }
+            }
+            if (history_->rows() != other.history_->rows())
+                return STR("history rows " << history_->rows() << " vs " << other.history_->rows());
+            for (size_t i = 0; i < history_->rows(); ++i) {
+                auto x = history_->row(i);
+                auto y = other.history_->row(i);
+                if (x.second != y.second)
+                    return STR("history row " << i << " length");
+                for (int col = 0; col < x.second; ++col)
+                    if (x.first[col].codepoint() != y.first[col].codepoint() || Buffer::IsLineEnd(x.first[col]) != Buffer::IsLineEnd(y.first[col]))
+                        return STR("history row " << i << " column " << col);
+            }
+            return std::string{};
+        }
+
+    private:
+
+        static std::string HyperlinkUrl(Cell const & cell) {
+            Hyperlink * link = dynamic_cast<Hyperlink *>(cell.specialObject());
+            return link == nullptr ? std::string{} : link->url();
+        }
+
+    }; // ui::TestTerminal
+
+} // namespace ui
@@ -5,6 +5,7 @@
 namespace ui {
 
     class Border {
+        friend struct std::hash<Border>;
     public:
 
         enum class Kind {
@@ -126,4 +127,15 @@ namespace ui {
 
     }; // ui::Border
 
-}
\ No newline at end of file
+} // namespace ui
+
+namespace std {
+
+    template<>
+    struct hash<ui::Border> {
+        size_t operator () (ui::Border const & x) const {
+            return std::hash<uint64_t>()((static_cast<uint64_t>(x.color_.toRGBA()) << 8) | x.border_);
+        }
+    };
+
+} // namespace std
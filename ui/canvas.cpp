@@ -5,8 +5,16 @@
 
 namespace ui {
 
-    std::unordered_map<Canvas::Cell *, Canvas::SpecialObject *> Canvas::SpecialObject::Objects_;
-    std::mutex Canvas::SpecialObject::MObjects_;
+    Canvas::SpecialObject ** Canvas::SpecialObject::Table_[MAX_CHUNKS];
+    std::vector<uint32_t> Canvas::SpecialObject::FreeHandles_;
+    uint32_t Canvas::SpecialObject::NextHandle_ = 1;
+    std::mutex Canvas::SpecialObject::MTable_;
+
+    Border Canvas::Cell::FirstBorders_[BORDER_CHUNK_SIZE];
+    Border * Canvas::Cell::Borders_[MAX_BORDER_CHUNKS] = { FirstBorders_ };
+    std::unordered_map<Border, uint16_t> Canvas::Cell::BorderIndices_;
+    uint32_t Canvas::Cell::NextBorder_ = 1;
+    std::mutex Canvas::Cell::MBorders_;
 
     Canvas::Canvas(Buffer & buffer, VisibleArea const & visibleArea, Size const & size):
         visibleArea_{visibleArea},
@@ -59,24 +67,29 @@ namespace ui {
         Rect r = (Rect{at, buffer.size()} & visibleArea_.rect()) + visibleArea_.offset();
         // calculate the buffer offset for the input buffer
         Point bufferOffset = at + visibleArea_.offset();
-        for (int row = r.top(), re = r.bottom(); row < re; ++row) {
-            for (int col = r.left(), ce = r.right(); col < ce; ++col) {
-                buffer_->at(col, row) = buffer.at(col - bufferOffset.x(), row - bufferOffset.y());
-            }
-        }
+        if (r.empty())
+            return *this;
+        for (int row = r.top(), re = r.bottom(); row < re; ++row)
+            buffer_->copyRow(row, r.left(), buffer, Point{r.left() - bufferOffset.x(), row - bufferOffset.y()}, r.width());
         return *this;
     }
 
     Canvas & Canvas::drawFallbackBuffer(Buffer const & buffer, Point at) {
+        return drawFallbackBuffer(buffer, Rect{buffer.size()}, at);
+    }
+
+    Canvas & Canvas::drawFallbackBuffer(Buffer const & buffer, Rect const & part, Point at) {
+        // clip the part to the input buffer, moving the target accordingly
+        Rect src = part & Rect{buffer.size()};
+        at += src.topLeft() - part.topLeft();
         // calculate the target rectangle in the canvas and its intersection with the visible rectangle and offset it to the backing buffer coordinates
-        Rect r = (Rect{at, buffer.size()} & visibleArea_.rect()) + visibleArea_.offset();
+        Rect r = (Rect{at, src.size()} & visibleArea_.rect()) + visibleArea_.offset();
         // calculate the buffer offset for the input buffer
-        Point bufferOffset = at + visibleArea_.offset();
-        for (int row = r.top(), re = r.bottom(); row < re; ++row) {
-            for (int col = r.left(), ce = r.right(); col < ce; ++col) {
-                buffer_->at(col, row).stripSpecialObjectAndAssign(buffer.at(col - bufferOffset.x(), row - bufferOffset.y()));
-            }
-        }
+        Point bufferOffset = at + visibleArea_.offset() - src.topLeft();
+        if (r.empty())
+            return *this;
+        for (int row = r.top(), re = r.bottom(); row < re; ++row)
+            buffer_->copyRow(row, r.left(), buffer, Point{r.left() - bufferOffset.x(), row - bufferOffset.y()}, r.width(), true);
         return *this;
     }
 
@@ -89,7 +102,8 @@ namespace ui {
                     c.setBg(color);
                     c.setCodepoint(' ');
                     c.font().andAttributesFrom(Font{});
-                    c.setBorder(c.border().clear());
+                    if (! c.border().empty())
+                        c.setBorder(Border{c.border()}.clear());
                 }
             }
         } else {
@@ -99,7 +113,7 @@ namespace ui {
                     c.setFg(color.blendOver(c.fg()));
                     c.setBg(color.blendOver(c.bg()));
                     c.setDecor(color.blendOver(c.decor()));
-                    c.border().setColor(color.blendOver(c.border().color()));
+                    c.setBorder(Border{c.border()}.setColor(color.blendOver(c.border().color())));
                 }
             }
         }
@@ -112,6 +126,8 @@ namespace ui {
             for (int x = r.left(), xe = r.right(); x < xe; ++x) {
                 buffer_->at(x,y) = fill;
             }
+            if (fill.hasSpecialObject())
+                buffer_->markSpecialObjects(y);
         }
         return *this;
 
@@ -208,26 +224,70 @@ namespace ui {
         return *this;
     }
 
-    // Canvas::SpecialObject
+    // Canvas::Cell
 
-    void Canvas::SpecialObject::detachFromAllCells() {
-        {
-            std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-            for (auto i = Objects_.begin(), e = Objects_.end(); i != e; ++i) {
-                if (i->second == this) {
-                    --refCount_;
-                    i->first->codepoint_ &= ~ Cell::SPECIAL_OBJECT;
-                    auto tmp = i;
-                    ++i;
-                    Objects_.erase(tmp);
-                } else {
-                    ++i;
-                }
+    uint16_t Canvas::Cell::InternBorder(Border const & border) {
+        if (border == Border{})
+            return 0;
+        // consecutive cells mostly get the same border, which can be found without the lock
+        thread_local Border lastBorder;
+        thread_local uint16_t lastIndex = 0;
+        if (lastIndex != 0 && border == lastBorder)
+            return lastIndex;
+        std::lock_guard<std::mutex> g{MBorders_};
+        auto i = BorderIndices_.find(border);
+        if (i == BorderIndices_.end()) {
+            if (NextBorder_ >= MAX_BORDER_CHUNKS * BORDER_CHUNK_SIZE) {
+                LOG() << "All " << (MAX_BORDER_CHUNKS * BORDER_CHUNK_SIZE - 1) << " cell borders are taken, the border will not be set";
+                return 0;
             }
+            uint16_t index = static_cast<uint16_t>(NextBorder_++);
+            // chunks are allocated when first used and never freed so that lookups do not need the lock
+            Border * & chunk = Borders_[index >> BORDER_CHUNK_BITS];
+            if (chunk == nullptr)
+                chunk = new Border[BORDER_CHUNK_SIZE];
+            chunk[index & (BORDER_CHUNK_SIZE - 1)] = border;
+            i = BorderIndices_.insert(std::make_pair(border, index)).first;
+        }
+        lastBorder = border;
+        lastIndex = i->second;
+        return lastIndex;
+    }
 
+    // Canvas::SpecialObject
+
+    Canvas::SpecialObject::SpecialObject() {
+        std::lock_guard<std::mutex> g{MTable_};
+        if (FreeHandles_.empty()) {
+            // the object is usable without a handle, it just cannot be attached to cells
+            if ((NextHandle_ >> CHUNK_BITS) >= MAX_CHUNKS) {
+                LOG() << "All " << (MAX_CHUNKS * CHUNK_SIZE - 1) << " special object handles are taken, the new object will not be attached to cells";
+                handle_ = 0;
+                return;
+            }
+            handle_ = NextHandle_++;
+            // chunks are allocated when first used and never freed so that lookups do not need the lock
+            SpecialObject ** & chunk = Table_[handle_ >> CHUNK_BITS];
+            if (chunk == nullptr)
+                chunk = new SpecialObject*[CHUNK_SIZE];
+        } else {
+            handle_ = FreeHandles_.back();
+            FreeHandles_.pop_back();
         }
-        if (refCount_ == 0)
-            delete this;
+        Table_[handle_ >> CHUNK_BITS][handle_ & (CHUNK_SIZE - 1)] = this;
+    }
+
+    Canvas::SpecialObject::SpecialObject(SpecialObject const & from):
+        SpecialObject{} {
+        MARK_AS_UNUSED(from);
+    }
+
+    Canvas::SpecialObject::~SpecialObject() {
+        if (handle_ == 0)
+            return;
+        std::lock_guard<std::mutex> g{MTable_};
+        Table_[handle_ >> CHUNK_BITS][handle_ & (CHUNK_SIZE - 1)] = nullptr;
+        FreeHandles_.push_back(handle_);
     }
 
 } // namespace ui
\ No newline at end of file
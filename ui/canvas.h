@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
 #include "font.h"
 #include "color.h"
 #include "border.h"
@@ -127,6 +132,10 @@ namespace ui {
          */
         Canvas & drawFallbackBuffer(Buffer const & buffer, Point at);
 
+        /** Draws the given part of the fallback buffer so that its top left corner is at given coordinates. 
+         */
+        Canvas & drawFallbackBuffer(Buffer const & buffer, Rect const & part, Point at);
+
         Canvas & fill(Rect const & rect) {
             return fill(rect, bg_);
         }
@@ -327,7 +336,9 @@ namespace ui {
 
         Special object manipulation (i.e. attaching and detaching from cells and pointers) is thread safe as long as the cell or pointer access is thread safe (the pointer or the cell cannot be accessed concurrently, but two unrelated cells or pointers can attach and detach to the same special object).
 
-        Internally, the SpecialObject holds a map from cell addresses to special objects for the cells that have special object attached. Each cell then has a bit flag that determines whether an attachment to special object exists, or not. 
+        Internally, each special object is given a 32bit handle when created, which is what the cells store. Handles are translated to the objects via a chunked table whose chunks never move so that the lookup requires no locking. The table is only locked when special objects are created or deleted, attaching and detaching cells only updates the atomic reference counter. 
+
+        If all handles are taken, new special objects get no handle and an error is logged. They can still be held by Ptr, but attaching them to cells only detaches whatever object the cells had. 
      */
     class Canvas::SpecialObject {
         friend class Cell;
@@ -360,25 +371,13 @@ namespace ui {
             }
 
             Ptr & operator = (Ptr const & other) {
-                if (ptr_ != other.ptr_) {
-                    std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                    if (ptr_ != nullptr && --ptr_->refCount_ == 0)
-                        delete ptr_;
-                    ptr_ = other.ptr_;
-                    if (ptr_ != nullptr)
-                        ++ptr_->refCount_;
-                }
-                return *this;
+                return *this = other.ptr_;
             }
 
             Ptr & operator = (T * other) {
                 if (ptr_ != other) {
-                    std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                    if (ptr_ != nullptr && --(ptr_->refCount_) == 0)
-                        delete ptr_;
-                    ptr_ = other;
-                    if (ptr_ != nullptr)
-                        ++ptr_->refCount_;
+                    detach();
+                    attach(other);
                 }
                 return *this;
             }
@@ -398,34 +397,31 @@ namespace ui {
         private:
 
             void attach(T * so) {
-                if (so != nullptr) {
-                    std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
+                if (so != nullptr)
                     ++(so->refCount_);
-                }
                 ptr_ = so;
             }
 
             void detach() {
-                if (ptr_ == nullptr)
-                    return;
-                std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                if (--(ptr_->refCount_) == 0)
-                    delete ptr_;
+                if (ptr_ != nullptr)
+                    ptr_->release();
             }
 
             T * ptr_;
 
         }; // ui::Canvas::SpecialObject::Ptr
 
-        /** Virtual destructor so that special objects do not leak when destroyed. 
+        /** Creates the special object and assigns it a handle. 
          */
-        virtual ~SpecialObject() = default;
+        SpecialObject();
 
-        /** Detaches the object from all its cells. 
-         
-            If the object is not referenced from anywhere else, deletes the object at the end. 
+        /** Copies of special objects have their own handle and are not attached to any cells. 
          */
-        void detachFromAllCells();
+        SpecialObject(SpecialObject const & from);
+
+        /** Virtual destructor so that special objects do not leak when destroyed. Releases the handle. 
+         */
+        virtual ~SpecialObject();
 
     protected:
 
@@ -442,23 +438,59 @@ namespace ui {
 
     private:
 
+        /** Drops a reference to the object, deleting it if it was the last one. 
+         */
+        void release() {
+            if (--refCount_ == 0)
+                delete this;
+        }
+
+        /** Returns the special object for given handle. 
+         
+            The handle must be valid, i.e. the object must be referenced by the caller. 
+         */
+        static SpecialObject * Get(uint32_t handle) {
+            ASSERT(handle != 0 && Table_[handle >> CHUNK_BITS] != nullptr);
+            return Table_[handle >> CHUNK_BITS][handle & (CHUNK_SIZE - 1)];
+        }
+
+        static constexpr unsigned CHUNK_BITS = 12;
+        static constexpr uint32_t CHUNK_SIZE = 1 << CHUNK_BITS;
+        static constexpr unsigned MAX_CHUNKS = 4096;
+
         /** Number of references (cells and Ptr's) that point to the special object. 
          */
-        size_t refCount_ = 0;
+        std::atomic<size_t> refCount_{0};
+
+        /** Handle of the object stored in the cells, 0 if all handles were taken when the object was created. 
+         */
+        uint32_t handle_;
+
+        /** Chunks of the handle to object table. 
+         */
+        static SpecialObject ** Table_[MAX_CHUNKS];
+
+        /** Handles released by deleted objects, reused before new handles are created. 
+         */
+        static std::vector<uint32_t> FreeHandles_;
 
-        /** Map of reachable special objects. 
+        /** Next handle to be created if there are no free ones. Handle 0 is reserved for no object. 
          */
-        static std::unordered_map<Cell *, SpecialObject *> Objects_;
+        static uint32_t NextHandle_;
 
-        /** Guard for multi-threaded access to the special object. 
+        /** Guard for handle allocation and release. 
          */
-        static std::mutex MObjects_;
+        static std::mutex MTable_;
 
     }; // ui::Canvas::SpecialObject
 
     /** Canvas cell. 
      
         Each cell contains all drawable information about a single character, i.e. its codepoints, colors, effects, font, borders, etc. Additionally a cell can be attached to a special object, which may provide further information abouty the cell's visual appearance, or behavior. For more details see ui::Canvas::SpecialObject. 
+
+        The attributes are stored in the cell itself rather than as an index to a style table of the buffer. Cells are freely copied between buffers (the terminal paints its buffer into the renderer's one) and to temporaries that belong to no buffer, and are modified in place through the setters below, so an index would only be valid with the table it was created from. Style interning is therefore only done where the rows have a single owner, i.e. in the terminal history, see ui::AnsiTerminal::History. 
+
+        The only exception is the border, which is rarely used outside of widgets and is stored as an index to a process-wide table of all borders ever set, so that the cell, together with the handle of its special object, fits in 24 bytes. 
      */
     class Canvas::Cell {
         friend class Canvas::Buffer;
@@ -469,27 +501,24 @@ namespace ui {
          */
         Cell():
             codepoint_{' '},
+            object_{0},
             fg_{Color::White},
             bg_{Color::Black},
             decor_{Color::White},
             font_{},
-            border_{} {
+            border_{0} {
         }
 
         Cell(Cell const & from):
             codepoint_{from.codepoint_},
+            object_{from.object_},
             fg_{from.fg_},
             bg_{from.bg_},
             decor_{from.decor_},
             font_{from.font_},
             border_{from.border_} {
-            SpecialObject * so = from.specialObject();
-            if (so != nullptr) {
-                std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                SpecialObject::Objects_.insert(std::pair<Cell *, SpecialObject*>{this, so});
-                ASSERT(codepoint_ & SPECIAL_OBJECT);
-                ++so->refCount_;
-            }
+            if (object_ != 0)
+                ++(SpecialObject::Get(object_)->refCount_);
         }
 
         /** Destroys the cell. 
@@ -497,48 +526,47 @@ namespace ui {
             While nothing has to be done for normal cell, a special cell must detach and possibly delete the special object it contains.
          */
         ~Cell() {
-            if (hasSpecialObject())
-                detachSpecialObject();
+            if (object_ != 0)
+                SpecialObject::Get(object_)->release();
         }
 
         /** Assignment between cells. 
          
-            If the other cell has a special object attached to it, copies the attachment as well, which makes the assignment operator slightly more complex than a simple memory copy. 
-
-            The code is more complex than necessary so that the whole assignment can be done on a single mutex lock. 
+            If the other cell has a special object attached to it, copies the attachment as well, which only requires updating the reference counts of the old and new special objects. 
          */
         Cell & operator = (Cell const & other) {
             // don't do anything for autoassign
             if (this == & other)
                 return *this;
-            bool hadSo = hasSpecialObject();
+            uint32_t old = object_;
             // casting to void * so that compiler won't give warnings that non POD object is copied, since we deal with the special object later
             memcpy(static_cast<void*>(this), static_cast<void const *>(& other), sizeof(Cell));
-            bool hasSo = hasSpecialObject();
-            if (hadSo) {
-                std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                auto i = SpecialObject::Objects_.find(this);
-                if (--(i->second->refCount_) == 0)
-                    delete i->second;
-                if (hasSo) {
-                    // had & has
-                    auto j = SpecialObject::Objects_.find(const_cast<Cell*>(& other));
-                    i->second = j->second;
-                    ++(i->second->refCount_);
-                } else {
-                    // had, but does not - detach
-                    SpecialObject::Objects_.erase(i);
-                }
-            } else if (hasSo) {
-                // did not have special object, but now we do have it
-                std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                auto j = SpecialObject::Objects_.find(const_cast<Cell*>(& other));
-                SpecialObject::Objects_.insert(std::pair<Cell*, SpecialObject*>{this, j->second});
-                ++j->second->refCount_;
-            }
+            // reference the new object first in case it is the same one as the old
+            if (object_ != 0)
+                ++(SpecialObject::Get(object_)->refCount_);
+            if (old != 0)
+                SpecialObject::Get(old)->release();
             return *this;
         };
 
+        /** Compares the contents of two cells. 
+
+            The cells are equal if they have the same codepoint, attributes and special object. The cell flags stored by the buffers in the unused codepoint bits are ignored. 
+         */
+        bool operator == (Cell const & other) const {
+            return codepoint() == other.codepoint()
+                && object_ == other.object_
+                && fg_ == other.fg_
+                && bg_ == other.bg_
+                && decor_ == other.decor_
+                && font_ == other.font_
+                && border_ == other.border_;
+        }
+
+        bool operator != (Cell const & other) const {
+            return ! (*this == other);
+        }
+
         /** Assigns the contents of the argument to itself, stripping any attached special objects. 
 
             The cell is considered a fallback cell and once the attributes of the original cell are copied, modulo the special object binding, the special object can modify the cell contents via the updateFallbackCell method. 
@@ -548,23 +576,15 @@ namespace ui {
         Cell & stripSpecialObjectAndAssign(Cell const & from) {
             if (& from == this)
                 return *this;
-            bool hadSo = hasSpecialObject();
+            uint32_t old = object_;
             // casting to void * so that compiler won't give warnings that non POD object is copied, since we deal with the special object later
             memcpy(static_cast<void*>(this), static_cast<void const *>(& from), sizeof(Cell));
-            {
-                std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                if (hadSo) {
-                    auto i = SpecialObject::Objects_.find(this);
-                    if (--(i->second->refCount_) == 0)
-                        delete i->second;
-                    SpecialObject::Objects_.erase(i);
-                }
-                auto j = SpecialObject::Objects_.find(const_cast<Cell*>(& from));
-                if (j != SpecialObject::Objects_.end()) {
-                    j->second->updateFallbackCell(*this, from);
-                    codepoint_ &= ~ SPECIAL_OBJECT;
-                }
+            if (object_ != 0) {
+                object_ = 0;
+                from.specialObject()->updateFallbackCell(*this, from);
             }
+            if (old != 0)
+                SpecialObject::Get(old)->release();
             return *this;
         }
 
@@ -573,59 +593,38 @@ namespace ui {
             Since special objects are reference counted, if this is the last cell to point at the object, the special object itself is deleted. 
          */
         Cell & detachSpecialObject() {
-            if (hasSpecialObject()) {
-                codepoint_ &= ~ SPECIAL_OBJECT;
-                std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                auto i = SpecialObject::Objects_.find(this);
-                ASSERT(i != SpecialObject::Objects_.end());
-                if (--(i->second->refCount_) == 0)
-                    delete i->second;
-                SpecialObject::Objects_.erase(i);
+            if (object_ != 0) {
+                uint32_t old = object_;
+                object_ = 0;
+                SpecialObject::Get(old)->release();
             }
             return *this;
         }
 
         /** Attaches given special object to the cell. 
          
-            If the cell already has a special object attached to it, the old object is detached first. 
+            If the cell already has a special object attached to it, the old object is detached first. Objects without a handle cannot be attached, so that the cell ends up with no special object.
          */
         Cell & attachSpecialObject(SpecialObject * so) {
             ASSERT(so != nullptr);
-            std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-            if (hasSpecialObject()) {
-                auto i = SpecialObject::Objects_.find(this);
-                ASSERT(i != SpecialObject::Objects_.end());
-                if (i->second != so) {
-                    if (--(i->second->refCount_) == 0)
-                        delete i->second;
-                    i->second = so;
-                    ++(i->second->refCount_);
-                }
-            } else {
-                SpecialObject::Objects_.insert(std::pair<Cell *, SpecialObject*>{this, so});
-                codepoint_ |= SPECIAL_OBJECT;
-                ++so->refCount_;
-            }
+            if (so->handle_ == 0)
+                return detachSpecialObject();
+            ++(so->refCount_);
+            detachSpecialObject();
+            object_ = so->handle_;
             return *this;
         }
 
         /** Returns true if the cell has a special object attached to it. 
          */
         bool hasSpecialObject() const {
-            return (codepoint_ & SPECIAL_OBJECT) != 0;
+            return object_ != 0;
         }
 
         /** Returns the special object attached to the cell, or nullptr if there is none. 
          */
         SpecialObject * specialObject() const {
-            if (!hasSpecialObject()) {
-                return nullptr;
-            } else {
-                std::lock_guard<std::mutex> g{SpecialObject::MObjects_};
-                auto i = SpecialObject::Objects_.find(const_cast<Cell*>(this));
-                ASSERT(i != SpecialObject::Objects_.end());
-                return i->second;
-            }
+            return object_ == 0 ? nullptr : SpecialObject::Get(object_);
         }
 
         /** \name Codepoint of the cell. 
@@ -703,15 +702,12 @@ namespace ui {
          */
         //@{
         Border const & border() const {
-            return border_;
-        }
-
-        Border & border() {
-            return border_;
+            ASSERT(Borders_[border_ >> BORDER_CHUNK_BITS] != nullptr);
+            return Borders_[border_ >> BORDER_CHUNK_BITS][border_ & (BORDER_CHUNK_SIZE - 1)];
         }
 
         Cell & setBorder(Border const & value) {
-            border_ = value;
+            border_ = InternBorder(value);
             return *this;
         }
         //@}
@@ -719,22 +715,57 @@ namespace ui {
 
     private:
 
-        /** Marker indicating that special object is attached to the cell. 
+        /** Codepoint of the cell. The upper bits are used by Canvas::Buffer for cell flags. 
          */
-        static const char32_t SPECIAL_OBJECT = 0x80000000;
+        char32_t codepoint_;
 
-        /** Codepoint and discriminator between normal and special cell type. 
+        /** Handle of the attached special object, 0 if none. 
          */
-        char32_t codepoint_;
+        uint32_t object_;
 
         Color fg_;
         Color bg_;
         Color decor_;
         Font font_;
-        Border border_;
+
+        /** Index of the cell's border in the border table. 
+         */
+        uint16_t border_;
+
+        /** Returns the index of given border in the border table, adding the border to it if not yet present. 
+         
+            The empty border has always index 0. If the table is full, the border is logged as lost and index 0 is returned. 
+         */
+        static uint16_t InternBorder(Border const & border);
+
+        static constexpr unsigned BORDER_CHUNK_BITS = 8;
+        static constexpr uint32_t BORDER_CHUNK_SIZE = 1 << BORDER_CHUNK_BITS;
+        static constexpr unsigned MAX_BORDER_CHUNKS = 256;
+
+        /** Chunks of the border table. Borders are never removed so that the cells can read them without locking. 
+         */
+        static Border * Borders_[MAX_BORDER_CHUNKS];
+
+        /** The first chunk, which always exists as it holds the empty border. 
+         */
+        static Border FirstBorders_[BORDER_CHUNK_SIZE];
+
+        /** Indices of the borders already in the table. 
+         */
+        static std::unordered_map<Border, uint16_t> BorderIndices_;
+
+        /** Index of the next border to be added to the table. 
+         */
+        static uint32_t NextBorder_;
+
+        /** Guard for adding borders to the table. 
+         */
+        static std::mutex MBorders_;
 
     }; // ui::Canvas::Cell
 
+    static_assert(sizeof(Canvas::Cell) == 24, "Canvas cells are copied in bulk, keep them small");
+
     class Canvas::Buffer {
     public:
 
@@ -745,17 +776,27 @@ namespace ui {
 
         Buffer(Buffer && from) noexcept:
             size_{from.size_},
-            rows_{from.rows_} {
+            cells_{from.cells_},
+            rows_{from.rows_},
+            head_{from.head_},
+            specialObjects_{std::move(from.specialObjects_)} {
             from.size_ = Size{0,0};
+            from.cells_ = nullptr;
             from.rows_ = nullptr;
+            from.head_ = 0;
         }
 
         Buffer & operator = (Buffer && from) noexcept {
             clear();
             size_ = from.size_;
+            cells_ = from.cells_;
             rows_ = from.rows_;
+            head_ = from.head_;
+            specialObjects_ = std::move(from.specialObjects_);
             from.size_ = Size{0,0};
+            from.cells_ = nullptr;
             from.rows_ = nullptr;
+            from.head_ = 0;
             return *this;
         }          
 
@@ -833,25 +874,132 @@ namespace ui {
                 SetUnusedBits(at(cursorPosition_), CURSOR_POSITION);
         }
 
+        /** Returns true if the given row may have cells with special objects attached. 
+
+            The buffer keeps a flag for each row that is set whenever a special object may have been attached to any of its cells and cleared only when the whole row is overwritten with cells that have no special objects. Rows without the flag are filled and copied with raw memory operations. The flag belongs to the row's cells and moves with them when the rows are rotated, or reordered. 
+         */
+        bool hasSpecialObjects(int row) const {
+            ASSERT(row >= 0 && row < height());
+            return specialObjects_[storageRow(row)];
+        }
+
+        /** Marks the row as having cells with special objects attached. 
+
+            Must be called whenever a special object is attached to a cell of the row through a reference obtained from at(), either by Cell::attachSpecialObject(), or by assigning a cell with a special object, so that the row's cells are not copied as raw memory. The buffer's own methods update the flag themselves. 
+         */
+        void markSpecialObjects(int row) {
+            ASSERT(row >= 0 && row < height());
+            specialObjects_[storageRow(row)] = true;
+        }
+
+        /** Attaches given special object to the cell at given position and marks its row as having special objects. 
+         */
+        void attachSpecialObject(Point p, SpecialObject * so) {
+            at(p).attachSpecialObject(so);
+            markSpecialObjects(p.y());
+        }
+
         /** Fills portion of given row with the specified cell. 
          
-            Exponentially increases the size of copied cells for performance.
+            If neither the fill cell has a special object attached, nor the row has special objects, the cells are filled with raw memory copies of exponentially increasing size. 
          */
         void fillRow(int row, Cell const & fill, int from, int cols) {
+            if (cols <= 0)
+                return;
+            std::vector<bool>::reference special = specialObjects_[storageRow(row)];
+            FillCells(rows_[row] + from, cols, fill, special);
+            // the row's special objects are gone only if the whole row has been overwritten
+            if (from == 0 && cols == width())
+                special = fill.hasSpecialObject();
+            else if (fill.hasSpecialObject())
+                special = true;
+        }
+
+        /** Fills the entire buffer with the specified cell. 
+         
+            Since all rows are stored in a single contiguous block of memory, the whole buffer is filled at once. 
+         */
+        void fill(Cell const & fill) {
+            bool special = std::find(specialObjects_.begin(), specialObjects_.end(), true) != specialObjects_.end();
+            FillCells(cells_, width() * height(), fill, special);
+            specialObjects_.assign(height(), fill.hasSpecialObject());
+        }
+
+        /** Copies given number of cells of a row of the source buffer, starting at the specified position, to the row starting at the specified column. 
+         
+            If stripSpecialObjects is true, the special objects of the copied cells are stripped, see Cell::stripSpecialObjectAndAssign(). The cells are copied with a single memory copy when neither the source, nor the destination row has special objects. 
+         */
+        void copyRow(int row, int col, Buffer const & from, Point fromStart, int cols, bool stripSpecialObjects = false) {
+            if (cols <= 0)
+                return;
+            Cell * r = rows_[row] + col;
+            Cell const * f = from.rows_[fromStart.y()] + fromStart.x();
+            std::vector<bool>::reference special = specialObjects_[storageRow(row)];
+            bool copiedSpecial = ! stripSpecialObjects && from.hasSpecialObjects(fromStart.y());
+            if (special || from.hasSpecialObjects(fromStart.y())) {
+                if (stripSpecialObjects) {
+                    for (int i = 0; i < cols; ++i)
+                        r[i].stripSpecialObjectAndAssign(f[i]);
+                } else {
+                    for (int i = 0; i < cols; ++i)
+                        r[i] = f[i];
+                }
+            } else {
+                ASSERT(! HasSpecialObjects(r, cols) && ! HasSpecialObjects(f, cols));
+                memmove(static_cast<void*>(r), static_cast<void const *>(f), sizeof(Cell) * cols);
+            }
+            if (col == 0 && cols == width())
+                special = copiedSpecial;
+            else if (copiedSpecial)
+                special = true;
+        }
+
+        /** Inserts given number of fill cells at the specified column of the row. 
+         
+            The cells right of the column are shifted right, those that no longer fit the row are discarded. The shifted cells are moved in memory at once, only the discarded cells of rows with special objects are checked for them. The shifted cells keep their unused bits, so that flags such as the terminal's line ends move with the text. 
+         */
+        void insertCells(int row, int col, int num, Cell const & fill) {
+            num = std::min(num, width() - col);
+            if (num <= 0)
+                return;
             Cell * r = rows_[row];
-            for (int e = from + cols; from < e; ++from)
-                r[from] = fill;
-            /*
-            r[from] = fill;
-            int i = 1;
-            int next = 2;
-            while (next < cols) {
-                memcpy(r + from + i, r + from, sizeof(Cell) * i);
-                i = next;
-                next *= 2;
+            int moved = width() - col - num;
+            bool special = hasSpecialObjects(row);
+            if (special) {
+                for (int i = col + moved, e = width(); i < e; ++i)
+                    r[i].detachSpecialObject();
             }
-            memcpy(r + from + i, r + from, sizeof(Cell) * (cols - i));
-            */
+            memmove(static_cast<void*>(r + col + num), static_cast<void const *>(r + col), sizeof(Cell) * moved);
+            // the vacated cells are bitwise copies of the moved cells whose references have been moved as well
+            if (special) {
+                for (int i = col, e = col + num; i < e; ++i)
+                    r[i].object_ = 0;
+            }
+            fillRow(row, fill, col, num);
+        }
+
+        /** Deletes given number of cells at the specified column of the row. 
+         
+            The cells right of the deleted ones are shifted left and the vacated cells at the end of the row are filled with the fill cell. The shifted cells are moved in memory at once, only the deleted cells of rows with special objects are checked for them. The shifted cells keep their unused bits, so that flags such as the terminal's line ends move with the text. 
+         */
+        void deleteCells(int row, int col, int num, Cell const & fill) {
+            num = std::min(num, width() - col);
+            if (num <= 0)
+                return;
+            Cell * r = rows_[row];
+            int moved = width() - col - num;
+            bool special = hasSpecialObjects(row);
+            if (special) {
+                for (int i = col, e = col + num; i < e; ++i)
+                    r[i].detachSpecialObject();
+            }
+            memmove(static_cast<void*>(r + col), static_cast<void const *>(r + col + num), sizeof(Cell) * moved);
+            // the vacated cells are bitwise copies of the moved cells whose references have been moved as well
+            if (special) {
+                for (int i = col + moved, e = width(); i < e; ++i)
+                    r[i].object_ = 0;
+            }
+            fillRow(row, fill, col + moved, num);
         }
 
     protected:
@@ -884,31 +1032,110 @@ namespace ui {
             cell.codepoint_ = (cell.codepoint_ & 0x801fffff) + (value & 0x7fe00000);
         }
 
+        /** Fills given cells with the fill cell. 
+         
+            If neither the fill cell, nor the cells being overwritten have special objects attached, as determined by the special argument, the cells are filled with raw memory copies of exponentially increasing size. 
+         */
+        static void FillCells(Cell * cells, int num, Cell const & fill, bool special) {
+            if (num <= 0)
+                return;
+            if (special || fill.hasSpecialObject()) {
+                for (int i = 0; i < num; ++i)
+                    cells[i] = fill;
+                return;
+            }
+            ASSERT(! HasSpecialObjects(cells, num));
+            // the fill cell may be one of the overwritten cells
+            memmove(static_cast<void*>(cells), static_cast<void const *>(& fill), sizeof(Cell));
+            for (int i = 1; i < num; ) {
+                int n = std::min(i, num - i);
+                memcpy(static_cast<void*>(cells + i), static_cast<void const *>(cells), sizeof(Cell) * n);
+                i += n;
+            }
+        }
+
+        /** Returns true if any of the given cells has a special object attached. 
+
+            Only used to check the row flags in debug builds, see hasSpecialObjects(). 
+         */
+        static bool HasSpecialObjects(Cell const * cells, int num) {
+            for (int i = 0; i < num; ++i)
+                if (cells[i].object_ != 0)
+                    return true;
+            return false;
+        }
+
         /** Unused bits flag that confirms that the cell has a visible cursor in it. 
          */
         static char32_t constexpr CURSOR_POSITION = 0x200000;
 
+        /** Rotates all rows of the buffer up by given number of rows in constant time. 
+         
+            The top rows become the bottom rows, their contents is not changed. 
+         */
+        void rotateRows(int by) {
+            ASSERT(by >= 0 && by <= height());
+            int head = head_ + by;
+            if (head >= height())
+                head -= height();
+            rows_ += head - head_;
+            head_ = head;
+        }
+
+        /** Returns the index of the given row in the cell storage, which does not change when the rows are rotated, or reordered. 
+         */
+        size_t storageRow(int row) const {
+            return static_cast<size_t>(rows_[row] - cells_) / static_cast<size_t>(width());
+        }
+
+        /** Updates the mirrored row pointers after the rows in given range have been reordered. 
+         */
+        void updateMirroredRows(int from, int to) {
+            Cell ** storage = rows_ - head_;
+            for (int i = head_ + from, e = head_ + to; i < e; ++i)
+                storage[i < height() ? i + height() : i - height()] = storage[i];
+        }
+
     protected:
 
         void create(Size const & size) {
-            rows_ = new Cell*[size.height()];
+            cells_ = new Cell[size.width() * size.height()];
+            rows_ = new Cell*[size.height() * 2];
             for (int i = 0; i < size.height(); ++i)
-                rows_[i] = new Cell[size.width()];
+                rows_[i] = rows_[i + size.height()] = cells_ + i * size.width();
+            head_ = 0;
             size_ = size;
+            specialObjects_.assign(size.height(), false);
         }
 
         void clear() {
             // rows can be nullptr if they have been backed up by a swap when resizing
             if (rows_ != nullptr) {
-                for (int i = 0; i < size_.height(); ++i)
-                    delete [] rows_[i];
-                delete [] rows_;
+                delete [] (rows_ - head_);
+                delete [] cells_;
+                rows_ = nullptr;
+                cells_ = nullptr;
             }
+            head_ = 0;
             size_ = Size{0,0};
+            specialObjects_.clear();
         }
 
         Size size_;
+        /** The cells of all rows in a single contiguous block. 
+         
+            Each row occupies width cells, but the order of the rows in the block does not correspond to their order in the buffer once rows have been rotated, or reordered. 
+         */
+        Cell * cells_;
+        /** The rows of the buffer.
+         
+            The row pointers are stored twice in an array of twice the buffer's height so that the rows can be rotated in constant time by moving the rows_ pointer to the new top row (head) in the array without any modulo arithmetic when accessing the rows. 
+         */
         Cell ** rows_;
+        int head_ = 0;
+        /** Rows that may have cells with special objects attached, indexed by their position in the cell storage, see hasSpecialObjects(). 
+         */
+        std::vector<bool> specialObjects_;
 
         Cursor cursor_;
         Point cursorPosition_;
@@ -10,6 +10,7 @@ namespace ui {
         Contains the information about the font size, type and decorations. 
      */
     class Font {
+        friend struct std::hash<Font>;
     public:
 
         Font() = default;
@@ -142,4 +143,15 @@ namespace ui {
 
     }; // ui::Font
 
-} // namespace ui
\ No newline at end of file
+} // namespace ui
+
+namespace std {
+
+    template<>
+    struct hash<ui::Font> {
+        size_t operator () (ui::Font const & x) const {
+            return std::hash<uint16_t>()(x.font_);
+        }
+    };
+
+} // namespace std
@@ -301,6 +301,14 @@ namespace ui {
         }
 
 
+        bool operator == (Rect const & other) const {
+            return topLeft_ == other.topLeft_ && size_ == other.size_;
+        }
+
+        bool operator != (Rect const & other) const {
+            return topLeft_ != other.topLeft_ || size_ != other.size_;
+        }
+
         Rect operator + (Point const & p) const {
             return Rect{topLeft_ + p, size_};
         }
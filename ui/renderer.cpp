@@ -14,9 +14,13 @@ namespace ui {
 
 
     Renderer::~Renderer() {
-        if (fpsThread_.joinable()) {
-            fps_ = 0;
-            fpsThread_.join();
+        if (frameScheduler_.joinable()) {
+            {
+                std::lock_guard<std::mutex> g{frameGuard_};
+                fps_ = 0;
+            }
+            frameCv_.notify_all();
+            frameScheduler_.join();
         }
         eq_.cancelEvents(eventDummy_);
         delete eventDummy_;
@@ -131,31 +135,76 @@ namespace ui {
         else
             renderWidget_ = renderWidget_->commonParentWith(widget);
         ASSERT(renderWidget_ != nullptr);
-        // if fps is 0, render immediately, otherwise wait for the renderer to paint
-        if (fps_ == 0) 
+        // if fps is 0, or this is the first repaint after user input, render immediately, otherwise wait for the frame scheduler
+        if (fps_ == 0 || immediateFrame_) 
             paintAndRender();
+        else
+            requestFrame();
     }
 
     void Renderer::paintAndRender() {
         UI_THREAD_ONLY;
-        if (renderWidget_ == nullptr)
-            return;
-        // paint the widget on the buffer
-        renderWidget_->paint();
-        // render the visible area of the widget, still under the priority lock
-        render(renderWidget_->visibleArea_.bufferRect());
-        renderWidget_ = nullptr;
+        immediateFrame_ = false;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        {
+            // all damage requested so far is painted by this frame
+            std::lock_guard<std::mutex> g{frameGuard_};
+            framePending_ = false;
+        }
+        if (renderWidget_ != nullptr) {
+            // paint the widget on the buffer
+            renderWidget_->paint();
+            // the paint time is kept until the frame is actually drawn, which may be after render() returns
+            paintDuration_ += std::chrono::steady_clock::now() - start;
+            // render the visible area of the widget, still under the priority lock
+            render(renderWidget_->visibleArea_.bufferRect());
+            renderWidget_ = nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> g{frameGuard_};
+            lastFrameStart_ = start;
+        }
+        frameCv_.notify_all();
     }   
 
-    void Renderer::startFPSThread() {
-        if (fpsThread_.joinable())
-            fpsThread_.join();
-        fpsThread_ = std::thread([this](){
-            while (fps_ != 0) {
+    void Renderer::requestFrame() {
+        {
+            std::lock_guard<std::mutex> g{frameGuard_};
+            if (framePending_)
+                return;
+            framePending_ = true;
+        }
+        frameCv_.notify_all();
+    }
+
+    void Renderer::startFrameScheduler() {
+        ASSERT(! frameScheduler_.joinable());
+        frameScheduler_ = std::thread([this](){
+            std::unique_lock<std::mutex> g{frameGuard_};
+            while (true) {
+                // sleep until a frame is requested and the previous frame has been painted
+                frameCv_.wait(g, [this](){ return fps_ == 0 || (framePending_ && ! frameScheduled_); });
+                if (fps_ == 0)
+                    break;
+                // wait for the frame interval since the last frame to coalesce the damage
+                std::chrono::steady_clock::duration interval = std::max<std::chrono::steady_clock::duration>(std::chrono::microseconds{1000000 / fps_}, lastFrameDuration_);
+                if (frameCv_.wait_until(g, lastFrameStart_ + interval, [this](){ return fps_ == 0; }))
+                    break;
+                // the damage might have been painted by an immediate frame in the meantime
+                if (! framePending_ || frameScheduled_)
+                    continue;
+                frameScheduled_ = true;
+                g.unlock();
                 schedule([this](){
                     paintAndRender();
+                    // only the scheduled frame clears the flag, immediate frames painted before it do not, so that it is never scheduled twice
+                    {
+                        std::lock_guard<std::mutex> g{frameGuard_};
+                        frameScheduled_ = false;
+                    }
+                    frameCv_.notify_all();
                 });
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000 / fps_));
+                g.lock();
             }
         });
     }
@@ -256,6 +305,7 @@ namespace ui {
 
     void Renderer::keyDown(Key k) {
         ASSERT(focusIn_);
+        inputReceived();
         keyDownFocus_ = keyboardFocus_;
         modifiers_ = k.modifiers();
         if (onKeyDown.attached()) {
@@ -289,6 +339,7 @@ namespace ui {
 
     void Renderer::keyChar(Char c) {
         ASSERT(focusIn_);
+        inputReceived();
         if (onKeyChar.attached()) {
             KeyCharEvent::Payload p{c};
             onKeyChar(p, this);
@@ -355,6 +406,7 @@ namespace ui {
 
     void Renderer::mouseWheel(Point coords, int by) {
         ASSERT(mouseIn_);
+        inputReceived();
         mouseCoords_ = coords;
         updateMouseFocus(coords);
         if (onMouseWheel.attached()) {
@@ -372,6 +424,7 @@ namespace ui {
 
     void Renderer::mouseDown(Point coords, MouseButton button) {
         ASSERT(mouseIn_);
+        inputReceived();
         mouseCoords_ = coords;
         updateMouseFocus(coords);
         // if this is first button to be held down, set the click start time and click button, otherwise invalidate the click info (multiple pressed buttons don't register as click)
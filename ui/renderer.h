@@ -199,6 +199,25 @@ namespace ui {
          */
         virtual void render(Rect const & rect) = 0;
 
+        /** Returns the time spent painting the widgets since the last call and resets it.
+
+            To be called by the render() that actually draws the frame. Renderers that defer the drawing, such as X11 which draws when the expose event is processed, thus get the paint time of all the paints merged into the frame. When no paint preceded the frame, such as when the renderer renders itself on blink changes, the duration is 0.
+         */
+        std::chrono::steady_clock::duration takePaintDuration() {
+            std::chrono::steady_clock::duration result = paintDuration_;
+            paintDuration_ = std::chrono::steady_clock::duration{0};
+            return result;
+        }
+
+        /** Reports the duration of the frame that has actually been drawn, including its paint time, to the frame scheduler.
+
+            To be called by the render() that actually draws the frame. The scheduler does not start the next frame sooner than this duration after the start of the last frame so that slow frames are not requested faster than they can be drawn.
+         */
+        void frameRendered(std::chrono::steady_clock::duration duration) {
+            std::lock_guard<std::mutex> g{frameGuard_};
+            lastFrameDuration_ = duration;
+        }
+
         /** Resizes the renderer. 
          
          */
@@ -208,14 +227,25 @@ namespace ui {
             return fps_; // only UI thread can change fps, no need to lock
         }
 
+        /** Sets the maximum frames per second. 
+         
+            If fps is 0, every repaint is rendered immediately. Otherwise the frame scheduler renders the repaints, at most fps times per second. 
+         */
         virtual void setFps(unsigned value) {
             if (fps_ == value)
                 return;
             if (fps_ == 0) {
+                // the previous scheduler thread must see fps 0 before the new value is set, otherwise it would never stop
+                if (frameScheduler_.joinable())
+                    frameScheduler_.join();
                 fps_ = value;
-                startFPSThread(); 
+                startFrameScheduler(); 
             } else {
-                fps_ = value;
+                {
+                    std::lock_guard<std::mutex> g{frameGuard_};
+                    fps_ = value;
+                }
+                frameCv_.notify_all();
             }
         }
 
@@ -231,30 +261,65 @@ namespace ui {
             return buffer_;
         }
 
+        /** Returns canvas of the entire paint buffer so that the renderer itself can paint over the widgets.
+         */
+        Canvas bufferCanvas() {
+            return Canvas{buffer_};
+        }
+
     private:
 
         /** Instructs the renderer to repaint given widget. 
          
             Depending on the current fps settings the method either immediately repaints the given widget and initiates the rendering, or schedules the widget for rendering at next redraw. If there is already a widget scheduled for rendering, the scheduled widget is updated to be the common parent of the already requested and the newly requested widget. 
+
+            The first repaint after user input is always rendered immediately so that the response to the input is not delayed by the frame scheduler. 
           */
         void paint(Widget * widget);
 
         /** Paints the scheduled widget on the renderer's buffer and calls the render() method immediately. 
          
-            This method is either called by the fps renderer thread (if fps != 0), or by the paint() method and is responsible for actually repainting the scheduled widget. 
+            This method is either scheduled by the frame scheduler (if fps != 0), or called by the paint() method and is responsible for actually repainting the scheduled widget. 
          */
         void paintAndRender();
 
-        /** Starts the FPS thread. 
+        /** Requests a frame from the frame scheduler. 
+         */
+        void requestFrame();
+
+        /** Allows the next repaint to be rendered immediately. 
+         
+            Called when user input is received. 
+         */
+        void inputReceived() {
+            immediateFrame_ = true;
+        }
+
+        /** Starts the frame scheduler thread. 
          
-            The thread periodically invokes the paintAndRender() method based on the fps value. If fps is 0, the thread is stopped. To start the thread, fps must be set to value > 0. 
+            The thread sleeps until a frame is requested and then schedules a paintAndRender() call in the UI thread. Frames are at least 1000 / fps milliseconds apart, or the duration of the last frame if larger, so that frames taking longer than the interval do not saturate the UI thread. All repaints requested before the frame is painted are coalesced into it. When no frames are requested, the thread does not wake up at all. If fps is 0, the thread is stopped. To start the thread, fps must be set to value > 0. 
          */
-        void startFPSThread();
+        void startFrameScheduler();
 
         Buffer buffer_;
         Widget * renderWidget_{nullptr};
         std::atomic<unsigned> fps_{0};
-        std::thread fpsThread_;
+        std::thread frameScheduler_;
+
+        /** Guard for the frame scheduler state (UI thread and the frame scheduler thread). */
+        std::mutex frameGuard_;
+        std::condition_variable frameCv_;
+        /** True if there is damage that has not been scheduled for painting yet. */
+        bool framePending_ = false;
+        /** True if paintAndRender() has been scheduled in the UI thread, but did not execute yet. */
+        bool frameScheduled_ = false;
+        /** Start of the last painted frame and duration of the last drawn frame, see frameRendered(). */
+        std::chrono::steady_clock::time_point lastFrameStart_;
+        std::chrono::steady_clock::duration lastFrameDuration_{0};
+        /** Time spent painting the widgets since the last rendered frame. UI thread only. */
+        std::chrono::steady_clock::duration paintDuration_{0};
+        /** True if the next repaint should be rendered immediately. UI thread only. */
+        bool immediateFrame_ = false;
 
     //@}
 
@@ -0,0 +1,186 @@
+#include "helpers/tests.h"
+
+#include "test_special_object.h"
+
+using namespace ui;
+
+namespace {
+
+    void SetRow(Canvas::Buffer & buffer, int row, std::string const & text) {
+        for (int col = 0; col < buffer.width(); ++col)
+            buffer.at(Point{col, row}).setCodepoint(static_cast<char32_t>(text[static_cast<size_t>(col)]));
+    }
+
+    std::string RowText(Canvas::Buffer const & buffer, int row) {
+        std::string result;
+        for (int col = 0; col < buffer.width(); ++col)
+            result.push_back(static_cast<char>(buffer.at(Point{col, row}).codepoint()));
+        return result;
+    }
+
+}
+
+TEST(canvas_buffer, insertCells) {
+    Canvas::Buffer buffer{Size{6, 2}};
+    SetRow(buffer, 0, "abcdef");
+    SetRow(buffer, 1, "ghijkl");
+    Canvas::Cell fill;
+    fill.setCodepoint('.').setFg(Color::Red);
+    buffer.insertCells(0, 1, 2, fill);
+    EXPECT_EQ(RowText(buffer, 0), "a..bcd");
+    EXPECT(buffer.at(Point{1, 0}).codepoint() == '.');
+    EXPECT(buffer.at(Point{1, 0}).fg() == Color::Red);
+    EXPECT(buffer.at(Point{3, 0}).fg() == Color::White);
+    // more cells than fit the row fill the rest of it
+    buffer.insertCells(0, 4, 10, fill);
+    EXPECT_EQ(RowText(buffer, 0), "a..b..");
+    buffer.insertCells(0, 6, 1, fill);
+    EXPECT_EQ(RowText(buffer, 0), "a..b..");
+    EXPECT_EQ(RowText(buffer, 1), "ghijkl");
+}
+
+TEST(canvas_buffer, deleteCells) {
+    Canvas::Buffer buffer{Size{6, 2}};
+    SetRow(buffer, 0, "abcdef");
+    SetRow(buffer, 1, "ghijkl");
+    Canvas::Cell fill;
+    fill.setCodepoint('.');
+    buffer.deleteCells(0, 1, 2, fill);
+    EXPECT_EQ(RowText(buffer, 0), "adef..");
+    buffer.deleteCells(0, 2, 10, fill);
+    EXPECT_EQ(RowText(buffer, 0), "ad....");
+    buffer.deleteCells(0, 0, 1, fill);
+    EXPECT_EQ(RowText(buffer, 0), "d.....");
+    EXPECT_EQ(RowText(buffer, 1), "ghijkl");
+}
+
+TEST(canvas_buffer, insertCellsSpecialObjects) {
+    bool deletedA = false;
+    bool deletedB = false;
+    TestSpecialObject * a = new TestSpecialObject{deletedA};
+    TestSpecialObject * b = new TestSpecialObject{deletedB};
+    Canvas::Buffer buffer{Size{6, 1}};
+    SetRow(buffer, 0, "abcdef");
+    buffer.attachSpecialObject(Point{1, 0}, a);
+    buffer.attachSpecialObject(Point{2, 0}, a);
+    buffer.attachSpecialObject(Point{5, 0}, b);
+    Canvas::Cell fill;
+    fill.setCodepoint('.');
+    // the shifted cells keep their objects, the discarded ones release theirs
+    buffer.insertCells(0, 0, 1, fill);
+    EXPECT_EQ(RowText(buffer, 0), ".abcde");
+    EXPECT(deletedB);
+    EXPECT(! buffer.at(Point{0, 0}).hasSpecialObject());
+    EXPECT(! buffer.at(Point{1, 0}).hasSpecialObject());
+    EXPECT(buffer.at(Point{2, 0}).specialObject() == a);
+    EXPECT(buffer.at(Point{3, 0}).specialObject() == a);
+    EXPECT(! buffer.at(Point{4, 0}).hasSpecialObject());
+    EXPECT(! buffer.at(Point{5, 0}).hasSpecialObject());
+    // the inserted cells reference the fill's object
+    bool deletedC = false;
+    fill.attachSpecialObject(new TestSpecialObject{deletedC});
+    buffer.insertCells(0, 1, 2, fill);
+    EXPECT_EQ(RowText(buffer, 0), "...abc");
+    EXPECT(buffer.at(Point{1, 0}).specialObject() == fill.specialObject());
+    EXPECT(buffer.at(Point{2, 0}).specialObject() == fill.specialObject());
+    EXPECT(! buffer.at(Point{3, 0}).hasSpecialObject());
+    EXPECT(buffer.at(Point{4, 0}).specialObject() == a);
+    EXPECT(buffer.at(Point{5, 0}).specialObject() == a);
+    fill.detachSpecialObject();
+    EXPECT(! deletedC);
+    EXPECT(! deletedA);
+    buffer.insertCells(0, 0, 6, Canvas::Cell{});
+    EXPECT(deletedC);
+    EXPECT(deletedA);
+}
+
+TEST(canvas_buffer, deleteCellsSpecialObjects) {
+    bool deletedA = false;
+    bool deletedB = false;
+    TestSpecialObject * a = new TestSpecialObject{deletedA};
+    TestSpecialObject * b = new TestSpecialObject{deletedB};
+    Canvas::Buffer buffer{Size{6, 1}};
+    SetRow(buffer, 0, "abcdef");
+    buffer.attachSpecialObject(Point{0, 0}, a);
+    buffer.attachSpecialObject(Point{3, 0}, a);
+    buffer.attachSpecialObject(Point{4, 0}, b);
+    Canvas::Cell fill;
+    fill.setCodepoint('.');
+    buffer.deleteCells(0, 0, 2, fill);
+    EXPECT_EQ(RowText(buffer, 0), "cdef..");
+    EXPECT(! deletedA);
+    EXPECT(buffer.at(Point{1, 0}).specialObject() == a);
+    EXPECT(buffer.at(Point{2, 0}).specialObject() == b);
+    // the vacated cells at the end of the row do not reference the moved objects
+    EXPECT(! buffer.at(Point{4, 0}).hasSpecialObject());
+    EXPECT(! buffer.at(Point{5, 0}).hasSpecialObject());
+    buffer.deleteCells(0, 1, 2, fill);
+    EXPECT_EQ(RowText(buffer, 0), "cf....");
+    EXPECT(deletedA);
+    EXPECT(deletedB);
+    for (int col = 0; col < 6; ++col)
+        EXPECT(! buffer.at(Point{col, 0}).hasSpecialObject());
+}
+
+TEST(canvas_buffer, borders) {
+    Canvas::Buffer buffer{Size{300, 2}};
+    // more distinct borders than fit the first chunk of the border table
+    for (int col = 0; col < buffer.width(); ++col)
+        buffer.at(Point{col, 0}).setBorder(Border::All(Color{static_cast<unsigned char>(col), static_cast<unsigned char>(col / 256), 7}, Border::Kind::Thin));
+    for (int col = 0; col < buffer.width(); ++col) {
+        Canvas::Cell c = buffer.at(Point{col, 0});
+        EXPECT(c.border() == Border::All(Color{static_cast<unsigned char>(col), static_cast<unsigned char>(col / 256), 7}, Border::Kind::Thin));
+        EXPECT(c.border().left() == Border::Kind::Thin);
+    }
+    EXPECT(buffer.at(Point{0, 1}).border() == Border{});
+    EXPECT(buffer.at(Point{0, 0}) != buffer.at(Point{1, 0}));
+    // the same border set on another cell is the same border
+    buffer.at(Point{1, 1}).setBorder(Border::All(Color{1, 0, 7}, Border::Kind::Thin));
+    EXPECT(buffer.at(Point{1, 1}) == buffer.at(Point{1, 0}));
+    buffer.at(Point{1, 1}).setBorder(Border{});
+    EXPECT(buffer.at(Point{1, 1}) == buffer.at(Point{0, 1}));
+}
+
+TEST(canvas_buffer, specialObjectRows) {
+    bool deletedA = false;
+    bool deletedB = false;
+    TestSpecialObject * a = new TestSpecialObject{deletedA};
+    Canvas::Buffer buffer{Size{4, 3}};
+    EXPECT(! buffer.hasSpecialObjects(0));
+    buffer.attachSpecialObject(Point{1, 1}, a);
+    EXPECT(! buffer.hasSpecialObjects(0));
+    EXPECT(buffer.hasSpecialObjects(1));
+    // partial fill keeps the flag, filling the whole row clears it
+    buffer.fillRow(1, Canvas::Cell{}, 2, 2);
+    EXPECT(buffer.hasSpecialObjects(1));
+    EXPECT(buffer.at(Point{1, 1}).specialObject() == a);
+    buffer.fillRow(1, Canvas::Cell{}, 0, 4);
+    EXPECT(! buffer.hasSpecialObjects(1));
+    EXPECT(deletedA);
+    // filling with a cell with special object sets the flag
+    Canvas::Cell fill;
+    fill.attachSpecialObject(new TestSpecialObject{deletedB});
+    buffer.fillRow(2, fill, 1, 1);
+    EXPECT(buffer.hasSpecialObjects(2));
+    fill.detachSpecialObject();
+    // copying the cells carries the flag to the other buffer, stripping the objects of the whole row clears it
+    Canvas::Buffer other{Size{4, 3}};
+    other.copyRow(0, 0, buffer, Point{0, 2}, 4);
+    EXPECT(other.hasSpecialObjects(0));
+    EXPECT(other.at(Point{1, 0}).hasSpecialObject());
+    other.copyRow(0, 0, buffer, Point{0, 2}, 4, true);
+    EXPECT(! other.hasSpecialObjects(0));
+    EXPECT(! other.at(Point{1, 0}).hasSpecialObject());
+    other.copyRow(1, 2, buffer, Point{0, 2}, 2);
+    EXPECT(other.hasSpecialObjects(1));
+    EXPECT(other.at(Point{3, 1}).hasSpecialObject());
+    // rows without special objects copy no flag
+    other.copyRow(1, 0, buffer, Point{0, 0}, 4);
+    EXPECT(! other.hasSpecialObjects(1));
+    EXPECT(! deletedB);
+    buffer.fill(Canvas::Cell{});
+    other.fill(Canvas::Cell{});
+    EXPECT(deletedB);
+    for (int row = 0; row < 3; ++row)
+        EXPECT(! buffer.hasSpecialObjects(row) && ! other.hasSpecialObjects(row));
+}
@@ -0,0 +1,74 @@
+#include "helpers/tests.h"
+
+#include "test_special_object.h"
+
+using namespace ui;
+
+TEST(canvas_special_objects, references) {
+    bool deleted = false;
+    TestSpecialObject * so = new TestSpecialObject{deleted};
+    {
+        Canvas::Cell a;
+        a.attachSpecialObject(so);
+        Canvas::Cell b{a};
+        Canvas::Cell c;
+        c = b;
+        EXPECT(a.specialObject() == so);
+        EXPECT(c.specialObject() == so);
+        a.detachSpecialObject();
+        b.stripSpecialObjectAndAssign(c);
+        EXPECT(! a.hasSpecialObject());
+        EXPECT(! b.hasSpecialObject());
+        EXPECT(c.specialObject() == so);
+        EXPECT(! deleted);
+    }
+    EXPECT(deleted);
+}
+
+TEST(canvas_special_objects, handlesReused) {
+    bool deleted = false;
+    Canvas::Cell cell;
+    for (int i = 0; i < 10000; ++i) {
+        cell.attachSpecialObject(new TestSpecialObject{deleted});
+        EXPECT(cell.hasSpecialObject());
+    }
+    cell.detachSpecialObject();
+    EXPECT(! cell.hasSpecialObject());
+    EXPECT(deleted);
+}
+
+TEST(canvas_special_objects, handleAndCodepoint) {
+    // the handles of these objects do not fit in a single byte
+    bool deleted = false;
+    std::vector<TestSpecialObject::Ptr> objects;
+    for (int i = 0; i < 300; ++i)
+        objects.push_back(TestSpecialObject::Ptr{new TestSpecialObject{deleted}});
+    Canvas::Cell cell;
+    cell.setCodepoint(0x10ffff);
+    cell.attachSpecialObject(objects.back());
+    EXPECT_EQ(static_cast<unsigned>(cell.codepoint()), 0x10ffffu);
+    EXPECT(cell.specialObject() == objects.back());
+    cell.setCodepoint('a');
+    EXPECT_EQ(static_cast<unsigned>(cell.codepoint()), static_cast<unsigned>('a'));
+    EXPECT(cell.specialObject() == objects.back());
+    EXPECT(cell != Canvas::Cell{}.setCodepoint('a'));
+    cell.detachSpecialObject();
+    EXPECT(cell == Canvas::Cell{}.setCodepoint('a'));
+}
+
+TEST(canvas_special_objects, manyLiveObjects) {
+    // more objects than would fit in a 16bit handle, such as the hyperlinks kept in the terminal history
+    bool deleted = false;
+    std::vector<TestSpecialObject::Ptr> objects;
+    std::vector<Canvas::Cell> cells(70000);
+    for (Canvas::Cell & cell : cells) {
+        objects.push_back(TestSpecialObject::Ptr{new TestSpecialObject{deleted}});
+        cell.attachSpecialObject(objects.back());
+    }
+    for (size_t i = 0; i < cells.size(); ++i)
+        EXPECT(cells[i].specialObject() == objects[i]);
+    EXPECT(! deleted);
+    objects.clear();
+    cells.clear();
+    EXPECT(deleted);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../canvas.h"
+
+namespace ui {
+
+    /** Special object that reports its deletion.
+     */
+    class TestSpecialObject : public Canvas::SpecialObject {
+    public:
+        using Ptr = Canvas::SpecialObject::Ptr<TestSpecialObject>;
+
+        explicit TestSpecialObject(bool & deleted):
+            deleted_{deleted} {
+        }
+
+        ~TestSpecialObject() override {
+            deleted_ = true;
+        }
+
+    private:
+        bool & deleted_;
+    }; // ui::TestSpecialObject
+
+} // namespace ui
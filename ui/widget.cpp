@@ -342,13 +342,17 @@ namespace ui {
         Canvas canvas{renderer_->buffer_, visibleArea_, size()};
         // paint the background first
         canvas.setBg(background_);
-        canvas.fill(canvas.rect());
+        paintBackground(canvas);
         // now paint whatever the widget contents is
         paint(canvas);
         // paint the border now that the widget has been painted
         canvas.setBorder(canvas.rect(), border());
     }
 
+    bool Widget::paintedDirectly() const {
+        return renderer_ != nullptr && renderer_->renderWidget_ == this;
+    }
+
     bool Widget::allowRepaintRequest(Widget * immediateChild) {
         // if there is already a repaint requested on the parent, the child's repaint can be ignored as it will be repainted when the parent does
         if (pendingRepaint_ == true) {
@@ -496,6 +496,12 @@ namespace ui {
             */        
         void paint();
 
+        /** Returns true if the widget is being painted directly by the renderer, and not as part of its parent. 
+
+            Any paint over the widget's area is always followed by painting the widget itself, either via its parent, or by the parent itself if the widget is overlaid. When painted directly, the renderer's buffer therefore still contains whatever the widget painted last time, so that the widget may only repaint the parts that have changed. 
+         */
+        bool paintedDirectly() const;
+
         /** Returns the attached renderer. 
          */
         Renderer * renderer() const {
@@ -510,6 +516,14 @@ namespace ui {
             */
         virtual bool allowRepaintRequest(Widget * immediateChild);
 
+        /** Paints the widget's background before its contents is painted. 
+         
+            The canvas' background color is set to the widget's background and the default implementation fills the whole widget with it. Widgets that paint all of their cells themselves can override the method to avoid the fill. 
+            */
+        virtual void paintBackground(Canvas & canvas) {
+            canvas.fill(canvas.rect());
+        }
+
         /** Actual paint method. 
          
             Override this method in subclasses to actually paint the widget's contents using the provided canvas. The default implementation simply paints the widget's children. 